@@ -58,6 +58,7 @@ int test_ether(void);
 int test_fbk_hash(void);
 int test_hash_crc(void);
 int test_hash(void);
+int test_histogram(void);
 int test_interrupts(void);
 int test_ip(void);
 int test_jhash(void);
@@ -54,6 +54,7 @@ static struct rte_hash_parameters ut_params = {
 	0, /* hash_func */
 	0, /* hash_func_init_val */
 	0, /* socket_id */
+	0, /* flags */
 };
 
 struct key {
@@ -125,15 +125,19 @@ tailq_to_str(const struct rte_tailq_head *tailq, char *buf, size_t len)
 }
 
 #define PREFIX    "prefix"
+#define MEMMAP    "memmap"
 static const char *directory = "/var/run";
 static const char *pre = "rte";
+static int memmap;
 
 static void
 usage(const char *prgname)
 {
-	printf("%s --prefix <prefix>\n\n"
+	printf("%s --prefix <prefix> [--memmap]\n\n"
 			"dump_config option list:\n"
-			"\t--"PREFIX": filename prefix\n",
+			"\t--"PREFIX": filename prefix\n"
+			"\t--"MEMMAP": only dump the memory map report (segments,\n"
+			"\t          zones and free fragments per socket)\n",
 			prgname);
 }
 
@@ -146,6 +150,7 @@ dmp_cfg_parse_args(int argc, char **argv)
 	int option_index;
 	static struct option lgopts[] = {
 			{PREFIX, 1, 0, 0},
+			{MEMMAP, 0, 0, 0},
 			{0, 0, 0, 0}
 	};
 
@@ -158,6 +163,8 @@ dmp_cfg_parse_args(int argc, char **argv)
 		case 0:
 			if (!strcmp(lgopts[option_index].name, PREFIX))
 				pre = optarg;
+			else if (!strcmp(lgopts[option_index].name, MEMMAP))
+				memmap = 1;
 			else{
 				usage(prgname);
 				return -1;
@@ -198,6 +205,13 @@ main(int argc, char **argv)
 	}
 	close(fd);
 
+	if (memmap) {
+		printf("-------------- MEMORY_MAP ---------------\n");
+		rte_memory_map_dump(cfg);
+		printf("------------ END_MEMORY_MAP -------------\n");
+		return 0;
+	}
+
 	printf("----------- MEMORY_SEGMENTS -------------\n");
 	for (i = 0; i < RTE_MAX_MEMSEG; i++){
 		if (cfg->memseg[i].addr == NULL) break;
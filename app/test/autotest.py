@@ -394,6 +394,7 @@ def logs_autotest(child, command, **kargs):
         "TESTAPP2: this is a info level message",
         "TESTAPP2: this is a warning level message",
         "TESTAPP1: this is a debug level message",
+        "TESTAPP1: this is an asynchronous message",
         ]
 
     for log_msg in log_list:
@@ -445,7 +446,7 @@ def timer_autotest(child, command, **kargs):
 
     while True:
         index = child.expect(["TESTTIMER: ([0-9]*): callback id=([0-9]*) count=([0-9]*) on core ([0-9]*)",
-                              "Test OK",
+                              "Start timer scaling benchmark",
                               "Test Failed",
                               pexpect.TIMEOUT], timeout = 10)
 
@@ -502,6 +503,13 @@ def timer_autotest(child, command, **kargs):
     if lcore_tim0 == lcore_tim3:
         return -1, "Failed: lcore_tim0 (%d) == lcore_tim3 (%d)"%(lcore_tim0, lcore_tim3)
 
+    # scaling benchmark, up to 1M timers
+    index = child.expect(["Test OK",
+                          "Test Failed",
+                          pexpect.TIMEOUT], timeout = 120)
+    if index != 0:
+        return -1, "Failed: timeout or error (4)"
+
     return 0, "Success"
 
 # Ring autotest
@@ -617,6 +625,7 @@ autotest.register("eal_report.rst", "EAL-%s"%(target),
                     SubTest("String Functions", default_autotest, "string_autotest"),
                     SubTest("Alarm", default_autotest, "alarm_autotest", 30),
                     SubTest("Interrupt", default_autotest, "interrupt_autotest"),
+                    SubTest("Service", default_autotest, "service_autotest"),
                     ])
 
 autotest.register("ring_report.rst", "Ring-%s"%(target),
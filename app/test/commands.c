@@ -146,6 +146,8 @@ static void cmd_autotest_parsed(void *parsed_result,
 		ret |= test_alarm();
 	if (all || !strcmp(res->autotest, "interrupt_autotest"))
 		ret |= test_interrupt();
+	if (all || !strcmp(res->autotest, "service_autotest"))
+		ret |= test_service();
 	if (all || !strcmp(res->autotest, "cycles_autotest"))
 		ret |= test_cycles();
 	if (all || !strcmp(res->autotest, "ring_autotest"))
@@ -178,7 +180,7 @@ cmdline_parse_token_string_t cmd_autotest_autotest =
 			"string_autotest#multiprocess_autotest#"
 			"cpuflags_autotest#eal_flags_autotest#"
 			"alarm_autotest#interrupt_autotest#"
-			"version_autotest#"
+			"version_autotest#service_autotest#"
 			"all_autotests");
 
 cmdline_parse_inst_t cmd_autotest = {
@@ -219,6 +221,8 @@ static void cmd_dump_parsed(void *parsed_result,
 		rte_dump_physmem_layout();
 	else if (!strcmp(res->dump, "dump_memzone"))
 		rte_memzone_dump();
+	else if (!strcmp(res->dump, "dump_memmap"))
+		rte_memory_map_dump(NULL);
 	else if (!strcmp(res->dump, "dump_log_history"))
 		rte_log_dump_history();
 	else if (!strcmp(res->dump, "dump_struct_sizes"))
@@ -231,7 +235,7 @@ static void cmd_dump_parsed(void *parsed_result,
 
 cmdline_parse_token_string_t cmd_dump_dump =
 	TOKEN_STRING_INITIALIZER(struct cmd_dump_result, dump,
-				 "dump_physmem#dump_memzone#dump_log_history#"
+				 "dump_physmem#dump_memzone#dump_memmap#dump_log_history#"
 				 "dump_struct_sizes#dump_ring#dump_mempool");
 
 cmdline_parse_inst_t cmd_dump = {
@@ -79,6 +79,8 @@ do_recursive_call(void)
 			{ "test_no_hpet_flag", no_action },
 			{ "test_invalid_b_flag", no_action },
 			{ "test_invalid_r_flag", no_action },
+			{ "test_socket_mem_flag", no_action },
+			{ "test_no_huge_flag", no_action },
 			{ "test_misc_flags", no_action },
 	};
 
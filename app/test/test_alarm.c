@@ -35,6 +35,9 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <errno.h>
 
 #include <cmdline_parse.h>
 
@@ -44,6 +47,8 @@
 #include <rte_common.h>
 #include <rte_atomic.h>
 #include <rte_alarm.h>
+#include <rte_lcore.h>
+#include <rte_random.h>
 
 #include "test.h"
 
@@ -52,6 +57,9 @@
 #define RTE_TEST_ALARM_TIMEOUT 3000 /* ms */
 #define RTE_TEST_CHECK_PERIOD  1000 /* ms */
 
+#define NS_PER_MS 1000000ULL
+#define NB_HANDLES 10000
+
 static volatile int flag;
 
 static void
@@ -100,8 +108,11 @@ static int
 test_multi_alarms(void)
 {
 	int rm_count = 0;
+	struct rte_eal_alarm_stats stats_before, stats_after;
 	cb_count.cnt = 0;
 
+	rte_eal_alarm_get_stats(&stats_before);
+
 	printf("Expect 6 callbacks in order...\n");
 	/* add two alarms in order */
 	rte_eal_alarm_set(1000 * US_PER_MS, test_multi_cb, (void *)1);
@@ -122,6 +133,14 @@ test_multi_alarms(void)
 		return -1;
 	}
 
+	/* check that the callbacks were accounted */
+	rte_eal_alarm_get_stats(&stats_after);
+	if (stats_after.lateness.count != stats_before.lateness.count + 6 ||
+	    stats_after.callback.count != stats_before.callback.count + 6) {
+		printf("Alarm callbacks not accounted in statistics\n");
+		return -1;
+	}
+
 	cb_count.cnt = 0;
 	printf("Expect only callbacks with args 1 and 3...\n");
 	/* Add 3 flags, then delete one */
@@ -202,6 +221,166 @@ test_multi_alarms(void)
 	return 0;
 }
 
+static uint64_t handle_last_expire;
+static int handle_order_err;
+
+/* check that the alarms expire in order */
+static void
+test_handle_cb(void *arg)
+{
+	struct rte_eal_alarm *alarm = arg;
+
+	if (alarm->expire < handle_last_expire)
+		handle_order_err = 1;
+	handle_last_expire = alarm->expire;
+	rte_atomic32_inc(&cb_count);
+}
+
+/* re-arm the alarm from its callback, 3 times */
+static void
+test_rearm_cb(void *arg)
+{
+	struct rte_eal_alarm *alarm = arg;
+
+	rte_atomic32_inc(&cb_count);
+	if (rte_atomic32_read(&cb_count) < 3)
+		rte_eal_alarm_arm(alarm, NS_PER_MS, (unsigned)LCORE_ID_ANY,
+				  test_rearm_cb, alarm);
+}
+
+/* free the alarm from its callback */
+static void
+test_free_cb(void *arg)
+{
+	free(arg);
+	rte_atomic32_inc(&cb_count);
+}
+
+static int
+test_alarm_handles(void)
+{
+	struct rte_eal_alarm *alarms, *freed;
+	struct rte_eal_alarm alarm;
+	uint64_t start, arm_cycles, disarm_cycles;
+	unsigned i, n;
+	int ret = -1;
+
+	alarms = malloc(NB_HANDLES * sizeof(*alarms));
+	if (alarms == NULL) {
+		printf("cannot allocate alarms\n");
+		return -1;
+	}
+
+	/* arm many alarms in random order, disarm half of them */
+	printf("Arm %u alarms and disarm half of them...\n", NB_HANDLES);
+	rte_atomic32_set(&cb_count, 0);
+	handle_last_expire = 0;
+	handle_order_err = 0;
+	start = rte_rdtsc();
+	for (i = 0; i < NB_HANDLES; i++) {
+		rte_eal_alarm_handle_init(&alarms[i]);
+		if (rte_eal_alarm_arm(&alarms[i],
+				      100 * NS_PER_MS + rte_rand() % (100 * NS_PER_MS),
+				      (unsigned)LCORE_ID_ANY, test_handle_cb,
+				      &alarms[i]) < 0) {
+			printf("cannot arm alarm %u\n", i);
+			goto end;
+		}
+	}
+	arm_cycles = rte_rdtsc() - start;
+	if (rte_eal_alarm_arm(&alarms[0], NS_PER_MS, (unsigned)LCORE_ID_ANY,
+			      test_handle_cb, &alarms[0]) != -EBUSY) {
+		printf("armed alarm armed again\n");
+		goto end;
+	}
+	start = rte_rdtsc();
+	for (i = 0; i < NB_HANDLES; i += 2) {
+		if (rte_eal_alarm_disarm(&alarms[i]) < 0) {
+			printf("cannot disarm alarm %u\n", i);
+			goto end;
+		}
+	}
+	disarm_cycles = rte_rdtsc() - start;
+	printf("arm: %"PRIu64" cycles, disarm: %"PRIu64" cycles\n",
+	       arm_cycles / NB_HANDLES, disarm_cycles / (NB_HANDLES / 2));
+
+	rte_delay_ms(400);
+	if (rte_atomic32_read(&cb_count) != NB_HANDLES / 2 ||
+	    handle_order_err) {
+		printf("%d callbacks called for %u alarms, order %s\n",
+		       rte_atomic32_read(&cb_count), NB_HANDLES / 2,
+		       handle_order_err ? "wrong" : "ok");
+		goto end;
+	}
+	if (rte_eal_alarm_disarm(&alarms[1]) != -ENOENT) {
+		printf("expired alarm disarmed\n");
+		goto end;
+	}
+
+	/* re-arm an alarm from its callback */
+	printf("Expect an alarm re-armed 3 times...\n");
+	rte_atomic32_set(&cb_count, 0);
+	rte_eal_alarm_handle_init(&alarm);
+	rte_eal_alarm_arm(&alarm, NS_PER_MS, (unsigned)LCORE_ID_ANY,
+			  test_rearm_cb, &alarm);
+	rte_delay_ms(100);
+	if (rte_atomic32_read(&cb_count) != 3) {
+		printf("alarm called %d times\n", rte_atomic32_read(&cb_count));
+		rte_eal_alarm_disarm(&alarm);
+		goto end;
+	}
+
+	/* free an alarm from its callback */
+	printf("Expect an alarm freed by its callback...\n");
+	rte_atomic32_set(&cb_count, 0);
+	freed = malloc(sizeof(*freed));
+	if (freed == NULL) {
+		printf("cannot allocate alarm\n");
+		goto end;
+	}
+	rte_eal_alarm_handle_init(freed);
+	rte_eal_alarm_arm(freed, NS_PER_MS, (unsigned)LCORE_ID_ANY,
+			  test_free_cb, freed);
+	rte_delay_ms(100);
+	if (rte_atomic32_read(&cb_count) != 1) {
+		printf("alarm called %d times\n", rte_atomic32_read(&cb_count));
+		if (rte_eal_alarm_disarm(freed) == 0)
+			free(freed);
+		goto end;
+	}
+
+	/* deliver an alarm to the current lcore */
+	printf("Expect an alarm run by lcore %u...\n", rte_lcore_id());
+	rte_atomic32_set(&cb_count, 0);
+	handle_last_expire = 0;
+	rte_eal_alarm_handle_init(&alarm);
+	rte_eal_alarm_arm(&alarm, 10 * NS_PER_MS, rte_lcore_id(),
+			  test_handle_cb, &alarm);
+	rte_delay_ms(100);
+	if (rte_atomic32_read(&cb_count) != 0 ||
+	    alarm.state != RTE_ALARM_QUEUED) {
+		printf("alarm not queued for the lcore\n");
+		rte_eal_alarm_disarm(&alarm);
+		goto end;
+	}
+	n = rte_eal_alarm_process();
+	if (n != 1 || rte_atomic32_read(&cb_count) != 1 ||
+	    rte_eal_alarm_process() != 0) {
+		printf("alarm not run by the lcore\n");
+		goto end;
+	}
+	ret = 0;
+
+end:
+	/* wait for the callbacks still running before freeing them */
+	for (i = 0; i < NB_HANDLES; i++) {
+		while (rte_eal_alarm_disarm(&alarms[i]) == -EINPROGRESS)
+			rte_delay_ms(1);
+	}
+	free(alarms);
+	return ret;
+}
+
 int
 test_alarm(void)
 {
@@ -253,6 +432,9 @@ test_alarm(void)
 	if (test_multi_alarms() != 0)
 		return -1;
 
+	if (test_alarm_handles() != 0)
+		return -1;
+
 	return 0;
 }
 
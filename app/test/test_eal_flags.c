@@ -209,6 +209,79 @@ test_no_hpet_flag(void)
 	return 0;
 }
 
+/*
+ * Test that the app doesn't run with invalid --socket-mem values, nor
+ * with both -m and --socket-mem.
+ */
+static int
+test_socket_mem_flag(void)
+{
+	/* no value */
+	const char *argv1[] = {prgname, mp_flag, "-c", "1", "--socket-mem="};
+	/* non numeric value */
+	const char *argv2[] = {prgname, mp_flag, "-c", "1", "--socket-mem=error"};
+	/* trailing comma */
+	const char *argv3[] = {prgname, mp_flag, "-c", "1", "--socket-mem=2,"};
+	/* invalid separator */
+	const char *argv4[] = {prgname, mp_flag, "-c", "1", "--socket-mem=2;2"};
+	/* no memory at all */
+	const char *argv5[] = {prgname, mp_flag, "-c", "1", "--socket-mem=0,0"};
+	/* both -m and --socket-mem */
+	const char *argv6[] = {prgname, mp_flag, "-c", "1", "-m", "2",
+			"--socket-mem=2"};
+	/* sanity check - valid value, ignored for secondary processes */
+	const char *argv7[] = {prgname, mp_flag, "-c", "1", "--socket-mem=2,0"};
+
+	if (launch_proc(argv1) == 0
+			|| launch_proc(argv2) == 0
+			|| launch_proc(argv3) == 0
+			|| launch_proc(argv4) == 0
+			|| launch_proc(argv5) == 0
+			|| launch_proc(argv6) == 0) {
+		printf("Error - process ran ok with invalid --socket-mem value\n");
+		return -1;
+	}
+	if (launch_proc(argv7) != 0) {
+		printf("Error - process did not run ok with valid --socket-mem value\n");
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Test that the app runs as a primary process without hugetlbfs,
+ * with the memory given by -m or by --socket-mem
+ */
+static int
+test_no_huge_flag(void)
+{
+	/* With -m */
+	const char *argv1[] = {prgname, no_huge, no_shconf, "-c", "1", "-n", "2",
+			"-m", "32"};
+	/* With --socket-mem */
+	const char *argv2[] = {prgname, no_huge, no_shconf, "-c", "1", "-n", "2",
+			"--socket-mem=32"};
+	/* With an amount of memory which is not a multiple of 2MB */
+	const char *argv3[] = {prgname, no_huge, no_shconf, "-c", "1", "-n", "2",
+			"-m", "3"};
+
+	if (launch_proc(argv1) != 0) {
+		printf("Error - process did not run ok with --no-huge and -m\n");
+		return -1;
+	}
+	if (launch_proc(argv2) != 0) {
+		printf("Error - process did not run ok with --no-huge and "
+				"--socket-mem\n");
+		return -1;
+	}
+	if (launch_proc(argv3) != 0) {
+		printf("Error - process did not run ok with --no-huge and "
+				"unaligned -m\n");
+		return -1;
+	}
+	return 0;
+}
+
 static int
 test_misc_flags(void)
 {
@@ -280,6 +353,18 @@ test_eal_flags(void)
 		return ret;
 	}
 
+	ret = test_socket_mem_flag();
+	if (ret < 0) {
+		printf("Error in test_socket_mem_flag()");
+		return ret;
+	}
+
+	ret = test_no_huge_flag();
+	if (ret < 0) {
+		printf("Error in test_no_huge_flag()");
+		return ret;
+	}
+
 	ret = test_misc_flags();
 	if (ret < 0) {
 		printf("Error in test_misc_flags()");
@@ -35,6 +35,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -52,6 +53,9 @@
 #include <rte_jhash.h>
 #include <rte_tailq.h>
 #include <rte_eal.h>
+#include <rte_launch.h>
+#include <rte_lcore.h>
+#include <rte_per_lcore.h>
 #include <rte_fbk_hash.h>
 #include <rte_ip.h>
 #include <rte_string_fns.h>
@@ -838,6 +842,834 @@ static int test_full_bucket(void)
 	return 0;
 }
 
+/*
+ * Cuckoo mode, with all keys sharing the same two buckets:
+ * 	- add 5 keys: OK, the 5th one goes to the alternative bucket
+ * 	- lookup the 5 keys: hit, at the positions returned when added
+ * 	- delete a key from the first bucket, lookup the others: hit
+ * 	- delete all keys, lookup: miss
+ */
+static int test_cuckoo_full_bucket(void)
+{
+	struct rte_hash_parameters params_pseudo_hash = {
+		.name = "test_cuckoo",
+		.entries = 64,
+		.bucket_entries = 4,
+		.key_len = sizeof(struct flow_key), /* 13 */
+		.hash_func = pseudo_hash,
+		.hash_func_init_val = 0,
+		.socket_id = 0,
+		.flags = HASH_F_CUCKOO,
+	};
+	struct rte_hash *handle;
+	int pos[5];
+	int expected_pos[5];
+	unsigned i;
+
+	handle = rte_hash_create(&params_pseudo_hash);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	for (i = 0; i < 5; i++) {
+		pos[i] = rte_hash_add_key(handle, &keys[i]);
+		print_key_info("Add", &keys[i], pos[i]);
+		RETURN_IF_ERROR(pos[i] < 0,
+			"failed to add key (pos[%u]=%d)", i, pos[i]);
+		expected_pos[i] = pos[i];
+	}
+
+	for (i = 0; i < 5; i++) {
+		pos[i] = rte_hash_lookup(handle, &keys[i]);
+		print_key_info("Lkp", &keys[i], pos[i]);
+		RETURN_IF_ERROR(pos[i] != expected_pos[i],
+			"failed to find key (pos[%u]=%d)", i, pos[i]);
+	}
+
+	pos[1] = rte_hash_del_key(handle, &keys[1]);
+	print_key_info("Del", &keys[1], pos[1]);
+	RETURN_IF_ERROR(pos[1] != expected_pos[1],
+			"failed to delete key (pos[1]=%d)", pos[1]);
+	for (i = 0; i < 5; i++) {
+		if (i == 1)
+			continue;
+		pos[i] = rte_hash_lookup(handle, &keys[i]);
+		print_key_info("Lkp", &keys[i], pos[i]);
+		RETURN_IF_ERROR(pos[i] != expected_pos[i],
+			"failed to find key (pos[%u]=%d)", i, pos[i]);
+	}
+
+	for (i = 0; i < 5; i++) {
+		if (i == 1)
+			continue;
+		pos[i] = rte_hash_del_key(handle, &keys[i]);
+		print_key_info("Del", &keys[i], pos[i]);
+		RETURN_IF_ERROR(pos[i] != expected_pos[i],
+			"failed to delete key (pos[%u]=%d)", i, pos[i]);
+	}
+	for (i = 0; i < 5; i++) {
+		pos[i] = rte_hash_lookup(handle, &keys[i]);
+		print_key_info("Lkp", &keys[i], pos[i]);
+		RETURN_IF_ERROR(pos[i] != -ENOENT,
+			"fail: found non-existent key (pos[%u]=%d)", i, pos[i]);
+	}
+
+	rte_hash_free(handle);
+	return 0;
+}
+
+#define CUCKOO_ENTRIES		(1 << 14)
+#define CUCKOO_MIN_LOAD		0.90
+
+static int32_t cuckoo_positions[CUCKOO_ENTRIES];
+
+/*
+ * Fill a cuckoo hash table until adding a key fails, and check that:
+ * 	- more than 90% of the entries were used
+ * 	- each key is found at the position returned when it was added, even
+ * 	  though keys were moved between buckets
+ * 	- deleted keys are not found, and can be added again
+ */
+static int test_cuckoo_load(void)
+{
+	struct rte_hash_parameters params = {
+		.name = "test_cuckoo_load",
+		.entries = CUCKOO_ENTRIES,
+		.bucket_entries = 4,
+		.key_len = sizeof(uint32_t),
+		.hash_func = rte_jhash,
+		.hash_func_init_val = 0,
+		.socket_id = 0,
+		.flags = HASH_F_CUCKOO,
+	};
+	struct rte_hash *handle;
+	uint32_t i, added;
+	int32_t pos;
+
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	for (added = 0; added < CUCKOO_ENTRIES; added++) {
+		pos = rte_hash_add_key(handle, &added);
+		if (pos == -ENOSPC)
+			break;
+		RETURN_IF_ERROR(pos < 0 || pos >= CUCKOO_ENTRIES,
+				"failed to add key %u (pos=%d)", added, pos);
+		cuckoo_positions[added] = pos;
+	}
+	printf("Cuckoo hash: %u keys added out of %u entries (%.1f%%)\n",
+	       added, CUCKOO_ENTRIES, 100.0 * added / CUCKOO_ENTRIES);
+	RETURN_IF_ERROR(added < CUCKOO_MIN_LOAD * CUCKOO_ENTRIES,
+			"only %u keys added", added);
+
+	for (i = 0; i < added; i++) {
+		pos = rte_hash_lookup(handle, &i);
+		RETURN_IF_ERROR(pos != cuckoo_positions[i],
+				"key %u found at %d instead of %d",
+				i, pos, cuckoo_positions[i]);
+	}
+
+	for (i = 0; i < added; i += 2) {
+		pos = rte_hash_del_key(handle, &i);
+		RETURN_IF_ERROR(pos != cuckoo_positions[i],
+				"failed to delete key %u (pos=%d)", i, pos);
+	}
+	for (i = 0; i < added; i++) {
+		pos = rte_hash_lookup(handle, &i);
+		RETURN_IF_ERROR(pos != ((i & 1) ? cuckoo_positions[i] : -ENOENT),
+				"wrong lookup result for key %u (pos=%d)",
+				i, pos);
+	}
+	for (i = 0; i < added; i += 2) {
+		pos = rte_hash_add_key(handle, &i);
+		RETURN_IF_ERROR(pos < 0, "failed to add key %u again (pos=%d)",
+				i, pos);
+	}
+
+	rte_hash_free(handle);
+	return 0;
+}
+
+/*
+ * Data stored with keys, in a table created with HASH_F_DATA and the given
+ * flags:
+ * 	- add 5 keys with data, lookup: hit, with the data
+ * 	- update the data of a key, add a key without data
+ * 	- multi lookup with data, including a missing key
+ * 	- delete a key, lookup: miss
+ */
+static int test_hash_data(uint32_t flags)
+{
+	struct rte_hash_parameters params = ut_params;
+	const void *key_ptrs[5];
+	void *data[5];
+	int32_t pos[5], expected_pos[5];
+	struct rte_hash *handle;
+	void *value;
+	unsigned i;
+
+	/* only tables created with HASH_F_DATA have room for data */
+	ut_params.name = "test_no_data";
+	handle = rte_hash_create(&ut_params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+	RETURN_IF_ERROR(rte_hash_add_key_data(handle, &keys[0], &keys[0]) !=
+			-EINVAL, "data added to a table without data");
+	rte_hash_free(handle);
+
+	params.name = "test_data";
+	params.flags = HASH_F_DATA | flags;
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	for (i = 0; i < 4; i++) {
+		pos[i] = rte_hash_add_key_data(handle, &keys[i], &keys[i]);
+		print_key_info("Add", &keys[i], pos[i]);
+		RETURN_IF_ERROR(pos[i] < 0,
+			"failed to add key (pos[%u]=%d)", i, pos[i]);
+		expected_pos[i] = pos[i];
+	}
+	for (i = 0; i < 4; i++) {
+		value = NULL;
+		pos[i] = rte_hash_lookup_data(handle, &keys[i], &value);
+		print_key_info("Lkp", &keys[i], pos[i]);
+		RETURN_IF_ERROR(pos[i] != expected_pos[i] || value != &keys[i],
+			"failed to find key with data (pos[%u]=%d)", i, pos[i]);
+	}
+
+	/* update keeps the position, plain add does not set data */
+	pos[0] = rte_hash_add_key_data(handle, &keys[0], &keys[4]);
+	RETURN_IF_ERROR(pos[0] != expected_pos[0],
+			"failed to update key (pos[0]=%d)", pos[0]);
+	pos[1] = rte_hash_add_key(handle, &keys[1]);
+	RETURN_IF_ERROR(pos[1] != expected_pos[1],
+			"failed to add existing key (pos[1]=%d)", pos[1]);
+	pos[3] = rte_hash_del_key(handle, &keys[3]);
+	RETURN_IF_ERROR(pos[3] != expected_pos[3],
+			"failed to delete key (pos[3]=%d)", pos[3]);
+	expected_pos[3] = rte_hash_add_key(handle, &keys[3]);
+	RETURN_IF_ERROR(expected_pos[3] < 0,
+			"failed to add key (pos[3]=%d)", expected_pos[3]);
+
+	for (i = 0; i < 5; i++)
+		key_ptrs[i] = &keys[i];
+	RETURN_IF_ERROR(rte_hash_lookup_multi_data(handle, key_ptrs, 5, pos,
+						   data) != 0,
+			"multi lookup failed");
+	RETURN_IF_ERROR(pos[0] != expected_pos[0] || data[0] != &keys[4],
+			"wrong data for updated key");
+	RETURN_IF_ERROR(pos[1] != expected_pos[1] || data[1] != &keys[1],
+			"data changed by adding an existing key");
+	RETURN_IF_ERROR(pos[2] != expected_pos[2] || data[2] != &keys[2],
+			"wrong data for key 2");
+	RETURN_IF_ERROR(pos[3] != expected_pos[3] || data[3] != NULL,
+			"key added without data has data");
+	RETURN_IF_ERROR(pos[4] != -ENOENT || data[4] != NULL,
+			"found non-existent key (pos[4]=%d)", pos[4]);
+
+	pos[2] = rte_hash_del_key(handle, &keys[2]);
+	RETURN_IF_ERROR(pos[2] != expected_pos[2],
+			"failed to delete key (pos[2]=%d)", pos[2]);
+	pos[2] = rte_hash_lookup_data(handle, &keys[2], &value);
+	RETURN_IF_ERROR(pos[2] != -ENOENT,
+			"fail: found key after deleting! (pos[2]=%d)", pos[2]);
+
+	rte_hash_free(handle);
+	return 0;
+}
+
+#define BULK_ENTRIES		(1 << 14)
+#define BULK_KEYS		(BULK_ENTRIES / 2)
+#define BULK_PERF_ROUNDS	100
+
+static int32_t bulk_positions[BULK_KEYS];
+
+/*
+ * Bulk lookups, in a half full table created with the given flags:
+ * 	- bursts of RTE_HASH_LOOKUP_BULK_MAX keys, half of them missing: the
+ * 	  hit mask, positions and data match single lookups
+ * 	- compare the cycles per key of single and bulk lookups
+ */
+static int test_hash_lookup_bulk(uint32_t flags)
+{
+	struct rte_hash_parameters params = {
+		.name = "test_bulk",
+		.entries = BULK_ENTRIES,
+		.bucket_entries = 4,
+		.key_len = sizeof(uint32_t),
+		.hash_func = rte_jhash,
+		.hash_func_init_val = 0,
+		.socket_id = 0,
+		.flags = HASH_F_DATA | flags,
+	};
+	uint32_t key_vals[RTE_HASH_LOOKUP_BULK_MAX];
+	const void *key_ptrs[RTE_HASH_LOOKUP_BULK_MAX];
+	int32_t pos[RTE_HASH_LOOKUP_BULK_MAX];
+	void *data[RTE_HASH_LOOKUP_BULK_MAX];
+	uint64_t hit_mask, expected_mask, start, single_cycles, bulk_cycles;
+	struct rte_hash *handle;
+	uint32_t i, j, key, round;
+	int hits, expected_hits;
+
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	/* keys that do not fit are expected to be missing */
+	for (i = 0; i < BULK_KEYS; i++)
+		bulk_positions[i] = rte_hash_add_key_data(handle, &i,
+					(void *)(uintptr_t)(i + 1));
+
+	for (i = 0; i < RTE_HASH_LOOKUP_BULK_MAX; i++)
+		key_ptrs[i] = &key_vals[i];
+
+	for (i = 0; i < 2 * BULK_KEYS; i += RTE_HASH_LOOKUP_BULK_MAX) {
+		expected_mask = 0;
+		for (j = 0; j < RTE_HASH_LOOKUP_BULK_MAX; j++) {
+			/* interleave existing and missing keys */
+			key = (j & 1) ? BULK_KEYS + i + j : (i + j) / 2;
+			key_vals[j] = key;
+			if (key < BULK_KEYS && bulk_positions[key] >= 0)
+				expected_mask |= 1ULL << j;
+		}
+		expected_hits = __builtin_popcountll(expected_mask);
+
+		hits = rte_hash_lookup_bulk(handle, key_ptrs,
+				RTE_HASH_LOOKUP_BULK_MAX, pos, &hit_mask);
+		RETURN_IF_ERROR(hits != expected_hits ||
+				hit_mask != expected_mask,
+				"wrong bulk lookup hits (%d, %#"PRIx64")",
+				hits, hit_mask);
+		for (j = 0; j < RTE_HASH_LOOKUP_BULK_MAX; j++) {
+			key = key_vals[j];
+			RETURN_IF_ERROR(pos[j] != ((hit_mask & (1ULL << j)) ?
+					bulk_positions[key] : -ENOENT),
+					"wrong position for key %u (pos=%d)",
+					key, pos[j]);
+		}
+
+		hits = rte_hash_lookup_bulk_data(handle, key_ptrs,
+				RTE_HASH_LOOKUP_BULK_MAX, &hit_mask, data);
+		RETURN_IF_ERROR(hits != expected_hits ||
+				hit_mask != expected_mask,
+				"wrong bulk lookup hits (%d, %#"PRIx64")",
+				hits, hit_mask);
+		for (j = 0; j < RTE_HASH_LOOKUP_BULK_MAX; j++) {
+			key = key_vals[j];
+			RETURN_IF_ERROR(data[j] != ((hit_mask & (1ULL << j)) ?
+					(void *)(uintptr_t)(key + 1) : NULL),
+					"wrong data for key %u", key);
+		}
+	}
+
+	/* Compare single and bulk lookups of all keys */
+	start = rte_rdtsc();
+	for (round = 0; round < BULK_PERF_ROUNDS; round++)
+		for (i = 0; i < BULK_KEYS; i++)
+			rte_hash_lookup(handle, &i);
+	single_cycles = rte_rdtsc() - start;
+
+	start = rte_rdtsc();
+	for (round = 0; round < BULK_PERF_ROUNDS; round++) {
+		for (i = 0; i < BULK_KEYS; i += RTE_HASH_LOOKUP_BULK_MAX) {
+			for (j = 0; j < RTE_HASH_LOOKUP_BULK_MAX; j++)
+				key_vals[j] = i + j;
+			rte_hash_lookup_bulk(handle, key_ptrs,
+					RTE_HASH_LOOKUP_BULK_MAX, pos,
+					&hit_mask);
+		}
+	}
+	bulk_cycles = rte_rdtsc() - start;
+
+	printf("Lookup cycles per key (flags=%#x): single %.1f, bulk %.1f\n",
+	       flags, (double)single_cycles / (BULK_PERF_ROUNDS * BULK_KEYS),
+	       (double)bulk_cycles / (BULK_PERF_ROUNDS * BULK_KEYS));
+
+	rte_hash_free(handle);
+	return 0;
+}
+
+#define WITH_HASH_KEYS		32
+
+/* Stands for a hash computed elsewhere, e.g. the RSS hash of the NIC. */
+static hash_sig_t
+test_external_hash(uint32_t key)
+{
+	return key * 0x9e3779b9;
+}
+
+/*
+ * Operations with precomputed signatures, in a table created with
+ * HASH_F_DATA and the given flags:
+ * 	- add keys with their signature and data, lookup: hit
+ * 	- bulk lookup with signatures, half of the keys missing
+ * 	- delete with signature, lookup: miss
+ * 	- a key added with the signature of rte_hash_hash() is found by
+ * 	  rte_hash_lookup()
+ */
+static int test_hash_with_hash(uint32_t flags)
+{
+	struct rte_hash_parameters params = {
+		.name = "test_with_hash",
+		.entries = 256,
+		.bucket_entries = 4,
+		.key_len = sizeof(uint32_t),
+		.hash_func = rte_jhash,
+		.hash_func_init_val = 0,
+		.socket_id = 0,
+		.flags = HASH_F_DATA | flags,
+	};
+	uint32_t key_vals[2 * WITH_HASH_KEYS];
+	const void *key_ptrs[2 * WITH_HASH_KEYS];
+	hash_sig_t sigs[2 * WITH_HASH_KEYS];
+	int32_t pos[2 * WITH_HASH_KEYS];
+	void *data[2 * WITH_HASH_KEYS];
+	int32_t expected_pos[WITH_HASH_KEYS];
+	struct rte_hash *handle;
+	uint64_t hit_mask;
+	void *value;
+	uint32_t i;
+	int32_t ret;
+
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	for (i = 0; i < 2 * WITH_HASH_KEYS; i++) {
+		key_vals[i] = i;
+		key_ptrs[i] = &key_vals[i];
+		sigs[i] = test_external_hash(i);
+	}
+
+	for (i = 0; i < WITH_HASH_KEYS; i++) {
+		expected_pos[i] = rte_hash_add_key_with_hash_data(handle,
+				&key_vals[i], sigs[i], (void *)(uintptr_t)(i + 1));
+		RETURN_IF_ERROR(expected_pos[i] < 0,
+				"failed to add key %u (pos=%d)",
+				i, expected_pos[i]);
+	}
+	for (i = 0; i < WITH_HASH_KEYS; i++) {
+		ret = rte_hash_lookup_with_hash(handle, &key_vals[i], sigs[i]);
+		RETURN_IF_ERROR(ret != expected_pos[i],
+				"failed to find key %u (pos=%d)", i, ret);
+		ret = rte_hash_lookup_with_hash_data(handle, &key_vals[i],
+						     sigs[i], &value);
+		RETURN_IF_ERROR(ret != expected_pos[i] ||
+				value != (void *)(uintptr_t)(i + 1),
+				"failed to find key %u with data", i);
+	}
+
+	ret = rte_hash_lookup_bulk_with_hash(handle, key_ptrs, sigs,
+			2 * WITH_HASH_KEYS, pos, &hit_mask);
+	RETURN_IF_ERROR(ret != WITH_HASH_KEYS ||
+			hit_mask != (1ULL << WITH_HASH_KEYS) - 1,
+			"wrong bulk lookup hits (%d)", ret);
+	for (i = 0; i < WITH_HASH_KEYS; i++)
+		RETURN_IF_ERROR(pos[i] != expected_pos[i],
+				"wrong position for key %u (pos=%d)",
+				i, pos[i]);
+	ret = rte_hash_lookup_bulk_with_hash_data(handle, key_ptrs, sigs,
+			2 * WITH_HASH_KEYS, &hit_mask, data);
+	RETURN_IF_ERROR(ret != WITH_HASH_KEYS ||
+			hit_mask != (1ULL << WITH_HASH_KEYS) - 1,
+			"wrong bulk lookup hits (%d)", ret);
+	for (i = 0; i < 2 * WITH_HASH_KEYS; i++)
+		RETURN_IF_ERROR(data[i] != ((i < WITH_HASH_KEYS) ?
+				(void *)(uintptr_t)(i + 1) : NULL),
+				"wrong data for key %u", i);
+
+	for (i = 0; i < WITH_HASH_KEYS; i++) {
+		ret = rte_hash_del_key_with_hash(handle, &key_vals[i], sigs[i]);
+		RETURN_IF_ERROR(ret != expected_pos[i],
+				"failed to delete key %u (pos=%d)", i, ret);
+		ret = rte_hash_lookup_with_hash(handle, &key_vals[i], sigs[i]);
+		RETURN_IF_ERROR(ret != -ENOENT,
+				"found key %u after deleting it (pos=%d)",
+				i, ret);
+	}
+
+	ret = rte_hash_add_key_with_hash(handle, &key_vals[0],
+			rte_hash_hash(handle, &key_vals[0]));
+	RETURN_IF_ERROR(ret < 0, "failed to add key (pos=%d)", ret);
+	RETURN_IF_ERROR(rte_hash_lookup(handle, &key_vals[0]) != ret,
+			"key added with rte_hash_hash() not found");
+
+	rte_hash_free(handle);
+	return 0;
+}
+
+#define RESIZE_INITIAL_ENTRIES	64
+#define RESIZE_KEYS		(1 << 16)
+#define RESIZE_ADD_TRIES	64
+/* keys added when walking the table, while the last growth is migrated */
+#define RESIZE_WALK_KEYS	(RESIZE_KEYS / 4 * 3 + 100)
+static uint8_t resize_seen[RESIZE_KEYS];
+
+/*
+ * Resizable table, starting with 64 entries:
+ * 	- resizing requires cuckoo mode and data
+ * 	- add 64K keys, retrying adds failing while keys are moved: all
+ * 	  added, and all found with their data, one by one and in bursts,
+ * 	  while the table grows
+ * 	- walk the table while keys are moved: each key is returned once
+ * 	- delete half of the keys, lookup: only the others are found
+ */
+static int test_hash_resize(void)
+{
+	struct rte_hash_parameters params = {
+		.name = "test_resize",
+		.entries = RESIZE_INITIAL_ENTRIES,
+		.bucket_entries = 4,
+		.key_len = sizeof(uint32_t),
+		.hash_func = rte_jhash,
+		.hash_func_init_val = 0,
+		.socket_id = 0,
+		.flags = HASH_F_RESIZE,
+	};
+	uint32_t key_vals[RTE_HASH_LOOKUP_BULK_MAX];
+	const void *key_ptrs[RTE_HASH_LOOKUP_BULK_MAX];
+	void *data[RTE_HASH_LOOKUP_BULK_MAX];
+	struct rte_hash *handle;
+	uint64_t hit_mask, start, cycles, max_cycles = 0;
+	uint32_t i, j, tries, nb_retries = 0, next, nb_keys;
+	const void *key;
+	int32_t ret;
+	void *value;
+
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle != NULL, "resizable table without cuckoo mode");
+
+	params.flags = HASH_F_RESIZE | HASH_F_CUCKOO | HASH_F_DATA;
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	for (i = 0; i < RESIZE_KEYS; i++) {
+		/* a full bucket while keys are moved fails the add, which
+		 * moves more of them: retry until enough room is left */
+		tries = 0;
+		do {
+			start = rte_rdtsc();
+			ret = rte_hash_add_key_data(handle, &i,
+						    (void *)(uintptr_t)(i + 1));
+			cycles = rte_rdtsc() - start;
+			if (cycles > max_cycles)
+				max_cycles = cycles;
+		} while (ret == -ENOSPC && ++tries < RESIZE_ADD_TRIES);
+		nb_retries += tries;
+		RETURN_IF_ERROR(ret < 0, "failed to add key %u (ret=%d)",
+				i, ret);
+
+		/* check a key added earlier, possibly moved since */
+		j = i / 2;
+		ret = rte_hash_lookup_data(handle, &j, &value);
+		RETURN_IF_ERROR(ret < 0 || value != (void *)(uintptr_t)(j + 1),
+				"failed to find key %u after adding %u", j, i);
+
+		if (i + 1 != RESIZE_WALK_KEYS)
+			continue;
+		memset(resize_seen, 0, sizeof(resize_seen));
+		next = 0;
+		nb_keys = 0;
+		while (rte_hash_iterate(handle, &key, &value, &next) >= 0) {
+			j = *(const uint32_t *)key;
+			RETURN_IF_ERROR(j > i || resize_seen[j] ||
+					value != (void *)(uintptr_t)(j + 1),
+					"unexpected key %u in walk", j);
+			resize_seen[j] = 1;
+			nb_keys++;
+		}
+		RETURN_IF_ERROR(nb_keys != RESIZE_WALK_KEYS,
+				"walk returned %u keys", nb_keys);
+	}
+	printf("Resizable hash: %u keys added, max %"PRIu64" cycles per add, "
+	       "%u retries\n", RESIZE_KEYS, max_cycles, nb_retries);
+
+	for (i = 0; i < RTE_HASH_LOOKUP_BULK_MAX; i++)
+		key_ptrs[i] = &key_vals[i];
+	for (i = 0; i < RESIZE_KEYS; i += RTE_HASH_LOOKUP_BULK_MAX) {
+		for (j = 0; j < RTE_HASH_LOOKUP_BULK_MAX; j++)
+			key_vals[j] = i + j;
+		ret = rte_hash_lookup_bulk_data(handle, key_ptrs,
+				RTE_HASH_LOOKUP_BULK_MAX, &hit_mask, data);
+		RETURN_IF_ERROR(ret != RTE_HASH_LOOKUP_BULK_MAX,
+				"bulk lookup from key %u found %d keys", i, ret);
+		for (j = 0; j < RTE_HASH_LOOKUP_BULK_MAX; j++)
+			RETURN_IF_ERROR(data[j] != (void *)(uintptr_t)(i + j + 1),
+					"wrong data for key %u", i + j);
+	}
+
+	for (i = 0; i < RESIZE_KEYS; i += 2) {
+		ret = rte_hash_del_key(handle, &i);
+		RETURN_IF_ERROR(ret < 0, "failed to delete key %u (ret=%d)",
+				i, ret);
+	}
+	for (i = 0; i < RESIZE_KEYS; i++) {
+		ret = rte_hash_lookup_data(handle, &i, &value);
+		if (i & 1)
+			RETURN_IF_ERROR(ret < 0 ||
+					value != (void *)(uintptr_t)(i + 1),
+					"failed to find key %u", i);
+		else
+			RETURN_IF_ERROR(ret != -ENOENT,
+					"found deleted key %u (ret=%d)", i, ret);
+	}
+
+	rte_hash_free(handle);
+	return 0;
+}
+
+#define ITERATE_ENTRIES		4096
+#define ITERATE_KEYS		600
+static uint8_t iterate_seen[ITERATE_KEYS];
+
+/* Hash function other than rte_jhash, with the same init value. */
+static uint32_t
+iterate_other_hash(const void *key, uint32_t key_len, uint32_t init_val)
+{
+	return ~rte_jhash(key, key_len, init_val);
+}
+
+/*
+ * Walk and serialize a table:
+ * 	- add keys, walk the table and delete every other key returned, as
+ * 	  when aging flows: each key is returned once, at its position
+ * 	- walk again: only the keys left are returned
+ * 	- serialize the table and restore it in a new one, with the same hash
+ * 	  function and with another one: only the keys left are found, with
+ * 	  their data
+ */
+static int test_hash_iterate(uint32_t flags)
+{
+	struct rte_hash_parameters params = {
+		.name = "test_iterate",
+		.entries = ITERATE_ENTRIES,
+		.bucket_entries = 8,
+		.key_len = sizeof(uint32_t),
+		.hash_func = rte_jhash,
+		.hash_func_init_val = 0,
+		.socket_id = 0,
+		.flags = flags,
+	};
+	struct rte_hash *handle;
+	const void *key;
+	void *data, *value, *buf;
+	uint32_t i, k, f, next, nb_keys;
+	int32_t pos, ret;
+	ssize_t written;
+	size_t size;
+
+	/* let a resizable table grow from its smallest size */
+	if (flags & HASH_F_RESIZE)
+		params.entries = 64;
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	for (i = 0; i < ITERATE_KEYS; i++) {
+		if (flags & HASH_F_DATA)
+			ret = rte_hash_add_key_data(handle, &i,
+						    (void *)(uintptr_t)(i + 1));
+		else
+			ret = rte_hash_add_key(handle, &i);
+		RETURN_IF_ERROR(ret < 0, "failed to add key %u (ret=%d)",
+				i, ret);
+	}
+
+	memset(iterate_seen, 0, sizeof(iterate_seen));
+	next = 0;
+	nb_keys = 0;
+	while ((pos = rte_hash_iterate(handle, &key, &data, &next)) >= 0) {
+		k = *(const uint32_t *)key;
+		RETURN_IF_ERROR(k >= ITERATE_KEYS || iterate_seen[k] != 0,
+				"unexpected key %u in walk", k);
+		iterate_seen[k] = 1;
+		RETURN_IF_ERROR(pos != rte_hash_lookup(handle, &k),
+				"wrong position %d for key %u", pos, k);
+		RETURN_IF_ERROR(data != ((flags & HASH_F_DATA) ?
+					 (void *)(uintptr_t)(k + 1) : NULL),
+				"wrong data for key %u", k);
+		if ((nb_keys++ & 1) == 0) {
+			ret = rte_hash_del_key(handle, &k);
+			RETURN_IF_ERROR(ret < 0, "failed to delete key %u", k);
+			iterate_seen[k] = 2;
+		}
+	}
+	RETURN_IF_ERROR(pos != -ENOENT || nb_keys != ITERATE_KEYS,
+			"walk returned %u keys (ret=%d)", nb_keys, pos);
+
+	next = 0;
+	nb_keys = 0;
+	while (rte_hash_iterate(handle, &key, NULL, &next) >= 0) {
+		k = *(const uint32_t *)key;
+		RETURN_IF_ERROR(k >= ITERATE_KEYS || iterate_seen[k] != 1,
+				"unexpected key %u in second walk", k);
+		nb_keys++;
+	}
+	RETURN_IF_ERROR(nb_keys != ITERATE_KEYS / 2,
+			"second walk returned %u keys", nb_keys);
+
+	size = rte_hash_serialize_size(handle);
+	buf = rte_malloc(NULL, size, 0);
+	RETURN_IF_ERROR(buf == NULL, "failed to allocate %zu bytes", size);
+	written = rte_hash_serialize(handle, buf, size - 1);
+	RETURN_IF_ERROR(written != -ENOSPC, "serialized to a short buffer");
+	written = rte_hash_serialize(handle, buf, size);
+	RETURN_IF_ERROR(written != (ssize_t)size, "serialize failed (ret=%zd)",
+			written);
+	rte_hash_free(handle);
+
+	/* signatures are only reused with the same hash function */
+	for (f = 0; f < 2; f++) {
+		params.name = "test_iterate_restored";
+		params.hash_func = (f == 0) ? rte_jhash : iterate_other_hash;
+		handle = rte_hash_create(&params);
+		RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+		ret = rte_hash_deserialize(handle, buf, size - 1);
+		RETURN_IF_ERROR(ret != -EINVAL,
+				"restored from a truncated buffer");
+		ret = rte_hash_deserialize(handle, buf, size);
+		RETURN_IF_ERROR(ret != ITERATE_KEYS / 2,
+				"deserialize failed (ret=%d)", ret);
+
+		for (i = 0; i < ITERATE_KEYS; i++) {
+			if (flags & HASH_F_DATA)
+				ret = rte_hash_lookup_data(handle, &i, &value);
+			else
+				ret = rte_hash_lookup(handle, &i);
+			if (iterate_seen[i] == 1) {
+				RETURN_IF_ERROR(ret < 0,
+						"key %u not restored (hash %u)",
+						i, f);
+				RETURN_IF_ERROR((flags & HASH_F_DATA) &&
+					value != (void *)(uintptr_t)(i + 1),
+					"wrong data restored for key %u", i);
+			} else
+				RETURN_IF_ERROR(ret != -ENOENT,
+						"deleted key %u restored", i);
+		}
+		rte_hash_free(handle);
+	}
+
+	rte_free(buf);
+	return 0;
+}
+
+#define MULTI_READER_ENTRIES	(1 << 12)
+#define MULTI_READER_STABLE	1024	/* keys never deleted */
+#define MULTI_READER_TRANSIENT	2600	/* keys added and deleted in loop */
+#define MULTI_READER_ROUNDS	50
+
+static struct rte_hash *multi_reader_handle;
+static int32_t multi_reader_pos[MULTI_READER_STABLE];
+static volatile int multi_reader_stop;
+static uint64_t multi_reader_lookups[RTE_MAX_LCORE];
+static uint64_t multi_reader_errors[RTE_MAX_LCORE];
+
+/* Look up the stable keys until told to stop, and count wrong results. */
+static int
+multi_reader_loop(__attribute__((unused)) void *arg)
+{
+	unsigned lcore_id = rte_lcore_id();
+	const void *key_ptrs[RTE_HASH_LOOKUP_MULTI_MAX];
+	uint32_t key_vals[RTE_HASH_LOOKUP_MULTI_MAX];
+	int32_t pos[RTE_HASH_LOOKUP_MULTI_MAX];
+	uint32_t i, j;
+
+	for (i = 0; i < RTE_HASH_LOOKUP_MULTI_MAX; i++)
+		key_ptrs[i] = &key_vals[i];
+
+	while (!multi_reader_stop) {
+		for (i = 0; i < MULTI_READER_STABLE;
+		     i += RTE_HASH_LOOKUP_MULTI_MAX) {
+			for (j = 0; j < RTE_HASH_LOOKUP_MULTI_MAX; j++)
+				key_vals[j] = i + j;
+			rte_hash_lookup_multi(multi_reader_handle, key_ptrs,
+					      RTE_HASH_LOOKUP_MULTI_MAX, pos);
+			for (j = 0; j < RTE_HASH_LOOKUP_MULTI_MAX; j++)
+				if (pos[j] != multi_reader_pos[i + j])
+					multi_reader_errors[lcore_id]++;
+			if (rte_hash_lookup(multi_reader_handle, &i) !=
+					multi_reader_pos[i])
+				multi_reader_errors[lcore_id]++;
+			multi_reader_lookups[lcore_id] +=
+				RTE_HASH_LOOKUP_MULTI_MAX + 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Lookups from all slave lcores, while the master lcore adds and deletes
+ * keys in a table that is almost full:
+ * 	- keys that are never deleted are always found, at their position
+ * 	- keys that were never added are never found
+ */
+static int test_hash_multi_reader(uint32_t flags)
+{
+	struct rte_hash_parameters params = {
+		.name = "test_multi_reader",
+		.entries = MULTI_READER_ENTRIES,
+		.bucket_entries = 4,
+		.key_len = sizeof(uint32_t),
+		.hash_func = rte_jhash,
+		.hash_func_init_val = 0,
+		.socket_id = 0,
+		.flags = flags,
+	};
+	struct rte_hash *handle;
+	uint64_t lookups = 0, errors = 0;
+	unsigned lcore_id;
+	uint32_t i, key, round;
+	int32_t pos;
+
+	if (rte_lcore_count() < 2) {
+		printf("Multi-reader hash test needs at least 2 lcores, "
+		       "skipped\n");
+		return 0;
+	}
+
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+	multi_reader_handle = handle;
+
+	/* stable keys that do not fit are expected to be missing */
+	for (i = 0; i < MULTI_READER_STABLE; i++) {
+		pos = rte_hash_add_key(handle, &i);
+		multi_reader_pos[i] = (pos < 0) ? -ENOENT : pos;
+	}
+
+	multi_reader_stop = 0;
+	memset(multi_reader_lookups, 0, sizeof(multi_reader_lookups));
+	memset(multi_reader_errors, 0, sizeof(multi_reader_errors));
+	rte_eal_mp_remote_launch(multi_reader_loop, NULL, SKIP_MASTER);
+
+	for (round = 0; round < MULTI_READER_ROUNDS; round++) {
+		for (i = 0; i < MULTI_READER_TRANSIENT; i++) {
+			key = MULTI_READER_STABLE + round + i;
+			rte_hash_add_key(handle, &key);
+		}
+		for (i = 0; i < MULTI_READER_TRANSIENT; i++) {
+			key = MULTI_READER_STABLE + round + i;
+			rte_hash_del_key(handle, &key);
+		}
+	}
+
+	multi_reader_stop = 1;
+	rte_eal_mp_wait_lcore();
+
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		lookups += multi_reader_lookups[lcore_id];
+		errors += multi_reader_errors[lcore_id];
+	}
+	printf("Multi-reader hash test (flags=%#x): %"PRIu64" lookups, "
+	       "%"PRIu64" errors\n", flags, lookups, errors);
+	RETURN_IF_ERROR(errors != 0, "%"PRIu64" wrong lookup results", errors);
+
+	for (i = 0; i < MULTI_READER_STABLE; i++) {
+		pos = rte_hash_lookup(handle, &i);
+		RETURN_IF_ERROR(pos != multi_reader_pos[i],
+				"key %u found at %d instead of %d",
+				i, pos, multi_reader_pos[i]);
+	}
+
+	rte_hash_free(handle);
+	return 0;
+}
+
 /*
  * To help print out name of hash functions.
  */
@@ -1313,6 +2145,91 @@ fbk_hash_unit_test(void)
 	return 0;
 }
 
+/*
+ * Walk and serialize a four-byte key table:
+ * 	- add keys, walk the table and delete every other key returned, as
+ * 	  when aging flows: each key is returned once, with its value
+ * 	- serialize the table and restore it in a smaller one: only the keys
+ * 	  left are found, with their value
+ */
+static int
+fbk_hash_iterate_test(void)
+{
+	struct rte_fbk_hash_params params = {
+		.name = "fbk_hash_iterate",
+		.entries = LOCAL_FBK_HASH_ENTRIES_MAX,
+		.entries_per_bucket = 4,
+		.socket_id = 0,
+	};
+	struct rte_fbk_hash_table *handle;
+	uint32_t i, key, next, nb_keys;
+	uint16_t value;
+	void *buf;
+	ssize_t written;
+	size_t size;
+	int status;
+
+	handle = rte_fbk_hash_create(&params);
+	RETURN_IF_ERROR_FBK(handle == NULL, "fbk hash creation failed");
+
+	for (i = 0; i < ITERATE_KEYS; i++) {
+		status = rte_fbk_hash_add_key(handle, i * 7 + 1, (uint16_t)i);
+		RETURN_IF_ERROR_FBK(status != 0, "fbk hash add failed");
+	}
+
+	memset(iterate_seen, 0, sizeof(iterate_seen));
+	next = 0;
+	nb_keys = 0;
+	while (rte_fbk_hash_iterate(handle, &key, &value, &next) == 0) {
+		i = value;
+		RETURN_IF_ERROR_FBK(i >= ITERATE_KEYS || key != i * 7 + 1 ||
+				    iterate_seen[i] != 0,
+				    "unexpected entry in fbk hash walk");
+		iterate_seen[i] = 1;
+		if ((nb_keys++ & 1) == 0) {
+			status = rte_fbk_hash_delete_key(handle, key);
+			RETURN_IF_ERROR_FBK(status != 0,
+					    "fbk hash delete failed");
+			iterate_seen[i] = 2;
+		}
+	}
+	RETURN_IF_ERROR_FBK(nb_keys != ITERATE_KEYS,
+			    "fbk hash walk missed entries");
+
+	size = rte_fbk_hash_serialize_size(handle);
+	buf = rte_malloc(NULL, size, 0);
+	RETURN_IF_ERROR_FBK(buf == NULL, "fbk hash buffer allocation failed");
+	written = rte_fbk_hash_serialize(handle, buf, size - 1);
+	RETURN_IF_ERROR_FBK(written != -ENOSPC,
+			    "fbk hash serialized to a short buffer");
+	written = rte_fbk_hash_serialize(handle, buf, size);
+	RETURN_IF_ERROR_FBK(written != (ssize_t)size,
+			    "fbk hash serialize failed");
+	rte_fbk_hash_free(handle);
+
+	params.name = "fbk_hash_restored";
+	params.entries = LOCAL_FBK_HASH_ENTRIES_MAX / 4;
+	handle = rte_fbk_hash_create(&params);
+	RETURN_IF_ERROR_FBK(handle == NULL, "fbk hash creation failed");
+	status = rte_fbk_hash_deserialize(handle, buf, size);
+	RETURN_IF_ERROR_FBK(status != ITERATE_KEYS / 2,
+			    "fbk hash deserialize failed");
+	rte_free(buf);
+
+	for (i = 0; i < ITERATE_KEYS; i++) {
+		status = rte_fbk_hash_lookup(handle, i * 7 + 1);
+		if (iterate_seen[i] == 1)
+			RETURN_IF_ERROR_FBK(status != (int)i,
+					    "fbk hash entry not restored");
+		else
+			RETURN_IF_ERROR_FBK(status != -ENOENT,
+					    "deleted fbk hash entry restored");
+	}
+
+	rte_fbk_hash_free(handle);
+	return 0;
+}
+
 /* Control operation of performance testing of fbk hash. */
 #define LOAD_FACTOR 0.667	/* How full to make the hash table. */
 #define TEST_SIZE 1000000	/* How many operations to time. */
@@ -1759,6 +2676,34 @@ int test_hash(void)
 		return -1;
 	if (test_full_bucket() < 0)
 		return -1;
+	if (test_cuckoo_full_bucket() < 0)
+		return -1;
+	if (test_cuckoo_load() < 0)
+		return -1;
+	if (test_hash_data(0) < 0)
+		return -1;
+	if (test_hash_data(HASH_F_CUCKOO) < 0)
+		return -1;
+	if (test_hash_lookup_bulk(0) < 0)
+		return -1;
+	if (test_hash_lookup_bulk(HASH_F_CUCKOO) < 0)
+		return -1;
+	if (test_hash_with_hash(0) < 0)
+		return -1;
+	if (test_hash_with_hash(HASH_F_CUCKOO) < 0)
+		return -1;
+	if (test_hash_resize() < 0)
+		return -1;
+	if (test_hash_iterate(0) < 0)
+		return -1;
+	if (test_hash_iterate(HASH_F_CUCKOO | HASH_F_DATA) < 0)
+		return -1;
+	if (test_hash_iterate(HASH_F_RESIZE | HASH_F_CUCKOO | HASH_F_DATA) < 0)
+		return -1;
+	if (test_hash_multi_reader(0) < 0)
+		return -1;
+	if (test_hash_multi_reader(HASH_F_CUCKOO) < 0)
+		return -1;
 	if (run_all_tbl_perf_tests() < 0)
 		return -1;
 	run_hash_func_tests();
@@ -1767,6 +2712,8 @@ int test_hash(void)
 		return -1;
 	if (fbk_hash_unit_test() < 0)
 		return -1;
+	if (fbk_hash_iterate_test() < 0)
+		return -1;
 	if (fbk_hash_perf_test() < 0)
 		return -1;
 	if (test_hash_creation_with_bad_parameters() < 0)
@@ -36,6 +36,7 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <unistd.h>
+#include <sys/epoll.h>
 
 #include <cmdline_parse.h>
 
@@ -279,6 +280,145 @@ test_interrupt_disable(void)
 	return 0;
 }
 
+static int
+test_interrupt_wait(void)
+{
+	struct rte_intr_handle test_intr_handle;
+#ifdef RTE_EXEC_ENV_LINUXAPP
+	union intr_pipefds wait_pfds;
+	const uint32_t count = 1;
+	int ret;
+#endif
+
+	/* check with null intr_handle */
+	if (rte_intr_wait(NULL, 0) >= 0) {
+		printf("unexpectedly wait on null intr_handle successfully\n");
+		return -1;
+	}
+
+	/* check with invalid intr_handle */
+	test_intr_handle = intr_handles[TEST_INTERRUPT_HANDLE_INVALID];
+	if (rte_intr_wait(&test_intr_handle, 0) >= 0) {
+		printf("unexpectedly wait on invalid intr_handle "
+			"successfully\n");
+		return -1;
+	}
+
+	/* check with specific valid intr_handle */
+	test_intr_handle = intr_handles[TEST_INTERRUPT_HANDLE_CASE1];
+	if (rte_intr_wait(&test_intr_handle, 0) >= 0) {
+		printf("unexpectedly wait on a specific intr_handle "
+			"successfully\n");
+		return -1;
+	}
+
+#ifdef RTE_EXEC_ENV_LINUXAPP
+	/* a pipe stands for the uio device: it returns 4 bytes per event */
+	if (pipe(wait_pfds.pipefd) < 0)
+		return -1;
+	test_intr_handle.fd = wait_pfds.readfd;
+	test_intr_handle.type = RTE_INTR_HANDLE_UIO;
+
+	ret = -1;
+	if (rte_intr_wait(&test_intr_handle, 10) != 0) {
+		printf("wait did not time out without interrupt\n");
+		goto out;
+	}
+	if (write(wait_pfds.writefd, &count, sizeof(count)) < 0)
+		goto out;
+	if (rte_intr_wait(&test_intr_handle, 1000) != 1) {
+		printf("wait did not return the interrupt\n");
+		goto out;
+	}
+	if (rte_intr_wait(&test_intr_handle, 10) != 0) {
+		printf("interrupt was not cleared by wait\n");
+		goto out;
+	}
+	ret = 0;
+out:
+	close(wait_pfds.pipefd[0]);
+	close(wait_pfds.pipefd[1]);
+	return ret;
+#else
+	return 0;
+#endif
+}
+
+static int
+test_interrupt_wait_epoll(void)
+{
+#ifdef RTE_EXEC_ENV_LINUXAPP
+	struct rte_intr_handle test_intr_handle;
+	union intr_pipefds wait_pfds[2];
+	const uint32_t count = 1;
+	int i, epfd, ret = -1;
+
+	/* check with invalid epoll set and intr_handle */
+	test_intr_handle = intr_handles[TEST_INTERRUPT_HANDLE_CASE1];
+	if (rte_intr_wait_add(-1, &test_intr_handle) >= 0) {
+		printf("unexpectedly added to an invalid epoll set\n");
+		return -1;
+	}
+
+	epfd = epoll_create(1);
+	if (epfd < 0)
+		return -1;
+	if (rte_intr_wait_add(epfd, NULL) >= 0 ||
+	    rte_intr_wait_add(epfd, &test_intr_handle) >= 0) {
+		printf("unexpectedly added an invalid intr_handle\n");
+		close(epfd);
+		return -1;
+	}
+
+	/* two pipes stand for the uio devices of two ports */
+	if (pipe(wait_pfds[0].pipefd) < 0) {
+		close(epfd);
+		return -1;
+	}
+	if (pipe(wait_pfds[1].pipefd) < 0) {
+		close(wait_pfds[0].pipefd[0]);
+		close(wait_pfds[0].pipefd[1]);
+		close(epfd);
+		return -1;
+	}
+	test_intr_handle.type = RTE_INTR_HANDLE_UIO;
+	for (i = 0; i < 2; i++) {
+		test_intr_handle.fd = wait_pfds[i].readfd;
+		if (rte_intr_wait_add(epfd, &test_intr_handle) < 0 ||
+		    rte_intr_wait_add(epfd, &test_intr_handle) < 0) {
+			printf("cannot add intr_handle to epoll set\n");
+			goto out;
+		}
+	}
+
+	if (rte_intr_wait_epoll(epfd, 10) != 0) {
+		printf("epoll wait did not time out without interrupt\n");
+		goto out;
+	}
+	/* the interrupt of the second handle wakes the waiter up */
+	if (write(wait_pfds[1].writefd, &count, sizeof(count)) < 0)
+		goto out;
+	if (rte_intr_wait_epoll(epfd, 1000) != 1) {
+		printf("epoll wait did not return the interrupt\n");
+		goto out;
+	}
+	if (rte_intr_wait_epoll(epfd, 10) != 0) {
+		printf("interrupt was not cleared by epoll wait\n");
+		goto out;
+	}
+	ret = 0;
+out:
+	for (i = 0; i < 2; i++) {
+		close(wait_pfds[i].pipefd[0]);
+		close(wait_pfds[i].pipefd[1]);
+	}
+	close(epfd);
+	return ret;
+#else
+	return 0;
+#endif
+}
+
 int
 test_interrupt(void)
 {
@@ -400,6 +540,14 @@ test_interrupt(void)
 		goto out;
 	rte_delay_ms(1000);
 
+	printf("start interrupt wait test\n");
+
+	if (test_interrupt_wait() < 0)
+		goto out;
+
+	if (test_interrupt_wait_epoll() < 0)
+		goto out;
+
 	ret = 0;
 
 out:
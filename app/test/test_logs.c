@@ -36,6 +36,8 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdarg.h>
+#include <errno.h>
+#include <inttypes.h>
 #include <sys/queue.h>
 
 #include <cmdline_parse.h>
@@ -54,6 +56,9 @@
 #define RTE_LOGTYPE_TESTAPP1 RTE_LOGTYPE_USER1
 #define RTE_LOGTYPE_TESTAPP2 RTE_LOGTYPE_USER2
 
+#define TEST_LOG_ASYNC_RING_SIZE 16
+#define TEST_LOG_ASYNC_MSGS      64
+
 /*
  * Logs
  * ====
@@ -61,8 +66,132 @@
  * - Enable log types.
  * - Set log level.
  * - Send logs with different types and levels, some should not be displayed.
+ * - Set the levels of log types, globally and on one lcore, and check the
+ *   level seen by the lcore.
+ * - Switch to asynchronous logs, send a message, then a burst larger than
+ *   the ring and check that every message is either logged or dropped.
  */
 
+static int
+test_logs_levels(void)
+{
+	unsigned lcore_id = rte_lcore_id();
+	unsigned other_lcore_id = (lcore_id + 1) % RTE_MAX_LCORE;
+	unsigned testapp2 = __builtin_ctz(RTE_LOGTYPE_TESTAPP2);
+	int ret = -1;
+
+	rte_set_log_type(RTE_LOGTYPE_TESTAPP2, 1);
+	rte_set_log_level(RTE_LOG_INFO);
+
+	if (rte_set_log_type_level(RTE_LOGTYPE_TESTAPP1, RTE_LOG_DEBUG + 1) !=
+			-EINVAL ||
+	    rte_set_log_lcore_level(RTE_MAX_LCORE, RTE_LOGTYPE_TESTAPP1,
+			RTE_LOG_DEBUG) != -EINVAL) {
+		printf("invalid log levels accepted\n");
+		goto out;
+	}
+
+	/* log type level overrides the global level */
+	rte_set_log_type_level(RTE_LOGTYPE_TESTAPP1, RTE_LOG_DEBUG);
+	if (rte_log_get_level(RTE_LOGTYPE_TESTAPP1) != RTE_LOG_DEBUG ||
+	    rte_log_get_level(RTE_LOGTYPE_TESTAPP2) != RTE_LOG_INFO) {
+		printf("bad log type level\n");
+		goto out;
+	}
+
+	/* lcore level overrides the log type level on this lcore only */
+	rte_set_log_lcore_level(other_lcore_id, RTE_LOGTYPE_TESTAPP2,
+			RTE_LOG_DEBUG);
+	if (rte_log_get_level(RTE_LOGTYPE_TESTAPP2) != RTE_LOG_INFO ||
+	    rte_log_levels[other_lcore_id][testapp2] != RTE_LOG_DEBUG) {
+		printf("bad lcore level of another lcore\n");
+		goto out;
+	}
+	rte_set_log_lcore_level(lcore_id, RTE_LOGTYPE_TESTAPP1 |
+			RTE_LOGTYPE_TESTAPP2, RTE_LOG_ERR);
+	if (rte_log_get_level(RTE_LOGTYPE_TESTAPP1) != RTE_LOG_ERR ||
+	    rte_log_get_level(RTE_LOGTYPE_TESTAPP2) != RTE_LOG_ERR) {
+		printf("bad lcore level\n");
+		goto out;
+	}
+
+	/* a disabled log type stays disabled */
+	rte_set_log_type(RTE_LOGTYPE_TESTAPP2, 0);
+	if (rte_log_get_level(RTE_LOGTYPE_TESTAPP2) != 0 ||
+	    rte_log_levels[other_lcore_id][testapp2] != 0) {
+		printf("disabled log type has a level\n");
+		goto out;
+	}
+	rte_set_log_type(RTE_LOGTYPE_TESTAPP2, 1);
+
+	/* removing the overrides goes back to the global level */
+	rte_set_log_lcore_level(lcore_id, RTE_LOGTYPE_TESTAPP1 |
+			RTE_LOGTYPE_TESTAPP2, 0);
+	rte_set_log_lcore_level(other_lcore_id, RTE_LOGTYPE_TESTAPP2, 0);
+	rte_set_log_type_level(RTE_LOGTYPE_TESTAPP1, 0);
+	if (rte_log_get_level(RTE_LOGTYPE_TESTAPP1) != RTE_LOG_INFO ||
+	    rte_log_levels[other_lcore_id][testapp2] != RTE_LOG_INFO) {
+		printf("log level overrides not removed\n");
+		goto out;
+	}
+	ret = 0;
+
+out:
+	rte_set_log_lcore_level(lcore_id, RTE_LOGTYPE_TESTAPP1 |
+			RTE_LOGTYPE_TESTAPP2, 0);
+	rte_set_log_lcore_level(other_lcore_id, RTE_LOGTYPE_TESTAPP2, 0);
+	rte_set_log_type_level(RTE_LOGTYPE_TESTAPP1, 0);
+	rte_set_log_level(RTE_LOG_DEBUG);
+	return ret;
+}
+
+static int
+test_logs_async(void)
+{
+	struct rte_log_async_stats before, after;
+	unsigned lcore_id = rte_lcore_id();
+	unsigned i;
+
+	if (rte_log_async_enable(TEST_LOG_ASYNC_RING_SIZE + 1) != -EINVAL) {
+		printf("async logs enabled with a bad ring size\n");
+		return -1;
+	}
+	if (rte_log_async_enable(TEST_LOG_ASYNC_RING_SIZE) < 0) {
+		printf("cannot enable async logs\n");
+		return -1;
+	}
+	if (rte_log_async_enable(TEST_LOG_ASYNC_RING_SIZE) != -EALREADY) {
+		printf("async logs enabled twice\n");
+		rte_log_async_disable();
+		return -1;
+	}
+
+	rte_log_async_get_stats(lcore_id, &before);
+	RTE_LOG(INFO, TESTAPP1, "this is an asynchronous message\n");
+	for (i = 0; i < TEST_LOG_ASYNC_MSGS; i++)
+		RTE_LOG(DEBUG, TESTAPP1, "asynchronous burst message %u\n", i);
+	rte_log_async_disable();
+	rte_log_async_get_stats(lcore_id, &after);
+
+	if (after.logged - before.logged == 0 ||
+	    after.logged + after.dropped - before.logged - before.dropped !=
+			TEST_LOG_ASYNC_MSGS + 1) {
+		printf("bad async log stats: %"PRIu64" logged, %"PRIu64
+			" dropped\n", after.logged - before.logged,
+			after.dropped - before.dropped);
+		return -1;
+	}
+
+	/* the rings are reused when enabling again */
+	if (rte_log_async_enable(TEST_LOG_ASYNC_RING_SIZE) < 0) {
+		printf("cannot enable async logs again\n");
+		return -1;
+	}
+	rte_log_async_disable();
+
+	return 0;
+}
+
 int
 test_logs(void)
 {
@@ -92,5 +221,8 @@ test_logs(void)
 
 	rte_log_dump_history();
 
-	return 0;
+	if (test_logs_levels() < 0)
+		return -1;
+
+	return test_logs_async();
 }
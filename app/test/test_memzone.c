@@ -36,6 +36,7 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <inttypes.h>
+#include <errno.h>
 #include <sys/queue.h>
 
 #include <cmdline_parse.h>
@@ -255,6 +256,31 @@ test_memzone_reserve_flags(void)
 			}
 		}
 	}
+
+	/*
+	 * Check that the largest page size is used when asked, and that it
+	 * cannot be combined with an explicit page size.
+	 */
+	if (hugepage_2MB_avail || hugepage_1GB_avail) {
+		mz = rte_memzone_reserve("flag_zone_largest", size, SOCKET_ID_ANY,
+				RTE_MEMZONE_LARGEST_PAGE);
+		if (mz == NULL) {
+			printf("MEMZONE FLAG LARGEST\n");
+			return -1;
+		}
+		if (mz->hugepage_sz != (hugepage_1GB_avail ?
+				(uint64_t)RTE_PGSIZE_1G : (uint64_t)RTE_PGSIZE_2M)) {
+			printf("hugepage_sz not equal to the largest size\n");
+			return -1;
+		}
+
+		mz = rte_memzone_reserve("flag_zone_largest_2M", size, SOCKET_ID_ANY,
+				RTE_MEMZONE_LARGEST_PAGE|RTE_MEMZONE_2MB);
+		if (mz != NULL) {
+			printf("LARGEST AND 2MB SIZES SET\n");
+			return -1;
+		}
+	}
 	return 0;
 }
 
@@ -531,6 +557,58 @@ test_memzone_aligned(void)
 	return 0;
 }
 
+/*
+ * Check that the usage of each memory segment covers the whole segment,
+ * and that the memzones are all accounted for.
+ */
+static int
+test_memseg_usage(void)
+{
+	const struct rte_config *config;
+	const struct rte_memseg *ms;
+	struct rte_memseg_usage usage;
+	unsigned i, nb_memzones = 0, total_memzones = 0;
+
+	config = rte_eal_get_configuration();
+	ms = rte_eal_get_physmem_layout();
+
+	for (i = 0; i < RTE_MAX_MEMSEG && ms[i].addr != NULL; i++) {
+		if (rte_memseg_usage_get(NULL, i, &usage) < 0) {
+			printf("Cannot get usage of memseg %u\n", i);
+			return -1;
+		}
+		if (usage.used_len + usage.free_len != ms[i].len) {
+			printf("Bad usage of memseg %u\n", i);
+			return -1;
+		}
+		if (usage.largest_free_len > usage.free_len ||
+				(usage.free_len != 0 && usage.nb_free_frags == 0)) {
+			printf("Bad free fragments in memseg %u\n", i);
+			return -1;
+		}
+		nb_memzones += usage.nb_memzones;
+	}
+
+	/* a segment that does not exist */
+	if (rte_memseg_usage_get(NULL, i, &usage) != -EINVAL) {
+		printf("Got usage of a non existing memseg\n");
+		return -1;
+	}
+
+	for (i = 0; i < RTE_MAX_MEMZONE; i++) {
+		if (config->mem_config->memzone[i].addr == NULL)
+			break;
+		total_memzones++;
+	}
+	if (nb_memzones != total_memzones) {
+		printf("Bad number of memzones: %u instead of %u\n",
+				nb_memzones, total_memzones);
+		return -1;
+	}
+
+	return 0;
+}
+
 int
 test_memzone(void)
 {
@@ -635,5 +713,9 @@ test_memzone(void)
 	if (test_memzone_reserve_max_aligned() < 0)
 		return -1;
 
+	printf("test memory segment usage\n");
+	if (test_memseg_usage() < 0)
+		return -1;
+
 	return 0;
 }
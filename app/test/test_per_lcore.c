@@ -35,6 +35,10 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <pthread.h>
 #include <sys/queue.h>
 
 #include <cmdline_parse.h>
@@ -66,6 +70,18 @@
  *
  * - If at least one per-core variable was not correct, the test function
  *   returns -1.
+ *
+ * - Launch a function on every slave lcore and poll their completion
+ *   with ``rte_eal_poll_lcore()``, then measure the time needed to launch
+ *   an empty function on all slave lcores and to wait for them.
+ *
+ * - Register two threads created with ``pthread_create()`` as lcores,
+ *   check that they get distinct lcore ids that are not enabled, then
+ *   unregister them.
+ *
+ * - Check the consistency of the lcore topology, and that
+ *   ``rte_lcore_select_per_core()`` selects at most one lcore per
+ *   physical core.
  */
 
 static RTE_DEFINE_PER_LCORE(unsigned, test) = 0x12345678;
@@ -103,6 +119,213 @@ test_per_lcore_delay(__attribute__((unused)) void *arg)
 	return 0;
 }
 
+static int
+return_lcore_id(__attribute__((unused)) void *arg)
+{
+	return rte_lcore_id();
+}
+
+static int
+empty_func(__attribute__((unused)) void *arg)
+{
+	return 0;
+}
+
+#define LAUNCH_ITERATIONS 1000
+
+static int
+test_poll_lcore(void)
+{
+	unsigned lcore_id, i;
+	uint64_t start, end;
+	int ret;
+
+	if (rte_eal_mp_remote_launch(return_lcore_id, NULL, SKIP_MASTER) < 0)
+		return -1;
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		while (rte_eal_poll_lcore(lcore_id, &ret) == -EBUSY)
+			rte_pause();
+		if (ret != (int)lcore_id) {
+			printf("lcore %u returned %d\n", lcore_id, ret);
+			return -1;
+		}
+		if (rte_eal_get_lcore_state(lcore_id) != WAIT) {
+			printf("lcore %u not in WAIT state after poll\n", lcore_id);
+			return -1;
+		}
+	}
+
+	/* polling an idle lcore succeeds */
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		if (rte_eal_poll_lcore(lcore_id, &ret) != 0 || ret != 0)
+			return -1;
+	}
+
+	start = rte_rdtsc();
+	for (i = 0; i < LAUNCH_ITERATIONS; i++) {
+		rte_eal_mp_remote_launch(empty_func, NULL, SKIP_MASTER);
+		rte_eal_mp_wait_lcore();
+	}
+	end = rte_rdtsc();
+	printf("launch and wait on all slave lcores: %"PRIu64" cycles\n",
+	       (end - start) / LAUNCH_ITERATIONS);
+
+	return 0;
+}
+
+struct thread_register_arg {
+	int lcore_id;               /**< lcore id given to the thread */
+	int ret;                    /**< 0 if checks were ok */
+	volatile int registered;    /**< set when thread is registered */
+	volatile int quit;          /**< set by master to unregister */
+};
+
+static void *
+thread_register(void *arg)
+{
+	struct thread_register_arg *a = arg;
+	int lcore_id;
+
+	a->ret = -1;
+	lcore_id = rte_thread_register();
+	a->lcore_id = lcore_id;
+	if (lcore_id < 0) {
+		printf("cannot register thread: %d\n", lcore_id);
+		a->registered = 1;
+		return NULL;
+	}
+	if (rte_lcore_id() != (unsigned)lcore_id ||
+	    rte_lcore_is_enabled(lcore_id) ||
+	    rte_eal_lcore_role(lcore_id) != ROLE_NON_EAL) {
+		printf("wrong state of registered lcore %d\n", lcore_id);
+		a->registered = 1;
+		return NULL;
+	}
+	if (rte_thread_register() != -EEXIST) {
+		printf("thread registered twice\n");
+		a->registered = 1;
+		return NULL;
+	}
+	/* the per-lcore variables of the thread are its own */
+	if (RTE_PER_LCORE(test) != 0x12345678) {
+		a->registered = 1;
+		return NULL;
+	}
+
+	a->registered = 1;
+	while (a->quit == 0)
+		rte_pause();
+
+	if (rte_thread_unregister() != 0 ||
+	    rte_thread_unregister() != -EINVAL ||
+	    rte_eal_lcore_role(lcore_id) != ROLE_OFF) {
+		printf("cannot unregister lcore %d\n", lcore_id);
+		return NULL;
+	}
+	a->ret = 0;
+	return NULL;
+}
+
+static int
+test_thread_register(void)
+{
+	struct thread_register_arg args[2];
+	pthread_t threads[2];
+	unsigned i;
+	int ret = 0;
+
+	if (rte_thread_register() != -EEXIST) {
+		printf("EAL thread registered\n");
+		return -1;
+	}
+
+	memset(args, 0, sizeof(args));
+	for (i = 0; i < 2; i++) {
+		if (pthread_create(&threads[i], NULL, thread_register,
+				   &args[i]) != 0)
+			return -1;
+		while (args[i].registered == 0)
+			rte_pause();
+	}
+
+	if (args[0].lcore_id == args[1].lcore_id) {
+		printf("threads registered with the same lcore id\n");
+		ret = -1;
+	}
+	else
+		printf("threads registered as lcores %d and %d\n",
+		       args[0].lcore_id, args[1].lcore_id);
+
+	for (i = 0; i < 2; i++) {
+		args[i].quit = 1;
+		pthread_join(threads[i], NULL);
+		if (args[i].ret != 0)
+			ret = -1;
+	}
+	return ret;
+}
+
+static int
+test_lcore_topology(void)
+{
+	unsigned lcores[RTE_MAX_LCORE];
+	unsigned lcore_id, i, j, nb = 0;
+
+	RTE_LCORE_FOREACH(lcore_id) {
+		printf("lcore %u: socket %u, core %u\n", lcore_id,
+		       rte_lcore_to_socket_id(lcore_id),
+		       rte_lcore_to_core_id(lcore_id));
+		if (rte_lcore_is_sibling(lcore_id, lcore_id) ||
+		    !rte_lcore_share_cache(lcore_id, lcore_id, 2) ||
+		    !rte_lcore_share_cache(lcore_id, lcore_id, 3)) {
+			printf("lcore %u: inconsistent topology\n", lcore_id);
+			return -1;
+		}
+		/* hyperthreads of a core share its L2 cache */
+		RTE_LCORE_FOREACH(i) {
+			if (rte_lcore_is_sibling(lcore_id, i) &&
+			    !rte_lcore_share_cache(lcore_id, i, 2)) {
+				printf("siblings %u and %u do not share L2\n",
+				       lcore_id, i);
+				return -1;
+			}
+		}
+	}
+
+	if (rte_lcore_select_per_core(SOCKET_ID_ANY, 0, lcores, &nb,
+				      RTE_MAX_LCORE) != nb ||
+	    nb == 0 || nb > rte_lcore_count()) {
+		printf("wrong number of selected lcores: %u\n", nb);
+		return -1;
+	}
+	for (i = 0; i < nb; i++) {
+		for (j = i + 1; j < nb; j++) {
+			if (lcores[i] == lcores[j] ||
+			    rte_lcore_is_sibling(lcores[i], lcores[j])) {
+				printf("lcores %u and %u on the same core\n",
+				       lcores[i], lcores[j]);
+				return -1;
+			}
+		}
+	}
+
+	/* nothing more to select */
+	if (rte_lcore_select_per_core(SOCKET_ID_ANY, 0, lcores, &nb,
+				      RTE_MAX_LCORE) != 0)
+		return -1;
+
+	nb = 0;
+	rte_lcore_select_per_core(SOCKET_ID_ANY, 1, lcores, &nb,
+				  RTE_MAX_LCORE);
+	for (i = 0; i < nb; i++) {
+		if (lcores[i] == rte_get_master_lcore()) {
+			printf("master lcore selected\n");
+			return -1;
+		}
+	}
+	return 0;
+}
+
 int
 test_per_lcore(void)
 {
@@ -138,5 +361,14 @@ test_per_lcore(void)
 			return -1;
 	}
 
+	if (test_poll_lcore() < 0)
+		return -1;
+
+	if (test_thread_register() < 0)
+		return -1;
+
+	if (test_lcore_topology() < 0)
+		return -1;
+
 	return 0;
 }
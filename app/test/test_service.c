@@ -0,0 +1,257 @@
+/*-
+ *   BSD LICENSE
+ * 
+ *   Copyright(c) 2010-2012 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ * 
+ *   Redistribution and use in source and binary forms, with or without 
+ *   modification, are permitted provided that the following conditions 
+ *   are met:
+ * 
+ *     * Redistributions of source code must retain the above copyright 
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright 
+ *       notice, this list of conditions and the following disclaimer in 
+ *       the documentation and/or other materials provided with the 
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its 
+ *       contributors may be used to endorse or promote products derived 
+ *       from this software without specific prior written permission.
+ * 
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *  version: DPDK.L.1.2.3-3
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/queue.h>
+
+#include <cmdline_parse.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_atomic.h>
+#include <rte_memory.h>
+#include <rte_memzone.h>
+#include <rte_tailq.h>
+#include <rte_eal.h>
+#include <rte_launch.h>
+#include <rte_per_lcore.h>
+#include <rte_lcore.h>
+#include <rte_service.h>
+
+#include "test.h"
+
+/*
+ * Service functions
+ * =================
+ *
+ * - Check that invalid registrations are refused.
+ *
+ * - Map two services with different weights on the master lcore, run
+ *   rounds with ``rte_service_run_round()`` and check the number of calls
+ *   of each service, with the services enabled and disabled.
+ *
+ * - If there is a slave lcore, launch ``rte_service_lcore_run()`` on it,
+ *   check that the services are called, then stop it.
+ */
+
+#define SERVICE_ROUNDS 100
+
+static rte_atomic32_t count_a;
+static rte_atomic32_t count_b;
+
+static void
+service_a(void *arg)
+{
+	rte_atomic32_inc(arg);
+}
+
+static void
+service_b(void *arg)
+{
+	rte_atomic32_inc(arg);
+}
+
+/* register a service, or get it if it was registered by a previous run */
+static int
+get_service(const char *name, rte_service_func_t *f, void *arg)
+{
+	int id = rte_service_register(name, f, arg);
+
+	if (id == -EEXIST)
+		id = rte_service_lookup(name);
+	return id;
+}
+
+static int
+test_service_register(void)
+{
+	char name[RTE_SERVICE_NAMESIZE + 1];
+
+	if (rte_service_register(NULL, service_a, NULL) != -EINVAL ||
+	    rte_service_register("", service_a, NULL) != -EINVAL ||
+	    rte_service_register("test_null", NULL, NULL) != -EINVAL) {
+		printf("invalid service registered\n");
+		return -1;
+	}
+
+	memset(name, 'a', sizeof(name) - 1);
+	name[sizeof(name) - 1] = '\0';
+	if (rte_service_register(name, service_a, NULL) != -EINVAL) {
+		printf("service with a too long name registered\n");
+		return -1;
+	}
+
+	if (rte_service_register("test_service_a", service_a,
+				 &count_a) != -EEXIST) {
+		printf("service registered twice\n");
+		return -1;
+	}
+	if (rte_service_lookup("test_service_none") != -ENOENT) {
+		printf("lookup of unknown service succeeded\n");
+		return -1;
+	}
+	if (rte_service_map_lcore(RTE_SERVICE_MAX, 0, 1) != -EINVAL ||
+	    rte_service_enable(RTE_SERVICE_MAX) != -EINVAL) {
+		printf("invalid service identifier accepted\n");
+		return -1;
+	}
+	return 0;
+}
+
+static int
+test_service_rounds(int id_a, int id_b)
+{
+	unsigned lcore_id = rte_lcore_id();
+	struct rte_service_stats stats;
+	uint64_t prev_calls;
+	unsigned i;
+
+	rte_service_map_lcore(id_a, lcore_id, 1);
+	rte_service_map_lcore(id_b, lcore_id, 3);
+
+	/* services are disabled after registration */
+	rte_atomic32_set(&count_a, 0);
+	rte_atomic32_set(&count_b, 0);
+	for (i = 0; i < SERVICE_ROUNDS; i++)
+		rte_service_run_round();
+	if (rte_atomic32_read(&count_a) != 0 ||
+	    rte_atomic32_read(&count_b) != 0) {
+		printf("disabled services were called\n");
+		return -1;
+	}
+
+	rte_service_get_stats(id_a, &stats);
+	prev_calls = stats.calls;
+
+	rte_service_enable(id_a);
+	rte_service_enable(id_b);
+	for (i = 0; i < SERVICE_ROUNDS; i++) {
+		if (rte_service_run_round() != 2) {
+			printf("wrong number of services run\n");
+			return -1;
+		}
+	}
+	if (rte_atomic32_read(&count_a) != SERVICE_ROUNDS ||
+	    rte_atomic32_read(&count_b) != 3 * SERVICE_ROUNDS) {
+		printf("wrong number of calls: a=%d b=%d\n",
+		       rte_atomic32_read(&count_a), rte_atomic32_read(&count_b));
+		return -1;
+	}
+
+	rte_service_get_stats(id_a, &stats);
+	if (stats.calls - prev_calls != SERVICE_ROUNDS) {
+		printf("wrong statistics for %s\n", rte_service_name(id_a));
+		return -1;
+	}
+
+	/* unmap one, disable the other */
+	rte_service_map_lcore(id_a, lcore_id, 0);
+	rte_service_disable(id_b);
+	rte_atomic32_set(&count_a, 0);
+	rte_atomic32_set(&count_b, 0);
+	for (i = 0; i < SERVICE_ROUNDS; i++)
+		rte_service_run_round();
+	if (rte_atomic32_read(&count_a) != 0 ||
+	    rte_atomic32_read(&count_b) != 0) {
+		printf("unmapped or disabled services were called\n");
+		return -1;
+	}
+	rte_service_map_lcore(id_b, lcore_id, 0);
+
+	return 0;
+}
+
+static int
+test_service_lcore(int id_a)
+{
+	unsigned lcore_id;
+	int i;
+
+	lcore_id = rte_get_next_lcore(rte_lcore_id(), 1, 0);
+	if (lcore_id >= RTE_MAX_LCORE) {
+		printf("no slave lcore, skip service lcore test\n");
+		return 0;
+	}
+
+	rte_atomic32_set(&count_a, 0);
+	rte_service_map_lcore(id_a, lcore_id, 1);
+	rte_service_enable(id_a);
+	if (rte_eal_remote_launch(rte_service_lcore_run, NULL, lcore_id) < 0)
+		return -1;
+
+	for (i = 0; i < 1000 && rte_atomic32_read(&count_a) == 0; i++)
+		rte_delay_ms(1);
+
+	rte_service_lcore_stop(lcore_id);
+	rte_eal_wait_lcore(lcore_id);
+	rte_service_map_lcore(id_a, lcore_id, 0);
+	rte_service_disable(id_a);
+
+	if (rte_atomic32_read(&count_a) == 0) {
+		printf("service not called on lcore %u\n", lcore_id);
+		return -1;
+	}
+	return 0;
+}
+
+int
+test_service(void)
+{
+	int id_a, id_b;
+
+	id_a = get_service("test_service_a", service_a, &count_a);
+	id_b = get_service("test_service_b", service_b, &count_b);
+	if (id_a < 0 || id_b < 0) {
+		printf("cannot register services\n");
+		return -1;
+	}
+	if (rte_service_lookup("test_service_b") != id_b) {
+		printf("lookup returned a wrong identifier\n");
+		return -1;
+	}
+
+	if (test_service_register() < 0)
+		return -1;
+	if (test_service_rounds(id_a, id_b) < 0)
+		return -1;
+	if (test_service_lcore(id_a) < 0)
+		return -1;
+
+	rte_service_dump();
+	return 0;
+}
@@ -95,6 +95,39 @@
  *      - At initialization, timer3 is loaded by the master core, on
  *        another core in "periodical" mode (time = 1 second).
  *      - It is stopped at t=25s by timer2.
+ *
+ * #. Time source test.
+ *
+ *    This test checks that the time source of the timer library can
+ *    only be changed when no timer is pending, and displays the cost
+ *    of a call to rte_timer_manage() when a timer is pending but not
+ *    expired, for the TSC and HPET time sources.
+ *
+ * #. Budget test.
+ *
+ *    This test checks that rte_timer_manage_budget() runs no more
+ *    timers than asked, and that the expired timers which are not run
+ *    are run by the next calls in expiration order.
+ *
+ *    - 1000 timers are armed on the master core to expire within 1 ms.
+ *    - They are run by batches of 100, then one by one with a cycle
+ *      budget of 1, then all the remaining ones at once.
+ *    - The latency statistics of the lcore must account each expiration
+ *      and each call to rte_timer_manage_budget().
+ *
+ * #. Scaling benchmark.
+ *
+ *    This test measures the cost of the timer operations on the master
+ *    core when many timers are pending, to check that it grows slowly
+ *    with the number of timers.
+ *
+ *    - 1K, 10K, 100K and 1M timers are used.
+ *    - The timers are armed with a random expiration time between 1 and
+ *      2 seconds, re-armed while pending, then stopped. The average
+ *      number of TSC cycles per call is displayed for each operation.
+ *    - The timers are then armed to expire within a few milliseconds,
+ *      and the number of cycles spent in rte_timer_manage() per expired
+ *      timer is displayed.
  */
 
 #include <stdio.h>
@@ -125,6 +158,7 @@
 
 #define TEST_DURATION_S 30 /* in seconds */
 #define NB_TIMER 4
+#define PERF_MAX_TIMERS 1000000
 
 #define RTE_LOGTYPE_TESTTIMER RTE_LOGTYPE_USER3
 
@@ -156,7 +190,7 @@ timer_stress_cb(__attribute__((unused)) struct rte_timer *tim,
 {
 	long r;
 	unsigned lcore_id = rte_lcore_id();
-	uint64_t hz = rte_get_hpet_hz();
+	uint64_t hz = rte_timer_get_hz();
 
 	if (rte_timer_pending(tim))
 		return;
@@ -179,7 +213,7 @@ timer_stress_cb(__attribute__((unused)) struct rte_timer *tim,
 static int
 timer_stress_main_loop(__attribute__((unused)) void *arg)
 {
-	uint64_t hz = rte_get_hpet_hz();
+	uint64_t hz = rte_timer_get_hz();
 	unsigned lcore_id = rte_lcore_id();
 	uint64_t cur_time;
 	int64_t diff = 0;
@@ -205,7 +239,7 @@ timer_stress_main_loop(__attribute__((unused)) void *arg)
 		else if ((r & 0xff) == 1) {
 			rte_timer_stop_sync(&mytiminfo[0].tim);
 		}
-		cur_time = rte_get_hpet_cycles();
+		cur_time = rte_timer_get_cycles();
 		diff = end_time - cur_time;
 	}
 
@@ -220,9 +254,9 @@ static void
 timer_basic_cb(struct rte_timer *tim, void *arg)
 {
 	struct mytimerinfo *timinfo = arg;
-	uint64_t hz = rte_get_hpet_hz();
+	uint64_t hz = rte_timer_get_hz();
 	unsigned lcore_id = rte_lcore_id();
-	uint64_t cur_time = rte_get_hpet_cycles();
+	uint64_t cur_time = rte_timer_get_cycles();
 
 	if (rte_timer_pending(tim))
 		return;
@@ -275,7 +309,7 @@ timer_basic_cb(struct rte_timer *tim, void *arg)
 static int
 timer_basic_main_loop(__attribute__((unused)) void *arg)
 {
-	uint64_t hz = rte_get_hpet_hz();
+	uint64_t hz = rte_timer_get_hz();
 	unsigned lcore_id = rte_lcore_id();
 	uint64_t cur_time;
 	int64_t diff = 0;
@@ -302,7 +336,7 @@ timer_basic_main_loop(__attribute__((unused)) void *arg)
 		 * (3 us = 6000 cycles at 2 Ghz) */
 		rte_delay_us(3);
 
-		cur_time = rte_get_hpet_cycles();
+		cur_time = rte_timer_get_cycles();
 		diff = end_time - cur_time;
 	}
 	RTE_LOG(INFO, TESTTIMER, "core %u finished\n", lcore_id);
@@ -310,6 +344,334 @@ timer_basic_main_loop(__attribute__((unused)) void *arg)
 	return 0;
 }
 
+static void
+timer_perf_cb(__attribute__((unused)) struct rte_timer *tim,
+	      void *arg)
+{
+	unsigned *count = arg;
+
+	(*count)++;
+}
+
+/* average cycles of rte_timer_manage() with one non-expired timer */
+static uint64_t
+timer_manage_cost(struct rte_timer *tim)
+{
+	uint64_t start;
+	unsigned count = 0;
+	unsigned i;
+
+	rte_timer_reset_sync(tim, rte_timer_get_hz(), SINGLE, rte_lcore_id(),
+			     timer_perf_cb, &count);
+	start = rte_rdtsc();
+	for (i = 0; i < 100000; i++)
+		rte_timer_manage();
+	start = rte_rdtsc() - start;
+	rte_timer_stop_sync(tim);
+
+	return start / 100000;
+}
+
+static int
+test_timer_source(void)
+{
+	struct rte_timer tim;
+	uint64_t tsc_cost, hpet_cost;
+	unsigned count = 0;
+
+	rte_timer_init(&tim);
+	rte_timer_reset_sync(&tim, rte_timer_get_hz(), SINGLE, rte_lcore_id(),
+			     timer_perf_cb, &count);
+	if (rte_timer_set_source(RTE_TIMER_SOURCE_HPET) == 0) {
+		printf("time source changed while a timer is pending\n");
+		rte_timer_stop_sync(&tim);
+		return -1;
+	}
+	rte_timer_stop_sync(&tim);
+
+	if (rte_timer_set_source(RTE_TIMER_SOURCE_TSC) < 0 ||
+	    rte_timer_get_source() != RTE_TIMER_SOURCE_TSC ||
+	    rte_timer_get_hz() != rte_get_tsc_hz()) {
+		printf("cannot select TSC time source\n");
+		return -1;
+	}
+	tsc_cost = timer_manage_cost(&tim);
+
+	if (rte_timer_set_source(RTE_TIMER_SOURCE_HPET) < 0 ||
+	    rte_timer_get_source() != RTE_TIMER_SOURCE_HPET ||
+	    rte_timer_get_hz() != rte_get_hpet_hz()) {
+		printf("cannot select HPET time source\n");
+		return -1;
+	}
+	hpet_cost = timer_manage_cost(&tim);
+
+	if (rte_timer_set_source(RTE_TIMER_SOURCE_AUTO) < 0) {
+		printf("cannot select default time source\n");
+		return -1;
+	}
+
+	printf("rte_timer_manage() cost: tsc=%"PRIu64" hpet=%"PRIu64
+	       " cycles, using %s\n", tsc_cost, hpet_cost,
+	       rte_timer_get_source() == RTE_TIMER_SOURCE_TSC ? "tsc" : "hpet");
+	return 0;
+}
+
+#define BUDGET_NB_TIMERS 1000
+
+static unsigned budget_next;
+static int budget_err;
+
+/* check that the timers expire in the order they were armed */
+static void
+timer_budget_cb(__attribute__((unused)) struct rte_timer *tim,
+		void *arg)
+{
+	unsigned id = (unsigned)(uintptr_t)arg;
+
+	if (id != budget_next)
+		budget_err = 1;
+	budget_next++;
+}
+
+static int
+test_timer_budget(void)
+{
+	struct rte_timer *tims;
+	struct rte_timer_latency_stats before, after;
+	uint64_t hz = rte_timer_get_hz();
+	unsigned lcore_id = rte_lcore_id();
+	unsigned i, n;
+	int ret = -1;
+
+	tims = malloc(BUDGET_NB_TIMERS * sizeof(*tims));
+	if (tims == NULL) {
+		printf("cannot allocate timers\n");
+		return -1;
+	}
+
+	budget_next = 0;
+	budget_err = 0;
+	for (i = 0; i < BUDGET_NB_TIMERS; i++) {
+		rte_timer_init(&tims[i]);
+		rte_timer_reset(&tims[i],
+				(hz / 1000) * i / BUDGET_NB_TIMERS, SINGLE,
+				lcore_id, timer_budget_cb, (void *)(uintptr_t)i);
+	}
+	rte_delay_ms(2);
+	rte_timer_get_latency_stats(lcore_id, &before);
+
+	for (i = 0; i < 5; i++) {
+		n = rte_timer_manage_budget(100, 0);
+		if (n != 100) {
+			printf("budget of 100 timers not respected (%u)\n", n);
+			goto end;
+		}
+	}
+	for (i = 0; i < 5; i++) {
+		n = rte_timer_manage_budget(0, 1);
+		if (n != 1) {
+			printf("budget of 1 cycle not respected (%u)\n", n);
+			goto end;
+		}
+	}
+	n = rte_timer_manage_budget(0, 0);
+	if (n != BUDGET_NB_TIMERS - 505 || budget_next != BUDGET_NB_TIMERS) {
+		printf("%u timers run at the end, %u total\n",
+		       n, budget_next);
+		goto end;
+	}
+	if (budget_err) {
+		printf("timers not run in expiration order\n");
+		goto end;
+	}
+
+	/* check that the expirations were accounted */
+	rte_timer_get_latency_stats(lcore_id, &after);
+	if (after.lateness.count - before.lateness.count != BUDGET_NB_TIMERS ||
+	    after.callback.count - before.callback.count != BUDGET_NB_TIMERS ||
+	    after.manage.count - before.manage.count != 11) {
+		printf("timer expirations not accounted in statistics\n");
+		goto end;
+	}
+	ret = 0;
+
+end:
+	for (i = 0; i < BUDGET_NB_TIMERS; i++)
+		rte_timer_stop_sync(&tims[i]);
+	free(tims);
+	return ret;
+}
+
+static struct rte_timer cb_other_tims[3];
+static unsigned cb_other_ran[3];
+static int cb_other_err;
+
+/*
+ * callback of timer 0, acting on timer 1 which expired in the same call
+ * to rte_timer_manage(): it cannot be stopped nor reset before its own
+ * callback has run
+ */
+static void
+timer_cb_other_cb(struct rte_timer *tim, void *arg)
+{
+	unsigned id = (unsigned)(uintptr_t)arg;
+
+	cb_other_ran[id]++;
+	if (tim != &cb_other_tims[0])
+		return;
+
+	if (rte_timer_stop(&cb_other_tims[1]) == 0) {
+		printf("expired timer stopped before its callback ran\n");
+		cb_other_err = 1;
+	}
+	if (rte_timer_reset(&cb_other_tims[1], rte_timer_get_hz(), SINGLE,
+			    rte_lcore_id(), timer_cb_other_cb,
+			    (void *)(uintptr_t)1) == 0) {
+		printf("expired timer reset before its callback ran\n");
+		cb_other_err = 1;
+	}
+}
+
+/*
+ * timers 0 and 1 expire together, timer 2 is armed far away: the
+ * callback of timer 0 fails to stop and reset timer 1, whose callback
+ * still runs, and timer 2 stays pending. With a budget of 1 cycle,
+ * timer 1 is put back in the list after timer 0 ran, and is run by the
+ * next call.
+ */
+static int
+test_timer_cb_other(uint64_t max_cycles)
+{
+	unsigned lcore_id = rte_lcore_id();
+	uint64_t hz = rte_timer_get_hz();
+	unsigned i;
+	int ret = -1;
+
+	cb_other_err = 0;
+	for (i = 0; i < 3; i++) {
+		cb_other_ran[i] = 0;
+		rte_timer_init(&cb_other_tims[i]);
+	}
+	rte_timer_reset(&cb_other_tims[0], 0, SINGLE, lcore_id,
+			timer_cb_other_cb, (void *)(uintptr_t)0);
+	rte_timer_reset(&cb_other_tims[1], 0, SINGLE, lcore_id,
+			timer_cb_other_cb, (void *)(uintptr_t)1);
+	rte_timer_reset(&cb_other_tims[2], hz * 1000, SINGLE, lcore_id,
+			timer_cb_other_cb, (void *)(uintptr_t)2);
+	rte_delay_ms(1);
+
+	if (max_cycles == 0)
+		rte_timer_manage();
+	else {
+		if (rte_timer_manage_budget(0, max_cycles) != 1) {
+			printf("budget of 1 cycle not respected\n");
+			goto end;
+		}
+		if (!rte_timer_pending(&cb_other_tims[1])) {
+			printf("timer not run not put back in the list\n");
+			goto end;
+		}
+		rte_timer_manage_budget(0, max_cycles);
+	}
+	if (cb_other_err)
+		goto end;
+	if (cb_other_ran[0] != 1 || cb_other_ran[1] != 1 ||
+	    cb_other_ran[2] != 0) {
+		printf("ran a=%u b=%u c=%u\n", cb_other_ran[0],
+		       cb_other_ran[1], cb_other_ran[2]);
+		goto end;
+	}
+	if (rte_timer_pending(&cb_other_tims[1]) ||
+	    !rte_timer_pending(&cb_other_tims[2])) {
+		printf("wrong timer states after their expiration\n");
+		goto end;
+	}
+	ret = 0;
+
+end:
+	for (i = 0; i < 3; i++)
+		rte_timer_stop_sync(&cb_other_tims[i]);
+	return ret;
+}
+
+/* arm, re-arm, stop and expire n timers, display cycles per operation */
+static int
+timer_perf_run(struct rte_timer *tims, unsigned n, unsigned *count)
+{
+	unsigned lcore_id = rte_lcore_id();
+	uint64_t hz = rte_timer_get_hz();
+	uint64_t start, arm, rearm, stop, manage, max_ticks = 0, ticks;
+	unsigned i;
+
+	for (i = 0; i < n; i++)
+		rte_timer_init(&tims[i]);
+
+	start = rte_rdtsc();
+	for (i = 0; i < n; i++)
+		rte_timer_reset(&tims[i], hz + rte_rand() % hz, SINGLE,
+				lcore_id, timer_perf_cb, count);
+	arm = rte_rdtsc() - start;
+
+	start = rte_rdtsc();
+	for (i = 0; i < n; i++)
+		rte_timer_reset(&tims[i], hz + rte_rand() % hz, SINGLE,
+				lcore_id, timer_perf_cb, count);
+	rearm = rte_rdtsc() - start;
+
+	start = rte_rdtsc();
+	for (i = 0; i < n; i++)
+		rte_timer_stop(&tims[i]);
+	stop = rte_rdtsc() - start;
+
+	/* arm the timers to expire soon, wait, then expire all of them
+	 * in one call */
+	*count = 0;
+	for (i = 0; i < n; i++) {
+		ticks = rte_rand() % (hz / 1000 + 1);
+		if (ticks > max_ticks)
+			max_ticks = ticks;
+		rte_timer_reset(&tims[i], ticks, SINGLE, lcore_id,
+				timer_perf_cb, count);
+	}
+	rte_delay_ms(max_ticks * 1000 / hz + 1);
+	start = rte_rdtsc();
+	rte_timer_manage();
+	manage = rte_rdtsc() - start;
+
+	printf("%8u %10"PRIu64" %10"PRIu64" %10"PRIu64" %10"PRIu64"\n",
+	       n, arm / n, rearm / n, stop / n, manage / n);
+
+	if (*count != n) {
+		printf("only %u/%u timers expired\n", *count, n);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+test_timer_perf(void)
+{
+	struct rte_timer *tims;
+	unsigned count;
+	unsigned n;
+	int ret = 0;
+
+	tims = malloc(PERF_MAX_TIMERS * sizeof(*tims));
+	if (tims == NULL) {
+		printf("cannot allocate timers\n");
+		return -1;
+	}
+
+	printf("Start timer scaling benchmark (cycles per operation)\n");
+	printf("%8s %10s %10s %10s %10s\n",
+	       "timers", "arm", "rearm", "stop", "expire");
+	for (n = 1000; n <= PERF_MAX_TIMERS && ret == 0; n *= 10)
+		ret = timer_perf_run(tims, n, &count);
+
+	free(tims);
+	return ret;
+}
+
 int
 test_timer(void)
 {
@@ -330,8 +692,8 @@ test_timer(void)
 	}
 
 	/* calculate the "end of test" time */
-	cur_time = rte_get_hpet_cycles();
-	hz = rte_get_hpet_hz();
+	cur_time = rte_timer_get_cycles();
+	hz = rte_timer_get_hz();
 	end_time = cur_time + (hz * TEST_DURATION_S);
 
 	/* start other cores */
@@ -343,8 +705,8 @@ test_timer(void)
 	rte_timer_stop_sync(&mytiminfo[0].tim);
 
 	/* calculate the "end of test" time */
-	cur_time = rte_get_hpet_cycles();
-	hz = rte_get_hpet_hz();
+	cur_time = rte_timer_get_cycles();
+	hz = rte_timer_get_hz();
 	end_time = cur_time + (hz * TEST_DURATION_S);
 
 	/* start other cores */
@@ -359,5 +721,20 @@ test_timer(void)
 
 	rte_timer_dump_stats();
 
+	if (test_timer_source() < 0)
+		return -1;
+
+	if (test_timer_budget() < 0)
+		return -1;
+
+	if (test_timer_cb_other(0) < 0)
+		return -1;
+
+	if (test_timer_cb_other(1) < 0)
+		return -1;
+
+	if (test_timer_perf() < 0)
+		return -1;
+
 	return 0;
 }
@@ -43,6 +43,8 @@
 #include <stdarg.h>
 #include <errno.h>
 #include <getopt.h>
+#include <unistd.h>
+#include <sys/epoll.h>
 
 #include <rte_common.h>
 #include <rte_byteorder.h>
@@ -146,6 +148,14 @@ static struct ether_addr ports_eth_addr[MAX_PORTS];
 static uint32_t enabled_port_mask = 0;
 static int promiscuous_on = 0; /**< Ports set in promiscuous mode off by default. */
 static int numa_on = 1; /**< NUMA is enabled by default. */
+static int power_on = 0; /**< Sleep on RX interrupts when idle, off by default. */
+
+/*
+ * Number of consecutive empty polls of all its RX queues after which an
+ * lcore goes to sleep in power mode, and maximum time it sleeps.
+ */
+#define POWER_IDLE_POLLS_MAX 300
+#define POWER_SLEEP_TIMEOUT_MS 10
 
 struct mbuf_table {
 	uint16_t len;
@@ -258,12 +268,11 @@ struct rte_hash_parameters l3fwd_hash_params = {
 	.hash_func = rte_hash_crc,
 	.hash_func_init_val = 0,
 	.socket_id = SOCKET0,
+	.flags = HASH_F_DATA, /* output interface stored with each key */
 };
 
 #define L3FWD_NUM_ROUTES \
 	(sizeof(l3fwd_route_array) / sizeof(l3fwd_route_array[0]))
-
-static uint8_t l3fwd_out_if[L3FWD_HASH_ENTRIES] __rte_cache_aligned;
 #endif
 
 #if (APP_LOOKUP_METHOD == APP_LOOKUP_LPM)
@@ -404,6 +413,7 @@ get_dst_port(struct ipv4_hdr *ipv4_hdr,  uint8_t portid, lookup_struct_t * l3fwd
 	struct ipv4_5tuple key;
 	struct tcp_hdr *tcp;
 	struct udp_hdr *udp;
+	void *data;
 	int ret = 0;
 
 	key.ip_dst = rte_be_to_cpu_32(ipv4_hdr->dst_addr);
@@ -431,8 +441,9 @@ get_dst_port(struct ipv4_hdr *ipv4_hdr,  uint8_t portid, lookup_struct_t * l3fwd
 	}
 
 	/* Find destination port */
-	ret = rte_hash_lookup(l3fwd_lookup_struct, (const void *)&key);
-	return (uint8_t)((ret < 0)? portid : l3fwd_out_if[ret]);
+	ret = rte_hash_lookup_data(l3fwd_lookup_struct, (const void *)&key,
+				   &data);
+	return (uint8_t)((ret < 0)? portid : (uintptr_t)data);
 }
 #endif
 
@@ -490,6 +501,74 @@ l3fwd_simple_forward(struct rte_mbuf *m, uint8_t portid, lookup_struct_t * l3fwd
 
 }
 
+/*
+ * Create the epoll set holding the interrupts of all the RX queues of the
+ * lcore. Return -1 if a queue has no interrupt, in which case the lcore
+ * keeps on polling.
+ */
+static int
+power_init(struct lcore_conf *qconf, unsigned lcore_id)
+{
+	uint8_t portid, queueid;
+	int i, epfd, ret;
+
+	epfd = epoll_create(1);
+	if (epfd < 0) {
+		RTE_LOG(ERR, L3FWD, "lcore %u cannot create epoll set, "
+			"power mode disabled\n", lcore_id);
+		return -1;
+	}
+
+	for (i = 0; i < qconf->n_rx_queue; i++) {
+		portid = qconf->rx_queue_list[i].port_id;
+		queueid = qconf->rx_queue_list[i].queue_id;
+		ret = rte_eth_dev_rx_queue_intr_add(portid, queueid, epfd);
+		if (ret < 0) {
+			RTE_LOG(ERR, L3FWD, "lcore %u cannot wait on port %hhu "
+				"queue %hhu (%d), power mode disabled\n",
+				lcore_id, portid, queueid, ret);
+			close(epfd);
+			return -1;
+		}
+	}
+
+	return epfd;
+}
+
+/*
+ * Sleep until a packet is received on any RX queue of the lcore, or until
+ * the sleep timeout expires. Return a negative value if the interrupts
+ * cannot be used, in which case the lcore does not sleep.
+ */
+static int
+power_sleep(struct lcore_conf *qconf, int epfd)
+{
+	uint8_t portid, queueid;
+	int i, n, ret = 0;
+
+	for (n = 0; n < qconf->n_rx_queue; n++) {
+		portid = qconf->rx_queue_list[n].port_id;
+		queueid = qconf->rx_queue_list[n].queue_id;
+		ret = rte_eth_dev_rx_queue_intr_enable(portid, queueid);
+		if (ret < 0)
+			break;
+	}
+
+	/* do not sleep unless all queues can wake us up */
+	if (n == qconf->n_rx_queue)
+		ret = rte_intr_wait_epoll(epfd, POWER_SLEEP_TIMEOUT_MS);
+
+	/* right after waking up, as this also re-arms the interrupt of the
+	 * ports for the lcores still sleeping on their other queues */
+	for (i = 0; i < n; i++) {
+		portid = qconf->rx_queue_list[i].port_id;
+		queueid = qconf->rx_queue_list[i].queue_id;
+		rte_eth_dev_rx_queue_intr_disable(portid, queueid);
+	}
+
+	return ret < 0 ? ret : 0;
+}
+
 /* main processing loop */
 static __attribute__((noreturn)) int
 main_loop(__attribute__((unused)) void *dummy)
@@ -498,7 +577,9 @@ main_loop(__attribute__((unused)) void *dummy)
 	unsigned lcore_id;
 	uint64_t prev_tsc = 0;
 	uint64_t diff_tsc, cur_tsc;
-	int i, j, nb_rx;
+	int i, j, nb_rx, nb_rx_total;
+	unsigned idle_polls = 0;
+	int power_epfd = -1;
 	uint8_t portid, queueid;
 	struct lcore_conf *qconf;
 
@@ -520,6 +601,9 @@ main_loop(__attribute__((unused)) void *dummy)
 			portid, queueid);
 	}
 
+	if (power_on)
+		power_epfd = power_init(qconf, lcore_id);
+
 	while (1) {
 
 		cur_tsc = rte_rdtsc();
@@ -549,11 +633,13 @@ main_loop(__attribute__((unused)) void *dummy)
 		/*
 		 * Read packet from RX queues
 		 */
+		nb_rx_total = 0;
 		for (i = 0; i < qconf->n_rx_queue; ++i) {
 
 			portid = qconf->rx_queue_list[i].port_id;
 			queueid = qconf->rx_queue_list[i].queue_id;
 			nb_rx = rte_eth_rx_burst(portid, queueid, pkts_burst, MAX_PKT_BURST);
+			nb_rx_total += nb_rx;
 
 			/* Prefetch first packets */
 			for (j = 0; j < PREFETCH_OFFSET && j < nb_rx; j++) {
@@ -573,6 +659,33 @@ main_loop(__attribute__((unused)) void *dummy)
 				l3fwd_simple_forward(pkts_burst[j], portid, qconf->lookup_struct);
 			}
 		}
+
+		/*
+		 * Power mode: once the RX queues have been idle for a while,
+		 * flush the TX queues and sleep until packets are received.
+		 */
+		if (power_epfd < 0)
+			continue;
+		if (nb_rx_total != 0) {
+			idle_polls = 0;
+			continue;
+		}
+		if (++idle_polls < POWER_IDLE_POLLS_MAX)
+			continue;
+
+		for (portid = 0; portid < MAX_PORTS; portid++) {
+			if (qconf->tx_mbufs[portid].len == 0)
+				continue;
+			send_burst(qconf, qconf->tx_mbufs[portid].len, portid);
+			qconf->tx_mbufs[portid].len = 0;
+		}
+		if (power_sleep(qconf, power_epfd) < 0) {
+			RTE_LOG(ERR, L3FWD, "lcore %u cannot sleep on RX "
+				"interrupts, power mode disabled\n", lcore_id);
+			close(power_epfd);
+			power_epfd = -1;
+		}
+		idle_polls = 0;
 	}
 }
 
@@ -668,7 +781,8 @@ print_usage(const char *prgname)
 		"  [--config (port,queue,lcore)[,(port,queue,lcore]]\n"
 		"  -p PORTMASK: hexadecimal bitmask of ports to configure\n"
 		"  --config (port,queue,lcore): rx queues configuration\n"
-		"  --no-numa: optional, disable numa awareness\n",
+		"  --no-numa: optional, disable numa awareness\n"
+		"  --power: optional, sleep on RX interrupts when queues are idle\n",
 		prgname);
 }
 
@@ -751,6 +865,7 @@ parse_args(int argc, char **argv)
 	static struct option lgopts[] = {
 		{"config", 1, 0, 0},
 		{"no-numa", 0, 0, 0},
+		{"power", 0, 0, 0},
 		{NULL, 0, 0, 0}
 	};
 
@@ -789,6 +904,12 @@ parse_args(int argc, char **argv)
 				printf("numa is disabled \n");
 				numa_on = 0;
 			}
+
+			if (!strcmp(lgopts[option_index].name, "power")) {
+				printf("power mode is enabled\n");
+				power_on = 1;
+				port_conf.intr_conf.rxq = 1;
+			}
 			break;
 
 		default:
@@ -836,13 +957,13 @@ setup_hash(int socketid)
 
 	/* populate the hash */
 	for (i = 0; i < L3FWD_NUM_ROUTES; i++) {
-		ret = rte_hash_add_key (l3fwd_lookup_struct[socketid],
-				(void *) &l3fwd_route_array[i].key);
+		ret = rte_hash_add_key_data(l3fwd_lookup_struct[socketid],
+				(void *) &l3fwd_route_array[i].key,
+				(void *)(uintptr_t)l3fwd_route_array[i].if_out);
 		if (ret < 0) {
 			rte_exit(EXIT_FAILURE, "Unable to add entry %u to the"
 				"l3fwd hash on socket %d\n", i, socketid);
 		}
-		l3fwd_out_if[ret] = l3fwd_route_array[i].if_out;
 		printf("Hash: Adding key\n");
 		print_key(l3fwd_route_array[i].key);
 	}
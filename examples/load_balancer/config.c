@@ -88,6 +88,8 @@ static const char usage[] =
 "    --tx \"(PORT, LCORE), ...\" : List of NIC TX ports handled by the I/O TX   \n"
 "           lcores                                                              \n"
 "    --w \"LCORE, ...\" : List of the worker lcores                             \n"
+"    --w auto : Use as worker lcores one enabled lcore per physical core which \n"
+"           is not used by I/O lcores, on the sockets of the I/O lcores first  \n"
 "    --lpm \"IP / PREFIX => PORT; ...\" : List of LPM rules used by the worker  \n"
 "           lcores for packet forwarding                                        \n"
 "                                                                               \n"
@@ -401,6 +403,61 @@ parse_arg_w(const char *arg)
 	return 0;
 }
 
+/*
+ * Select the worker lcores: at most one lcore per physical core, not
+ * on the physical cores of the I/O lcores, to avoid sharing the core
+ * resources with the I/O lcores. The lcores on the sockets of the I/O
+ * lcores are selected first, as they share the L3 cache with them.
+ */
+static int
+app_assign_worker_lcores(void)
+{
+	unsigned lcores[RTE_MAX_LCORE];
+	unsigned n_io = 0, n = 0, n_workers, i;
+	uint32_t lcore;
+
+	for (lcore = 0; lcore < APP_MAX_LCORES; lcore ++) {
+		if (app.lcore_params[lcore].type == e_APP_LCORE_IO) {
+			lcores[n ++] = lcore;
+		}
+	}
+	n_io = n;
+
+	for (i = 0; i < n_io; i ++) {
+		rte_lcore_select_per_core(rte_lcore_to_socket_id(lcores[i]), 0,
+			lcores, &n, RTE_MAX_LCORE);
+	}
+	rte_lcore_select_per_core(SOCKET_ID_ANY, 0, lcores, &n, RTE_MAX_LCORE);
+
+	/* The number of workers must be a power of 2 */
+	n_workers = n - n_io;
+	if (n_workers > APP_MAX_WORKER_LCORES) {
+		n_workers = APP_MAX_WORKER_LCORES;
+	}
+	if (n_workers == 0) {
+		return -1;
+	}
+	while ((n_workers & (n_workers - 1)) != 0) {
+		n_workers &= n_workers - 1;
+	}
+
+	/* Validate all the selected lcores before assigning any of them */
+	for (i = n_io; i < n_io + n_workers; i ++) {
+		if (lcores[i] >= APP_MAX_LCORES) {
+			return -2;
+		}
+	}
+
+	for (i = n_io; i < n_io + n_workers; i ++) {
+		app.lcore_params[lcores[i]].type = e_APP_LCORE_WORKER;
+		printf("Worker lcore %u (socket %u, core %u)\n", lcores[i],
+			rte_lcore_to_socket_id(lcores[i]),
+			rte_lcore_to_core_id(lcores[i]));
+	}
+
+	return 0;
+}
+
 #ifndef APP_ARG_LPM_MAX_CHARS
 #define APP_ARG_LPM_MAX_CHARS     4096
 #endif
@@ -638,6 +695,7 @@ app_parse_args(int argc, char **argv)
 		{NULL, 0, 0, 0}
 	};
 	uint32_t arg_w = 0;
+	uint32_t arg_w_auto = 0;
 	uint32_t arg_rx = 0;
 	uint32_t arg_tx = 0;
 	uint32_t arg_lpm = 0;
@@ -669,7 +727,13 @@ app_parse_args(int argc, char **argv)
 					return -1;
 				}
 			}
-			if (!strcmp(lgopts[option_index].name, "w")) {
+			if (!strcmp(lgopts[option_index].name, "w") &&
+			    !strcmp(optarg, "auto")) {
+				/* workers are selected once I/O lcores are known */
+				arg_w = 1;
+				arg_w_auto = 1;
+			}
+			else if (!strcmp(lgopts[option_index].name, "w")) {
 				arg_w = 1;
 				ret = parse_arg_w(optarg);
 				if (ret) {
@@ -722,6 +786,14 @@ app_parse_args(int argc, char **argv)
 		return -1;
 	}
 
+	if (arg_w_auto) {
+		ret = app_assign_worker_lcores();
+		if (ret) {
+			printf("Cannot select worker lcores automatically (%d)\n", ret);
+			return -1;
+		}
+	}
+
 	/* Assign default values for the optional arguments not provided */
 	if (arg_rsz == 0) {
 		app.nic_rx_ring_size = APP_DEFAULT_NIC_RX_RING_SIZE;
@@ -0,0 +1,80 @@
+/*-
+ *   BSD LICENSE
+ * 
+ *   Copyright(c) 2010-2012 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ * 
+ *   Redistribution and use in source and binary forms, with or without 
+ *   modification, are permitted provided that the following conditions 
+ *   are met:
+ * 
+ *     * Redistributions of source code must retain the above copyright 
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright 
+ *       notice, this list of conditions and the following disclaimer in 
+ *       the documentation and/or other materials provided with the 
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its 
+ *       contributors may be used to endorse or promote products derived 
+ *       from this software without specific prior written permission.
+ * 
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *  version: DPDK.L.1.2.3-3
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include <rte_histogram.h>
+
+/* add the content of a histogram to another one */
+void
+rte_histogram_merge(struct rte_histogram *dst,
+		    const struct rte_histogram *src)
+{
+	unsigned i;
+
+	dst->count += src->count;
+	dst->sum += src->sum;
+	if (src->max > dst->max)
+		dst->max = src->max;
+	for (i = 0; i < RTE_HISTOGRAM_BUCKETS; i++)
+		dst->bucket[i] += src->bucket[i];
+}
+
+/* dump a histogram on the console */
+void
+rte_histogram_dump(const char *name, const char *unit,
+		   const struct rte_histogram *h)
+{
+	unsigned i;
+
+	printf("%s (%s): count=%"PRIu64" avg=%"PRIu64" max=%"PRIu64"\n",
+	       name, unit, h->count,
+	       h->count == 0 ? 0 : h->sum / h->count, h->max);
+
+	for (i = 0; i < RTE_HISTOGRAM_BUCKETS; i++) {
+		if (h->bucket[i] == 0)
+			continue;
+		if (i == 0)
+			printf("  %20u: %"PRIu64"\n", 0, h->bucket[i]);
+		else if (i == RTE_HISTOGRAM_BUCKETS - 1)
+			printf("  >= %17"PRIu64": %"PRIu64"\n",
+			       (uint64_t)1 << (i - 1), h->bucket[i]);
+		else
+			printf("  < %18"PRIu64": %"PRIu64"\n",
+			       (uint64_t)1 << i, h->bucket[i]);
+	}
+}
@@ -66,6 +66,27 @@ rte_eal_wait_lcore(unsigned slave_id)
 	return lcore_config[slave_id].ret;
 }
 
+/*
+ * Check whether a lcore finished its job, without waiting.
+ */
+int
+rte_eal_poll_lcore(unsigned slave_id, int *ret)
+{
+	int val = 0;
+
+	if (lcore_config[slave_id].state == RUNNING)
+		return -EBUSY;
+
+	if (lcore_config[slave_id].state == FINISHED) {
+		rte_rmb();
+		val = lcore_config[slave_id].ret;
+		lcore_config[slave_id].state = WAIT;
+	}
+	if (ret != NULL)
+		*ret = val;
+	return 0;
+}
+
 /*
  * Check that every SLAVE lcores are in WAIT state, then call
  * rte_eal_remote_launch() for all of them. If call_master is true
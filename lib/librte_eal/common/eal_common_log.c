@@ -43,6 +43,8 @@
 #include <inttypes.h>
 #include <errno.h>
 #include <sys/queue.h>
+#include <pthread.h>
+#include <sched.h>
 
 #include <rte_log.h>
 #include <rte_memory.h>
@@ -60,6 +62,7 @@
 #include <rte_branch_prediction.h>
 #include <rte_ring.h>
 #include <rte_mempool.h>
+#include <rte_string_fns.h>
 
 #include "eal_private.h"
 
@@ -68,6 +71,10 @@
 
 #define LOG_HISTORY_MP_NAME "log_history"
 
+#define LOG_ASYNC_MSG_SIZE     256  /* longer messages are truncated */
+#define LOG_ASYNC_BURST        32
+#define LOG_ASYNC_IDLE_US      1000 /* log thread sleep when rings are empty */
+
 STAILQ_HEAD(log_history_list, log_history);
 
 /**
@@ -90,20 +97,62 @@ struct rte_logs rte_logs = {
 	.file = NULL,
 };
 
+/* effective log levels, all types enabled at debug level by default */
+uint8_t rte_log_levels[RTE_MAX_LCORE][RTE_LOG_NB_TYPES] = {
+	[0 ... RTE_MAX_LCORE - 1] = {
+		[0 ... RTE_LOG_NB_TYPES - 1] = RTE_LOG_DEBUG,
+	},
+};
+
+/* log levels set per log type and per lcore, 0 when not set */
+static uint8_t log_type_level[RTE_LOG_NB_TYPES];
+static uint8_t log_lcore_level[RTE_MAX_LCORE][RTE_LOG_NB_TYPES];
+static rte_spinlock_t log_level_lock = RTE_SPINLOCK_INITIALIZER;
+
 static rte_spinlock_t log_dump_lock = RTE_SPINLOCK_INITIALIZER;
 static rte_spinlock_t log_list_lock = RTE_SPINLOCK_INITIALIZER;
 static FILE *default_log_stream;
 static int history_enabled = 1;
 
 /**
- * This global structure stores some informations about the message
- * that is currently beeing processed by one lcore
+ * This per-lcore structure stores some informations about the message
+ * that is currently beeing processed by one thread. It is thread-local,
+ * so that the log thread and the interrupt thread do not overwrite the
+ * one of the master lcore.
  */
 struct log_cur_msg {
 	uint32_t loglevel; /**< log level - see rte_log.h */
 	uint32_t logtype;  /**< log type  - see rte_log.h */
+};
+static RTE_DEFINE_PER_LCORE(struct log_cur_msg, log_cur_msg);
+
+/**
+ * A log message queued by an lcore for the log thread.
+ */
+struct log_async_msg {
+	uint32_t loglevel; /**< log level - see rte_log.h */
+	uint32_t logtype;  /**< log type  - see rte_log.h */
+	unsigned size;     /**< length of the formatted message */
+	char buf[LOG_ASYNC_MSG_SIZE];
+};
+
+/**
+ * Asynchronous log path of one lcore: messages are taken from the free
+ * ring, formatted, and put in the pending ring that the log thread
+ * drains. Both rings are multi-producer so that threads that are not
+ * EAL lcores, which all see lcore_id 0, can share the rings of lcore 0.
+ */
+struct log_async_lcore {
+	struct rte_ring *free;    /**< messages available to the lcore */
+	struct rte_ring *pending; /**< messages to be written */
+	rte_atomic64_t logged;    /**< messages queued to the log thread */
+	rte_atomic64_t dropped;   /**< messages dropped, ring full */
 } __rte_cache_aligned;
-static struct log_cur_msg log_cur_msg[RTE_MAX_LCORE]; /**< per core log */
+
+static struct log_async_lcore log_async_lcore[RTE_MAX_LCORE];
+static volatile int log_async_enabled = 0;
+static volatile int log_async_stop = 0;
+static pthread_t log_async_thread;
 
 /* early logs */
 
@@ -230,37 +279,104 @@ rte_openlog_stream(FILE *f)
 	return 0;
 }
 
+/*
+ * Compute the effective log levels read by RTE_LOG(). It must be called
+ * with log_level_lock held.
+ */
+static void
+log_levels_update(void)
+{
+	unsigned lcore_id, i;
+	uint8_t level;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		for (i = 0; i < RTE_LOG_NB_TYPES; i++) {
+			if ((rte_logs.type & (1U << i)) == 0)
+				level = 0;
+			else if (log_lcore_level[lcore_id][i] != 0)
+				level = log_lcore_level[lcore_id][i];
+			else if (log_type_level[i] != 0)
+				level = log_type_level[i];
+			else
+				level = (uint8_t)rte_logs.level;
+			rte_log_levels[lcore_id][i] = level;
+		}
+	}
+}
+
 /* Set global log level */
 void
 rte_set_log_level(uint32_t level)
 {
+	rte_spinlock_lock(&log_level_lock);
 	rte_logs.level = (uint32_t)level;
+	log_levels_update();
+	rte_spinlock_unlock(&log_level_lock);
 }
 
 /* Set global log type */
 void
 rte_set_log_type(uint32_t type, int enable)
 {
+	rte_spinlock_lock(&log_level_lock);
 	if (enable)
 		rte_logs.type |= type;
 	else
 		rte_logs.type &= (~type);
+	log_levels_update();
+	rte_spinlock_unlock(&log_level_lock);
+}
+
+/* Set the log level of some log types */
+int
+rte_set_log_type_level(uint32_t type, uint32_t level)
+{
+	unsigned i;
+
+	if (level > RTE_LOG_DEBUG)
+		return -EINVAL;
+
+	rte_spinlock_lock(&log_level_lock);
+	for (i = 0; i < RTE_LOG_NB_TYPES; i++) {
+		if (type & (1U << i))
+			log_type_level[i] = (uint8_t)level;
+	}
+	log_levels_update();
+	rte_spinlock_unlock(&log_level_lock);
+
+	return 0;
+}
+
+/* Set the log level of some log types on one lcore */
+int
+rte_set_log_lcore_level(unsigned lcore_id, uint32_t type, uint32_t level)
+{
+	unsigned i;
+
+	if (lcore_id >= RTE_MAX_LCORE || level > RTE_LOG_DEBUG)
+		return -EINVAL;
+
+	rte_spinlock_lock(&log_level_lock);
+	for (i = 0; i < RTE_LOG_NB_TYPES; i++) {
+		if (type & (1U << i))
+			log_lcore_level[lcore_id][i] = (uint8_t)level;
+	}
+	log_levels_update();
+	rte_spinlock_unlock(&log_level_lock);
+
+	return 0;
 }
 
 /* get the current loglevel for the message beeing processed */
 int rte_log_cur_msg_loglevel(void)
 {
-	unsigned lcore_id;
-	lcore_id = rte_lcore_id();
-	return log_cur_msg[lcore_id].loglevel;
+	return RTE_PER_LCORE(log_cur_msg).loglevel;
 }
 
 /* get the current logtype for the message beeing processed */
 int rte_log_cur_msg_logtype(void)
 {
-	unsigned lcore_id;
-	lcore_id = rte_lcore_id();
-	return log_cur_msg[lcore_id].logtype;
+	return RTE_PER_LCORE(log_cur_msg).logtype;
 }
 
 /* Dump log history on console */
@@ -304,6 +420,263 @@ rte_log_dump_history(void)
 	rte_spinlock_unlock(&log_dump_lock);
 }
 
+/*
+ * Format a log message in a message of the rings of the lcore, without
+ * taking any lock. Returns -ENOBUFS if the message is dropped.
+ */
+static int
+log_async_vlog(struct log_async_lcore *la, uint32_t level, uint32_t logtype,
+	       const char *format, va_list ap)
+{
+	struct log_async_msg *msg;
+	void *obj;
+	int ret;
+
+	if (rte_ring_dequeue(la->free, &obj) < 0) {
+		rte_atomic64_inc(&la->dropped);
+		return -ENOBUFS;
+	}
+	msg = obj;
+
+	ret = vsnprintf(msg->buf, sizeof(msg->buf), format, ap);
+	if (ret < 0)
+		ret = 0;
+	else if (ret >= (int)sizeof(msg->buf))
+		ret = sizeof(msg->buf) - 1;
+	msg->size = ret;
+	msg->loglevel = level;
+	msg->logtype = logtype;
+
+	/* cannot fail: the pending ring is as large as the free one */
+	rte_ring_enqueue(la->pending, msg);
+	rte_atomic64_inc(&la->logged);
+	return ret;
+}
+
+/*
+ * Write the messages queued by the lcores to the log stream. Returns the
+ * number of messages written.
+ */
+static unsigned
+log_async_drain(void)
+{
+	struct log_async_lcore *la;
+	struct log_async_msg *msg;
+	void *msgs[LOG_ASYNC_BURST];
+	FILE *f = rte_logs.file;
+	unsigned lcore_id, i, n, count = 0;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		la = &log_async_lcore[lcore_id];
+		if (la->pending == NULL)
+			continue;
+
+		while ((n = rte_ring_count(la->pending)) > 0) {
+			if (n > LOG_ASYNC_BURST)
+				n = LOG_ASYNC_BURST;
+			if (rte_ring_sc_dequeue_bulk(la->pending, msgs, n) < 0)
+				break;
+			for (i = 0; i < n; i++) {
+				msg = msgs[i];
+				RTE_PER_LCORE(log_cur_msg).loglevel =
+					msg->loglevel;
+				RTE_PER_LCORE(log_cur_msg).logtype =
+					msg->logtype;
+				if (fwrite(msg->buf, msg->size, 1, f) == 1)
+					fflush(f);
+			}
+			rte_ring_enqueue_bulk(la->free, msgs, n);
+			count += n;
+		}
+	}
+
+	return count;
+}
+
+/* Background thread writing the asynchronous logs. */
+static void *
+log_async_thread_main(__attribute__((unused)) void *arg)
+{
+	while (log_async_stop == 0) {
+		if (log_async_drain() == 0)
+			usleep(LOG_ASYNC_IDLE_US);
+	}
+	log_async_drain();
+
+	return NULL;
+}
+
+/*
+ * Create the rings of all enabled lcores, the first time only. Memory
+ * zones cannot be freed, so if an allocation fails, the zones and rings
+ * already created are kept, and looked up by the next call instead of
+ * being created again. The lcores only use their rings once all of them
+ * are allocated.
+ */
+static int
+log_async_rings_create(unsigned ring_size)
+{
+	const struct rte_memzone *mz[RTE_MAX_LCORE];
+	struct rte_ring *free_r[RTE_MAX_LCORE];
+	struct rte_ring *pending_r[RTE_MAX_LCORE];
+	struct log_async_lcore *la;
+	struct log_async_msg *msgs;
+	char name[RTE_MEMZONE_NAMESIZE];
+	unsigned lcore_id, i, nb_msgs;
+	int socket_id;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		la = &log_async_lcore[lcore_id];
+		if (!rte_lcore_is_enabled(lcore_id) || la->pending != NULL)
+			continue;
+
+		/* a ring of N entries holds N - 1 objects */
+		socket_id = rte_lcore_to_socket_id(lcore_id);
+		rte_snprintf(name, sizeof(name), "log_msgs_%u", lcore_id);
+		mz[lcore_id] = rte_memzone_lookup(name);
+		if (mz[lcore_id] == NULL)
+			mz[lcore_id] = rte_memzone_reserve(name,
+					(ring_size - 1) * sizeof(*msgs),
+					socket_id, 0);
+		rte_snprintf(name, sizeof(name), "log_free_%u", lcore_id);
+		free_r[lcore_id] = rte_ring_lookup(name);
+		if (free_r[lcore_id] == NULL)
+			free_r[lcore_id] = rte_ring_create(name, ring_size,
+					socket_id, RING_F_SP_ENQ);
+		rte_snprintf(name, sizeof(name), "log_pending_%u", lcore_id);
+		pending_r[lcore_id] = rte_ring_lookup(name);
+		if (pending_r[lcore_id] == NULL)
+			pending_r[lcore_id] = rte_ring_create(name, ring_size,
+					socket_id, RING_F_SC_DEQ);
+		if (mz[lcore_id] == NULL || free_r[lcore_id] == NULL ||
+		    pending_r[lcore_id] == NULL) {
+			RTE_LOG(ERR, EAL, "%s(): cannot allocate async log "
+				"rings of lcore %u\n", __func__, lcore_id);
+			return -ENOMEM;
+		}
+	}
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		la = &log_async_lcore[lcore_id];
+		if (!rte_lcore_is_enabled(lcore_id) || la->pending != NULL)
+			continue;
+
+		/* the zones and rings may come from a call with another
+		 * ring size: the pending ring must hold all messages */
+		nb_msgs = mz[lcore_id]->len / sizeof(*msgs);
+		nb_msgs = RTE_MIN(nb_msgs, free_r[lcore_id]->prod.size - 1);
+		nb_msgs = RTE_MIN(nb_msgs, pending_r[lcore_id]->prod.size - 1);
+
+		msgs = mz[lcore_id]->addr;
+		for (i = 0; i < nb_msgs; i++)
+			rte_ring_enqueue(free_r[lcore_id], &msgs[i]);
+		rte_atomic64_init(&la->logged);
+		rte_atomic64_init(&la->dropped);
+		la->free = free_r[lcore_id];
+		la->pending = pending_r[lcore_id];
+	}
+
+	return 0;
+}
+
+/*
+ * Run the log thread on the CPUs that are not used by EAL lcores. It is
+ * created after the master lcore is pinned, and would otherwise run on
+ * the master lcore, which defeats the purpose of the asynchronous mode.
+ * If all CPUs run lcores, the thread can run on any of them.
+ */
+static void
+log_async_set_affinity(pthread_attr_t *attr)
+{
+	cpu_set_t cpuset;
+	long nb_cpus;
+	unsigned cpu;
+
+	nb_cpus = sysconf(_SC_NPROCESSORS_CONF);
+	if (nb_cpus <= 0 || nb_cpus > CPU_SETSIZE)
+		nb_cpus = CPU_SETSIZE;
+
+	CPU_ZERO(&cpuset);
+	for (cpu = 0; cpu < (unsigned)nb_cpus; cpu++) {
+		if (cpu >= RTE_MAX_LCORE || !rte_lcore_is_enabled(cpu))
+			CPU_SET(cpu, &cpuset);
+	}
+	if (CPU_COUNT(&cpuset) == 0) {
+		for (cpu = 0; cpu < (unsigned)nb_cpus; cpu++)
+			CPU_SET(cpu, &cpuset);
+	}
+
+	if (pthread_attr_setaffinity_np(attr, sizeof(cpuset), &cpuset) != 0)
+		RTE_LOG(WARNING, EAL, "%s(): cannot set the affinity of "
+			"the log thread\n", __func__);
+}
+
+/* Start writing the logs of the lcores from a background thread */
+int
+rte_log_async_enable(unsigned ring_size)
+{
+	pthread_attr_t attr;
+	int ret;
+
+	if (log_async_enabled)
+		return -EALREADY;
+	if (ring_size < 2 || (ring_size & (ring_size - 1)) != 0)
+		return -EINVAL;
+
+	ret = log_async_rings_create(ring_size);
+	if (ret < 0)
+		return ret;
+
+	ret = pthread_attr_init(&attr);
+	if (ret != 0)
+		return -ret;
+	log_async_set_affinity(&attr);
+
+	log_async_stop = 0;
+	ret = pthread_create(&log_async_thread, &attr,
+			log_async_thread_main, NULL);
+	pthread_attr_destroy(&attr);
+	if (ret != 0)
+		return -ret;
+
+	rte_wmb();
+	log_async_enabled = 1;
+	return 0;
+}
+
+/* Go back to synchronous logs, after all queued messages are written */
+void
+rte_log_async_disable(void)
+{
+	if (!log_async_enabled)
+		return;
+
+	log_async_enabled = 0;
+	rte_wmb();
+	log_async_stop = 1;
+	pthread_join(log_async_thread, NULL);
+}
+
+/* Get the statistics of the asynchronous log path of one lcore */
+int
+rte_log_async_get_stats(unsigned lcore_id, struct rte_log_async_stats *stats)
+{
+	struct log_async_lcore *la;
+
+	if (lcore_id >= RTE_MAX_LCORE || stats == NULL)
+		return -EINVAL;
+
+	la = &log_async_lcore[lcore_id];
+	if (la->pending == NULL) {
+		stats->logged = 0;
+		stats->dropped = 0;
+		return 0;
+	}
+	stats->logged = rte_atomic64_read(&la->logged);
+	stats->dropped = rte_atomic64_read(&la->dropped);
+	return 0;
+}
+
 /*
  * Generates a log message The message will be sent in the stream
  * defined by the previous call to rte_openlog_stream().
@@ -317,10 +690,20 @@ rte_vlog(__attribute__((unused)) uint32_t level,
 	FILE *f = rte_logs.file;
 	unsigned lcore_id;
 
-	/* save loglevel and logtype in a global per-lcore variable */
+	/*
+	 * In asynchronous mode, the message is queued to the log thread,
+	 * except for critical messages, that may precede a panic.
+	 */
 	lcore_id = rte_lcore_id();
-	log_cur_msg[lcore_id].loglevel = level;
-	log_cur_msg[lcore_id].logtype = logtype;
+	if (log_async_enabled && level > RTE_LOG_CRIT &&
+	    lcore_id < RTE_MAX_LCORE &&
+	    log_async_lcore[lcore_id].pending != NULL)
+		return log_async_vlog(&log_async_lcore[lcore_id], level,
+				logtype, format, ap);
+
+	/* save loglevel and logtype in a global per-lcore variable */
+	RTE_PER_LCORE(log_cur_msg).loglevel = level;
+	RTE_PER_LCORE(log_cur_msg).logtype = logtype;
 
 	ret = vfprintf(f, format, ap);
 	fflush(f);
@@ -95,11 +95,12 @@ rte_dump_physmem_layout(void)
 		if (mcfg->memseg[i].addr == NULL)
 			break;
 		printf("phys:0x%"PRIx64", len:0x%"PRIx64", virt:%p, "
-		       "socket_id:%"PRId32"\n",
+		       "socket_id:%"PRId32", hugepage_sz:0x%"PRIx64"\n",
 		       mcfg->memseg[i].phys_addr,
 		       mcfg->memseg[i].len,
 		       mcfg->memseg[i].addr,
-		       mcfg->memseg[i].socket_id);
+		       mcfg->memseg[i].socket_id,
+		       mcfg->memseg[i].hugepage_sz);
 	}
 }
 
@@ -85,6 +85,7 @@ rte_memzone_reserve_aligned(const char *name, uint64_t len,
 	int memseg_idx = -1;
 	uint64_t requested_len;
 	uint64_t memseg_len = 0;
+	uint64_t memseg_pgsz = 0;
 	phys_addr_t memseg_physaddr;
 	void *memseg_addr;
 	uintptr_t addr_offset;
@@ -124,6 +125,13 @@ rte_memzone_reserve_aligned(const char *name, uint64_t len,
 		return NULL;
 	}
 
+	/* an explicit size and the largest size cannot be both called for */
+	if ((flags & RTE_MEMZONE_LARGEST_PAGE) &&
+			(flags & (RTE_MEMZONE_1GB | RTE_MEMZONE_2MB))) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
 	/* zone already exist */
 	if (rte_memzone_lookup(name) != NULL) {
 		RTE_LOG(DEBUG, EAL, "%s(): memzone <%s> already exists\n",
@@ -177,12 +185,23 @@ rte_memzone_reserve_aligned(const char *name, uint64_t len,
 		if (memseg_idx == -1) {
 			memseg_idx = i;
 			memseg_len = free_memseg[i].len;
+			memseg_pgsz = free_memseg[i].hugepage_sz;
+		}
+		/* prefer segments with larger pages if asked */
+		else if ((flags & RTE_MEMZONE_LARGEST_PAGE) &&
+				free_memseg[i].hugepage_sz != memseg_pgsz) {
+			if (free_memseg[i].hugepage_sz > memseg_pgsz) {
+				memseg_idx = i;
+				memseg_len = free_memseg[i].len;
+				memseg_pgsz = free_memseg[i].hugepage_sz;
+			}
 		}
 		/* find the biggest contiguous zone */
 		else if (len == 0) {
 			if (free_memseg[i].len > memseg_len) {
 				memseg_idx = i;
 				memseg_len = free_memseg[i].len;
+				memseg_pgsz = free_memseg[i].hugepage_sz;
 			}
 		}
 		/*
@@ -192,6 +211,7 @@ rte_memzone_reserve_aligned(const char *name, uint64_t len,
 		else if (free_memseg[i].len < memseg_len) {
 			memseg_idx = i;
 			memseg_len = free_memseg[i].len;
+			memseg_pgsz = free_memseg[i].hugepage_sz;
 		}
 	}
 
@@ -203,7 +223,7 @@ rte_memzone_reserve_aligned(const char *name, uint64_t len,
 		 */
 		if ((flags & RTE_MEMZONE_SIZE_HINT_ONLY)  &&
                 ((flags & RTE_MEMZONE_1GB) || (flags & RTE_MEMZONE_2MB)))
-			return rte_memzone_reserve_aligned(name, len - align,
+			return rte_memzone_reserve_aligned(name, requested_len,
 					socket_id, 0, align);
 
 		RTE_LOG(ERR, EAL, "%s(): No appropriate segment found\n", __func__);
@@ -284,12 +304,224 @@ rte_memzone_dump(void)
 		if (mcfg->memzone[i].addr == NULL)
 			break;
 		printf("name:<%s>, phys:0x%"PRIx64", len:0x%"PRIx64""
-		       ", virt:%p, socket_id:%"PRId32"\n",
+		       ", virt:%p, socket_id:%"PRId32", hugepage_sz:0x%"PRIx64"\n",
 		       mcfg->memzone[i].name,
 		       mcfg->memzone[i].phys_addr,
 		       mcfg->memzone[i].len,
 		       mcfg->memzone[i].addr,
-		       mcfg->memzone[i].socket_id);
+		       mcfg->memzone[i].socket_id,
+		       mcfg->memzone[i].hugepage_sz);
+	}
+}
+
+/* memzone name prefixes used by the libraries, see rte_memzone_owner() */
+static const struct {
+	const char *prefix;
+	const char *owner;
+} memzone_owners[] = {
+	{ "MP_", "mempool" },
+	{ "RG_", "ring" },
+	{ "MALLOC_", "malloc" },
+	{ "HT_", "hash" },
+	{ "FBK_", "fbk_hash" },
+	{ "LPM_", "lpm" },
+	{ "rte_eth_dev_data", "ethdev" },
+};
+#define MEMZONE_NB_PREFIXES (sizeof(memzone_owners) / sizeof(memzone_owners[0]))
+#define MEMZONE_OWNER_PMD   MEMZONE_NB_PREFIXES
+#define MEMZONE_OWNER_OTHER (MEMZONE_NB_PREFIXES + 1)
+#define MEMZONE_NB_OWNERS   (MEMZONE_NB_PREFIXES + 2)
+
+/* return the index of the owner of a memzone in memzone_owners, or
+ * MEMZONE_OWNER_PMD or MEMZONE_OWNER_OTHER */
+static unsigned
+memzone_owner_idx(const struct rte_memzone *mz)
+{
+	unsigned i;
+
+	for (i = 0; i < MEMZONE_NB_PREFIXES; i++) {
+		if (strncmp(mz->name, memzone_owners[i].prefix,
+				strlen(memzone_owners[i].prefix)) == 0)
+			return i;
+	}
+	/* PMD rings are named <driver>_<ring>_<port>_<queue> */
+	if (strstr(mz->name, "_pmd_") != NULL)
+		return MEMZONE_OWNER_PMD;
+	return MEMZONE_OWNER_OTHER;
+}
+
+static const char *
+memzone_owner_name(unsigned idx)
+{
+	if (idx < MEMZONE_NB_PREFIXES)
+		return memzone_owners[idx].owner;
+	if (idx == MEMZONE_OWNER_PMD)
+		return "pmd";
+	return "other";
+}
+
+const char *
+rte_memzone_owner(const struct rte_memzone *mz)
+{
+	return memzone_owner_name(memzone_owner_idx(mz));
+}
+
+/* return 1 if the memzone is located in the memseg */
+static int
+memzone_in_memseg(const struct rte_memzone *mz, const struct rte_memseg *ms)
+{
+	return mz->addr_64 >= ms->addr_64 &&
+		mz->addr_64 + mz->len <= ms->addr_64 + ms->len;
+}
+
+/*
+ * Fill zones with the indexes of the memzones located in the memseg,
+ * sorted by address. Return the number of memzones. There are few
+ * zones, so a simple insertion sort is enough.
+ */
+static unsigned
+memseg_get_memzones(const struct rte_mem_config *mcfg, unsigned memseg_idx,
+		unsigned zones[RTE_MAX_MEMZONE])
+{
+	const struct rte_memseg *ms = &mcfg->memseg[memseg_idx];
+	unsigned i, j, n = 0;
+
+	for (i = 0; i < RTE_MAX_MEMZONE; i++) {
+		if (mcfg->memzone[i].addr == NULL)
+			break;
+		if (!memzone_in_memseg(&mcfg->memzone[i], ms))
+			continue;
+		for (j = n; j > 0 &&
+				mcfg->memzone[zones[j-1]].addr_64 >
+				mcfg->memzone[i].addr_64; j--)
+			zones[j] = zones[j-1];
+		zones[j] = i;
+		n++;
+	}
+	return n;
+}
+
+/* account a free fragment of the memseg, and print it if asked */
+static void
+memseg_free_frag(struct rte_memseg_usage *usage, const struct rte_memseg *ms,
+		uint64_t start, uint64_t end, int print)
+{
+	uint64_t len = end - start;
+
+	if (len == 0)
+		return;
+	usage->free_len += len;
+	usage->nb_free_frags++;
+	if (len > usage->largest_free_len)
+		usage->largest_free_len = len;
+	if (print)
+		printf("    free: phys:0x%"PRIx64", len:0x%"PRIx64", virt:0x%"
+				PRIx64"\n", ms->phys_addr + (start - ms->addr_64),
+				len, start);
+}
+
+/* fill the usage of a memseg, and print the zones and free fragments
+ * if asked */
+static void
+memseg_usage(const struct rte_mem_config *mcfg, unsigned memseg_idx,
+		struct rte_memseg_usage *usage, int print)
+{
+	const struct rte_memseg *ms = &mcfg->memseg[memseg_idx];
+	const struct rte_memzone *mz;
+	unsigned zones[RTE_MAX_MEMZONE];
+	uint64_t cur = ms->addr_64;
+	unsigned i, n;
+
+	memset(usage, 0, sizeof(*usage));
+	n = memseg_get_memzones(mcfg, memseg_idx, zones);
+	for (i = 0; i < n; i++) {
+		mz = &mcfg->memzone[zones[i]];
+		memseg_free_frag(usage, ms, cur, mz->addr_64, print);
+		if (print)
+			printf("    zone: <%s>, owner:%s, phys:0x%"PRIx64
+					", len:0x%"PRIx64", virt:%p\n",
+					mz->name, rte_memzone_owner(mz),
+					mz->phys_addr, mz->len, mz->addr);
+		usage->used_len += mz->len;
+		usage->nb_memzones++;
+		cur = mz->addr_64 + mz->len;
+	}
+	memseg_free_frag(usage, ms, cur, ms->addr_64 + ms->len, print);
+}
+
+int
+rte_memseg_usage_get(const struct rte_mem_config *mcfg,
+		unsigned memseg_idx, struct rte_memseg_usage *usage)
+{
+	if (mcfg == NULL)
+		mcfg = rte_eal_get_configuration()->mem_config;
+
+	if (memseg_idx >= RTE_MAX_MEMSEG || usage == NULL ||
+			mcfg->memseg[memseg_idx].addr == NULL)
+		return -EINVAL;
+
+	memseg_usage(mcfg, memseg_idx, usage, 0);
+	return 0;
+}
+
+/* Dump a report of the memory map on console */
+void
+rte_memory_map_dump(const struct rte_mem_config *mcfg)
+{
+	const struct rte_memseg *ms;
+	const struct rte_memzone *mz;
+	struct rte_memseg_usage usage;
+	uint64_t owner_len[MEMZONE_NB_OWNERS];
+	uint64_t total_len, free_len;
+	unsigned i, socket_id;
+
+	if (mcfg == NULL)
+		mcfg = rte_eal_get_configuration()->mem_config;
+
+	for (socket_id = 0; socket_id < RTE_MAX_NUMA_NODES; socket_id++) {
+		total_len = 0;
+		free_len = 0;
+		memset(owner_len, 0, sizeof(owner_len));
+
+		for (i = 0; i < RTE_MAX_MEMSEG; i++) {
+			ms = &mcfg->memseg[i];
+			if (ms->addr == NULL)
+				break;
+			if (ms->socket_id != (int32_t)socket_id)
+				continue;
+
+			if (total_len == 0)
+				printf("socket %u:\n", socket_id);
+			printf("  segment %u: phys:0x%"PRIx64", len:0x%"PRIx64
+					", virt:%p, hugepage_sz:0x%"PRIx64"\n",
+					i, ms->phys_addr, ms->len, ms->addr,
+					ms->hugepage_sz);
+			memseg_usage(mcfg, i, &usage, 1);
+			printf("    used:0x%"PRIx64", free:0x%"PRIx64
+					", free_frags:%u, largest_free:0x%"PRIx64"\n",
+					usage.used_len, usage.free_len,
+					usage.nb_free_frags, usage.largest_free_len);
+			total_len += ms->len;
+			free_len += usage.free_len;
+		}
+		if (total_len == 0)
+			continue;
+
+		for (i = 0; i < RTE_MAX_MEMZONE; i++) {
+			mz = &mcfg->memzone[i];
+			if (mz->addr == NULL)
+				break;
+			if (mz->socket_id == (int32_t)socket_id)
+				owner_len[memzone_owner_idx(mz)] += mz->len;
+		}
+
+		printf("  total:0x%"PRIx64", free:0x%"PRIx64"\n",
+				total_len, free_len);
+		for (i = 0; i < MEMZONE_NB_OWNERS; i++) {
+			if (owner_len[i] != 0)
+				printf("  %s:0x%"PRIx64"\n", memzone_owner_name(i),
+						owner_len[i]);
+		}
 	}
 }
 
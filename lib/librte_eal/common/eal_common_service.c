@@ -0,0 +1,282 @@
+/*-
+ *   BSD LICENSE
+ * 
+ *   Copyright(c) 2010-2012 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ * 
+ *   Redistribution and use in source and binary forms, with or without 
+ *   modification, are permitted provided that the following conditions 
+ *   are met:
+ * 
+ *     * Redistributions of source code must retain the above copyright 
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright 
+ *       notice, this list of conditions and the following disclaimer in 
+ *       the documentation and/or other materials provided with the 
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its 
+ *       contributors may be used to endorse or promote products derived 
+ *       from this software without specific prior written permission.
+ * 
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *  version: DPDK.L.1.2.3-3
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/queue.h>
+
+#include <rte_common.h>
+#include <rte_memory.h>
+#include <rte_memzone.h>
+#include <rte_tailq.h>
+#include <rte_eal.h>
+#include <rte_atomic.h>
+#include <rte_per_lcore.h>
+#include <rte_lcore.h>
+#include <rte_cycles.h>
+#include <rte_spinlock.h>
+#include <rte_string_fns.h>
+#include <rte_service.h>
+
+struct service {
+	char name[RTE_SERVICE_NAMESIZE]; /**< name of the service */
+	rte_service_func_t *f;           /**< function to call */
+	void *arg;                       /**< argument of f */
+	volatile int enabled;            /**< true if service is enabled */
+};
+
+/* per-lcore mapping and statistics */
+struct service_lcore {
+	/** number of calls per round of each service, 0 if not mapped */
+	volatile unsigned weight[RTE_SERVICE_MAX];
+	/** statistics of each service on this lcore */
+	struct rte_service_stats stats[RTE_SERVICE_MAX];
+	/** true when rte_service_lcore_run() must return */
+	volatile int stop;
+} __rte_cache_aligned;
+
+static struct service services[RTE_SERVICE_MAX];
+static volatile unsigned nb_services;
+static rte_spinlock_t service_lock = RTE_SPINLOCK_INITIALIZER;
+
+static struct service_lcore service_lcores[RTE_MAX_LCORE];
+
+/* return the identifier of a service, the lock must be held */
+static int
+service_lookup(const char *name)
+{
+	unsigned id;
+
+	for (id = 0; id < nb_services; id++) {
+		if (strncmp(name, services[id].name,
+			    RTE_SERVICE_NAMESIZE) == 0)
+			return id;
+	}
+	return -ENOENT;
+}
+
+/* register a service */
+int
+rte_service_register(const char *name, rte_service_func_t *f, void *arg)
+{
+	struct service *s;
+	int id;
+
+	if (name == NULL || f == NULL || name[0] == '\0' ||
+	    strnlen(name, RTE_SERVICE_NAMESIZE) == RTE_SERVICE_NAMESIZE)
+		return -EINVAL;
+
+	rte_spinlock_lock(&service_lock);
+	if (service_lookup(name) >= 0) {
+		rte_spinlock_unlock(&service_lock);
+		return -EEXIST;
+	}
+	if (nb_services == RTE_SERVICE_MAX) {
+		rte_spinlock_unlock(&service_lock);
+		return -ENOSPC;
+	}
+
+	id = nb_services;
+	s = &services[id];
+	rte_snprintf(s->name, sizeof(s->name), "%s", name);
+	s->f = f;
+	s->arg = arg;
+	s->enabled = 0;
+
+	/* lcores may browse the services while we add a new one */
+	rte_wmb();
+	nb_services++;
+	rte_spinlock_unlock(&service_lock);
+
+	return id;
+}
+
+/* get the identifier of a service from its name */
+int
+rte_service_lookup(const char *name)
+{
+	int id;
+
+	if (name == NULL)
+		return -ENOENT;
+
+	rte_spinlock_lock(&service_lock);
+	id = service_lookup(name);
+	rte_spinlock_unlock(&service_lock);
+	return id;
+}
+
+/* get the name of a service */
+const char *
+rte_service_name(unsigned id)
+{
+	if (id >= nb_services)
+		return NULL;
+	return services[id].name;
+}
+
+/* map a service on an lcore, a weight of 0 unmaps it */
+int
+rte_service_map_lcore(unsigned id, unsigned lcore_id, unsigned weight)
+{
+	if (id >= nb_services || lcore_id >= RTE_MAX_LCORE)
+		return -EINVAL;
+
+	service_lcores[lcore_id].weight[id] = weight;
+	return 0;
+}
+
+/* enable a service */
+int
+rte_service_enable(unsigned id)
+{
+	if (id >= nb_services)
+		return -EINVAL;
+
+	services[id].enabled = 1;
+	return 0;
+}
+
+/* disable a service */
+int
+rte_service_disable(unsigned id)
+{
+	if (id >= nb_services)
+		return -EINVAL;
+
+	services[id].enabled = 0;
+	return 0;
+}
+
+/* call each enabled service mapped on the calling lcore */
+unsigned
+rte_service_run_round(void)
+{
+	struct service_lcore *sl = &service_lcores[rte_lcore_id()];
+	unsigned id, n, i, weight, count = 0;
+	uint64_t start;
+
+	n = nb_services;
+	rte_rmb();
+
+	for (id = 0; id < n; id++) {
+		weight = sl->weight[id];
+		if (weight == 0 || services[id].enabled == 0)
+			continue;
+
+		start = rte_rdtsc();
+		for (i = 0; i < weight; i++)
+			services[id].f(services[id].arg);
+		sl->stats[id].cycles += rte_rdtsc() - start;
+		sl->stats[id].calls += weight;
+		count++;
+	}
+
+	return count;
+}
+
+/* run the services mapped on the calling lcore until asked to stop */
+int
+rte_service_lcore_run(__attribute__((unused)) void *arg)
+{
+	struct service_lcore *sl = &service_lcores[rte_lcore_id()];
+
+	while (sl->stop == 0) {
+		/* do not spin too hard if there is nothing to do */
+		if (rte_service_run_round() == 0)
+			rte_pause();
+	}
+	sl->stop = 0;
+
+	return 0;
+}
+
+/* ask an lcore to return from rte_service_lcore_run() */
+int
+rte_service_lcore_stop(unsigned lcore_id)
+{
+	if (lcore_id >= RTE_MAX_LCORE)
+		return -EINVAL;
+
+	service_lcores[lcore_id].stop = 1;
+	return 0;
+}
+
+/* get the statistics of a service, summed on all lcores */
+int
+rte_service_get_stats(unsigned id, struct rte_service_stats *stats)
+{
+	unsigned lcore_id;
+
+	if (id >= nb_services || stats == NULL)
+		return -EINVAL;
+
+	memset(stats, 0, sizeof(*stats));
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		stats->calls += service_lcores[lcore_id].stats[id].calls;
+		stats->cycles += service_lcores[lcore_id].stats[id].cycles;
+	}
+	return 0;
+}
+
+/* dump the services */
+void
+rte_service_dump(void)
+{
+	struct rte_service_stats stats;
+	unsigned id, lcore_id, weight;
+
+	for (id = 0; id < nb_services; id++) {
+		rte_service_get_stats(id, &stats);
+		printf("service <%s>@%u: %s, calls=%"PRIu64", cycles=%"PRIu64
+		       ", cycles/call=%"PRIu64"\n", services[id].name, id,
+		       services[id].enabled ? "enabled" : "disabled",
+		       stats.calls, stats.cycles,
+		       stats.calls ? stats.cycles / stats.calls : 0);
+
+		for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+			weight = service_lcores[lcore_id].weight[id];
+			if (weight == 0)
+				continue;
+			printf("  lcore %u: weight=%u, calls=%"PRIu64
+			       ", cycles=%"PRIu64"\n", lcore_id, weight,
+			       service_lcores[lcore_id].stats[id].calls,
+			       service_lcores[lcore_id].stats[id].cycles);
+		}
+	}
+}
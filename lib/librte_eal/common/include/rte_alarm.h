@@ -43,6 +43,16 @@
  *
  * Simple alarm-clock functionality supplied by eal.
  * Does not require hpet support.
+ *
+ * The alarms are kept in a heap, so arming and disarming an alarm are
+ * O(log n) operations. The callbacks are called by the interrupt
+ * thread, or by an lcore calling rte_eal_alarm_process() in its main
+ * loop if the alarm was armed for this lcore.
+ *
+ * rte_eal_alarm_set() and rte_eal_alarm_cancel() allocate and look for
+ * the alarms by callback. rte_eal_alarm_arm() and
+ * rte_eal_alarm_disarm() use an alarm handle provided by the caller,
+ * which avoids the allocation and the lookup.
  */
 
 #ifdef __cplusplus
@@ -50,12 +60,48 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <sys/queue.h>
+#include <rte_histogram.h>
+
+#define RTE_ALARM_STOPPED 0 /**< State: alarm is not armed. */
+#define RTE_ALARM_ARMED   1 /**< State: alarm is waiting for expiration. */
+#define RTE_ALARM_QUEUED  2 /**< State: alarm expired, waiting for its lcore. */
+
+/**
+ * Latency statistics of the alarms.
+ */
+struct rte_eal_alarm_stats {
+	/** Delay between the alarm time and the call of the callback, in
+	 *  microseconds. For the alarms armed for an lcore, this is the
+	 *  delay until they are queued for it: the time they wait for
+	 *  rte_eal_alarm_process() is not included. */
+	struct rte_histogram lateness;
+	/** Duration of the callbacks, in TSC cycles. */
+	struct rte_histogram callback;
+};
 
 /**
  * Signature of callback back function called when an alarm goes off.
  */
 typedef void (*rte_eal_alarm_callback)(void *arg);
 
+/**
+ * An alarm handle, provided by the caller of rte_eal_alarm_arm().
+ *
+ * The fields are private to the EAL. The handle must be initialized
+ * with rte_eal_alarm_handle_init() before its first use.
+ */
+struct rte_eal_alarm {
+	uint64_t expire;               /**< Expiration time, in ns. */
+	rte_eal_alarm_callback cb_fn;  /**< Callback function. */
+	void *cb_arg;                  /**< Argument of the callback. */
+	unsigned lcore_id;             /**< Lcore running the callback. */
+	int heap_idx;                  /**< Position in the heap, or -1. */
+	volatile int state;            /**< Stopped, armed or queued. */
+	int allocated;                 /**< Allocated by rte_eal_alarm_set(). */
+	TAILQ_ENTRY(rte_eal_alarm) next; /**< Next in the lcore queue. */
+};
+
 /**
  * Function to set a callback to be triggered when us microseconds
  * have expired. Accuracy of timing to the microsecond is not guaranteed. The
@@ -79,6 +125,8 @@ int rte_eal_alarm_set(uint64_t us, rte_eal_alarm_callback cb, void *cb_arg);
 
 /**
  * Function to cancel an alarm callback which has been registered before.
+ * Only the alarms set with rte_eal_alarm_set() are considered; this is an
+ * O(n) operation in the number of alarms.
  *
  * @param cb_fn
  *  alarm callback
@@ -92,6 +140,87 @@ int rte_eal_alarm_set(uint64_t us, rte_eal_alarm_callback cb, void *cb_arg);
  */
 int rte_eal_alarm_cancel(rte_eal_alarm_callback cb_fn, void *cb_arg);
 
+/**
+ * Initialize an alarm handle.
+ *
+ * @param alarm
+ *   The alarm handle to initialize.
+ */
+void rte_eal_alarm_handle_init(struct rte_eal_alarm *alarm);
+
+/**
+ * Arm an alarm, using a handle provided by the caller.
+ *
+ * The alarm expires after *ns* nanoseconds of the monotonic clock.
+ * If *lcore_id* is LCORE_ID_ANY, the callback is called by the
+ * interrupt thread; else, the expired alarm is queued for this lcore,
+ * and the callback is called by the next call to
+ * rte_eal_alarm_process() on this lcore.
+ *
+ * The alarm is stopped when its callback is called, so it can be armed
+ * again, or freed, from the callback. The handle memory must stay valid
+ * until the callback is called or the alarm is disarmed.
+ *
+ * @param alarm
+ *   The alarm handle, initialized with rte_eal_alarm_handle_init().
+ * @param ns
+ *   The time in nanoseconds before the callback is called.
+ * @param lcore_id
+ *   The lcore running the callback, or LCORE_ID_ANY for the interrupt
+ *   thread.
+ * @param cb_fn
+ *   The function to be called when the alarm expires.
+ * @param cb_arg
+ *   Pointer parameter to be passed to the callback function.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid parameter.
+ *   - (-EBUSY): The alarm is already armed, or waiting for its lcore.
+ *   - (-ENOMEM): Not enough memory.
+ */
+int rte_eal_alarm_arm(struct rte_eal_alarm *alarm, uint64_t ns,
+		      unsigned lcore_id, rte_eal_alarm_callback cb_fn,
+		      void *cb_arg);
+
+/**
+ * Disarm an alarm armed with rte_eal_alarm_arm().
+ *
+ * On success, the callback will not be called and the handle can be
+ * freed.
+ *
+ * @param alarm
+ *   The alarm handle.
+ * @return
+ *   - 0: Success.
+ *   - (-ENOENT): The alarm is not armed.
+ *   - (-EINPROGRESS): The alarm is not armed, but its callback is
+ *     running; the handle must not be freed before it returns.
+ */
+int rte_eal_alarm_disarm(struct rte_eal_alarm *alarm);
+
+/**
+ * Run the callbacks of the expired alarms armed for the calling lcore.
+ *
+ * This function must be called periodically from the main loop of the
+ * lcores given to rte_eal_alarm_arm(). It returns immediately, without
+ * taking any lock, if no alarm expired for this lcore.
+ *
+ * @return
+ *   The number of callbacks that were called.
+ */
+unsigned rte_eal_alarm_process(void);
+
+/**
+ * Get the latency statistics of the alarms.
+ *
+ * The statistics are updated each time an alarm callback is called,
+ * they are also displayed by rte_timer_dump_stats().
+ *
+ * @param stats
+ *   The structure to fill.
+ */
+void rte_eal_alarm_get_stats(struct rte_eal_alarm_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -90,6 +90,28 @@ rte_rdtsc(void)
 	return tsc.tsc_64;
 }
 
+/**
+ * Get the number of TSC cycles in one second.
+ *
+ * The TSC frequency is calibrated at EAL initialization, against HPET
+ * when it is available.
+ *
+ * @return
+ *   The number of TSC cycles in one second.
+ */
+uint64_t
+rte_get_tsc_hz(void);
+
+/**
+ * Tell if the TSC can be used as a time reference.
+ *
+ * @return
+ *   1 if the TSC runs at a constant rate and does not stop in deep
+ *   C-states (constant_tsc and nonstop_tsc cpu flags), else 0.
+ */
+int
+rte_tsc_is_invariant(void);
+
 /**
  * Return the number of HPET cycles since boot
  *
@@ -58,6 +58,7 @@ extern "C" {
 enum rte_lcore_role_t {
 	ROLE_RTE,
 	ROLE_OFF,
+	ROLE_NON_EAL, /**< lcore id used by a registered non-EAL thread */
 };
 
 /**
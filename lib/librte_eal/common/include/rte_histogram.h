@@ -0,0 +1,126 @@
+/*-
+ *   BSD LICENSE
+ * 
+ *   Copyright(c) 2010-2012 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ * 
+ *   Redistribution and use in source and binary forms, with or without 
+ *   modification, are permitted provided that the following conditions 
+ *   are met:
+ * 
+ *     * Redistributions of source code must retain the above copyright 
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright 
+ *       notice, this list of conditions and the following disclaimer in 
+ *       the documentation and/or other materials provided with the 
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its 
+ *       contributors may be used to endorse or promote products derived 
+ *       from this software without specific prior written permission.
+ * 
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *  version: DPDK.L.1.2.3-3
+ */
+
+#ifndef _RTE_HISTOGRAM_H_
+#define _RTE_HISTOGRAM_H_
+
+/**
+ * @file
+ *
+ * Latency histograms
+ *
+ * A histogram accounts values (typically durations in cycles or
+ * microseconds) in power-of-two buckets: bucket 0 counts the null
+ * values, and bucket i counts the values in [2^(i-1), 2^i). Adding a
+ * value costs a few cycles, so histograms can be updated in the fast
+ * path. A histogram is not multi-thread safe: it must be updated by a
+ * single thread, typically one per lcore, and merged for display.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define RTE_HISTOGRAM_BUCKETS 48 /**< Number of buckets of a histogram. */
+
+/**
+ * A histogram of values.
+ */
+struct rte_histogram {
+	uint64_t count; /**< Number of values. */
+	uint64_t sum;   /**< Sum of the values. */
+	uint64_t max;   /**< Highest value. */
+	uint64_t bucket[RTE_HISTOGRAM_BUCKETS]; /**< Power-of-two buckets. */
+};
+
+/**
+ * Account a value in a histogram.
+ *
+ * @param h
+ *   The histogram.
+ * @param val
+ *   The value to add.
+ */
+static inline void
+rte_histogram_add(struct rte_histogram *h, uint64_t val)
+{
+	unsigned i = 0;
+
+	if (val != 0) {
+		i = 64 - __builtin_clzll(val);
+		if (i >= RTE_HISTOGRAM_BUCKETS)
+			i = RTE_HISTOGRAM_BUCKETS - 1;
+	}
+	h->bucket[i]++;
+	h->count++;
+	h->sum += val;
+	if (val > h->max)
+		h->max = val;
+}
+
+/**
+ * Add the content of a histogram to another one.
+ *
+ * @param dst
+ *   The histogram to update.
+ * @param src
+ *   The histogram to add to dst.
+ */
+void rte_histogram_merge(struct rte_histogram *dst,
+			 const struct rte_histogram *src);
+
+/**
+ * Dump a histogram on the console.
+ *
+ * The count, average and highest value are displayed, followed by the
+ * non-empty buckets.
+ *
+ * @param name
+ *   The name of the histogram, displayed as a title.
+ * @param unit
+ *   The unit of the values (for instance "cycles" or "us").
+ * @param h
+ *   The histogram to dump.
+ */
+void rte_histogram_dump(const char *name, const char *unit,
+			const struct rte_histogram *h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_HISTOGRAM_H_ */
@@ -115,6 +115,62 @@ int rte_intr_enable(struct rte_intr_handle *intr_handle);
  */
 int rte_intr_disable(struct rte_intr_handle *intr_handle);
 
+/**
+ * It waits for the interrupt of the specified handle in the calling
+ * thread, instead of having the interrupt thread call the registered
+ * callbacks. The handle must not have callbacks registered. The
+ * interrupt is left disabled by the kernel driver once it has fired,
+ * and must be enabled again with rte_intr_enable().
+ *
+ * Several threads may wait on the same handle: they are all woken up
+ * when the interrupt fires.
+ *
+ * @param intr_handle
+ *  pointer to the interrupt handle.
+ * @param timeout
+ *  maximum time to wait in milliseconds, or -1 to wait forever.
+ *
+ * @return
+ *  - 1 if the interrupt fired.
+ *  - 0 if the timeout expired.
+ *  - On failure, a negative value.
+ */
+int rte_intr_wait(struct rte_intr_handle *intr_handle, int timeout);
+
+/**
+ * It adds the interrupt of the specified handle to an epoll set created
+ * by the caller with epoll_create(), so that the calling thread can wait
+ * for several interrupts at once with rte_intr_wait_epoll(). The same
+ * rules as for rte_intr_wait() apply. Adding a handle already in the set
+ * succeeds.
+ *
+ * @param epfd
+ *  the epoll set.
+ * @param intr_handle
+ *  pointer to the interrupt handle.
+ *
+ * @return
+ *  - On success, zero.
+ *  - On failure, a negative value.
+ */
+int rte_intr_wait_add(int epfd, struct rte_intr_handle *intr_handle);
+
+/**
+ * It waits for any of the interrupts added to an epoll set with
+ * rte_intr_wait_add().
+ *
+ * @param epfd
+ *  the epoll set.
+ * @param timeout
+ *  maximum time to wait in milliseconds, or -1 to wait forever.
+ *
+ * @return
+ *  - The number of interrupts that fired.
+ *  - 0 if the timeout expired.
+ *  - On failure, a negative value.
+ */
+int rte_intr_wait_epoll(int epfd, int timeout);
+
 #ifdef __cplusplus
 }
 #endif
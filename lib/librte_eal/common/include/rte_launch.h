@@ -77,11 +77,12 @@ typedef int (lcore_function_t)(void *);
  * rte_eal_wait_lcore().
  *
  * The MASTER lcore returns as soon as the message is sent and knows
- * nothing about the completion of f.
+ * nothing about the completion of f. The completion can be checked
+ * without blocking with rte_eal_poll_lcore().
  *
- * Note: This function is not designed to offer optimum
- * performance. It is just a practical way to launch a function on
- * another lcore at initialization time.
+ * The message is posted in a mailbox in shared memory. An idle slave
+ * lcore polls its mailbox for a few milliseconds, then sleeps on a
+ * futex: a system call is only needed to wake up a sleeping lcore.
  *
  * @param f
  *   The function to be called.
@@ -160,6 +161,26 @@ enum rte_lcore_state_t rte_eal_get_lcore_state(unsigned slave_id);
  */
 int rte_eal_wait_lcore(unsigned slave_id);
 
+/**
+ * Check whether an lcore finished its job, without waiting.
+ *
+ * To be executed on the MASTER lcore only.
+ *
+ * If the slave lcore identified by the slave_id is in a FINISHED state,
+ * store the return value of the launched function in ret and switch the
+ * lcore to the WAIT state, as rte_eal_wait_lcore() does.
+ *
+ * @param slave_id
+ *   The identifier of the lcore.
+ * @param ret
+ *   If not NULL, the return value of the function launched on the lcore
+ *   is stored here, or 0 if the lcore was in a WAIT state.
+ * @return
+ *   - 0: The lcore is in a WAIT state.
+ *   - (-EBUSY): The lcore is still in a RUNNING state.
+ */
+int rte_eal_poll_lcore(unsigned slave_id, int *ret);
+
 /**
  * Wait until all lcores finish their jobs.
  *
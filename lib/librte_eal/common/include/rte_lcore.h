@@ -91,6 +91,36 @@ rte_lcore_count(void)
 	return cfg->lcore_count;
 }
 
+/**
+ * Register the calling thread, which was not created by the EAL, as an
+ * lcore.
+ *
+ * A free lcore id (an id that is not in the coremask and not used by
+ * another registered thread) is given to the thread, so that per-lcore
+ * data like the mempool caches can be used from it. The socket of the
+ * lcore is the socket of the CPU the thread runs on when registering.
+ * The lcore is not enabled: it is not counted by rte_lcore_count() and
+ * not browsed by RTE_LCORE_FOREACH().
+ *
+ * @return
+ *   - The lcore id of the thread on success.
+ *   - (-EEXIST): The thread is an EAL thread or is already registered.
+ *   - (-ENOSPC): All lcore ids are used.
+ */
+int rte_thread_register(void);
+
+/**
+ * Unregister the calling thread, registered by rte_thread_register(),
+ * and release its lcore id. The objects still in the mempool caches of
+ * the lcore stay there and will be used by the next thread getting
+ * this lcore id.
+ *
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): The thread is not registered.
+ */
+int rte_thread_unregister(void);
+
 #include <exec-env/rte_lcore.h>
 
 #ifdef __DOXYGEN__
@@ -120,6 +150,9 @@ rte_lcore_to_socket_id(unsigned lcore_id);
 /**
  * Test if an lcore is enabled.
  *
+ * The lcore ids taken by registered non-EAL threads are not enabled:
+ * functions cannot be launched on them.
+ *
  * @param lcore_id
  *   The identifier of the lcore, which MUST be between 0 and
  *   RTE_MAX_LCORE-1.
@@ -132,7 +165,7 @@ rte_lcore_is_enabled(unsigned lcore_id)
 	struct rte_config *cfg = rte_eal_get_configuration();
 	if (lcore_id >= RTE_MAX_LCORE)
 		return 0;
-	return (cfg->lcore_role[lcore_id] != ROLE_OFF);
+	return (cfg->lcore_role[lcore_id] == ROLE_RTE);
 }
 
 /**
@@ -183,6 +216,37 @@ rte_get_next_lcore(unsigned i, int skip_master, int wrap)
 	     i<RTE_MAX_LCORE;						\
 	     i = rte_get_next_lcore(i, 1, 0))
 
+/**
+ * Select enabled lcores so that there is at most one lcore per
+ * physical core, i.e. skip the hyperthread siblings of selected
+ * lcores. The lcores are browsed in increasing order, and the lcores
+ * of the physical cores that already have an lcore in the selected
+ * array (as given by the caller in the first *nb entries) are skipped.
+ *
+ * For instance, to get one lcore per physical core on socket 1, except
+ * the master lcore:
+ *
+ *   nb = 0;
+ *   rte_lcore_select_per_core(1, 1, lcores, &nb, RTE_MAX_LCORE);
+ *
+ * @param socket_id
+ *   Only select lcores on this socket, or on any socket if
+ *   SOCKET_ID_ANY is given.
+ * @param skip_master
+ *   If true, do not select the master lcore.
+ * @param lcores
+ *   The array of selected lcores, filled from index *nb.
+ * @param nb
+ *   The number of lcores in the array, updated.
+ * @param max
+ *   The size of the array.
+ * @return
+ *   The number of lcores added to the array.
+ */
+unsigned rte_lcore_select_per_core(int socket_id, int skip_master,
+				   unsigned *lcores, unsigned *nb,
+				   unsigned max);
+
 #ifdef __cplusplus
 }
 #endif
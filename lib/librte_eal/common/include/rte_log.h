@@ -52,6 +52,8 @@ extern "C" {
 #include <stdio.h>
 #include <stdarg.h>
 
+#include <rte_per_lcore.h>
+
 /** The rte_log structure. */
 struct rte_logs {
 	uint32_t type;  /**< Bitfield with enabled logs. */
@@ -92,6 +94,18 @@ extern struct rte_logs rte_logs;
 #define RTE_LOG_INFO     7U  /**< Informational.                    */
 #define RTE_LOG_DEBUG    8U  /**< Debug-level messages.             */
 
+/** Number of log types, one per bit of the log type bitfield. */
+#define RTE_LOG_NB_TYPES 32
+
+/**
+ * Effective log level of each log type on each lcore, computed from the
+ * global level, the log type levels and the lcore levels each time one
+ * of them changes. 0 means that the log type is disabled.
+ */
+extern uint8_t rte_log_levels[RTE_MAX_LCORE][RTE_LOG_NB_TYPES];
+
+RTE_DECLARE_PER_LCORE(unsigned, _lcore_id); /**< Per core "core id". */
+
 /** The default log stream. */
 extern FILE *eal_default_log_stream;
 
@@ -133,6 +147,61 @@ void rte_set_log_level(uint32_t level);
  */
 void rte_set_log_type(uint32_t type, int enable);
 
+/**
+ * Set the log level of some log types.
+ *
+ * The level of these log types no longer follows the global log level
+ * set by rte_set_log_level().
+ *
+ * @param type
+ *   Log types, for example, RTE_LOGTYPE_EAL | RTE_LOGTYPE_PMD.
+ * @param level
+ *   Log level. A value between RTE_LOG_EMERG (1) and RTE_LOG_DEBUG (8),
+ *   or 0 to follow the global log level again.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL) if the level is invalid.
+ */
+int rte_set_log_type_level(uint32_t type, uint32_t level);
+
+/**
+ * Set the log level of some log types on one lcore.
+ *
+ * This overrides the level set by rte_set_log_type_level() or
+ * rte_set_log_level() for the messages logged by this lcore only, for
+ * example to debug the queues polled by a single lcore.
+ *
+ * @param lcore_id
+ *   The lcore identifier.
+ * @param type
+ *   Log types, for example, RTE_LOGTYPE_PMD.
+ * @param level
+ *   Log level. A value between RTE_LOG_EMERG (1) and RTE_LOG_DEBUG (8),
+ *   or 0 to remove the override.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL) if the lcore or the level is invalid.
+ */
+int rte_set_log_lcore_level(unsigned lcore_id, uint32_t type, uint32_t level);
+
+/**
+ * Get the log level of a log type for the calling lcore.
+ *
+ * It takes all log levels and enabled log types into account, and is
+ * used by RTE_LOG() to filter messages with a single table lookup.
+ *
+ * @param type
+ *   Log type, for example, RTE_LOGTYPE_EAL. If several types are given,
+ *   the lowest one is used.
+ * @return
+ *   The log level, or 0 if the log type is disabled.
+ */
+static inline uint32_t
+rte_log_get_level(uint32_t type)
+{
+	return rte_log_levels[RTE_PER_LCORE(_lcore_id)][__builtin_ctz(type)];
+}
+
 /**
  * Get the current loglevel for the message being processed.
  *
@@ -191,6 +260,61 @@ void rte_log_dump_history(void);
  */
 int rte_log_add_in_history(const char *buf, size_t size);
 
+/**
+ * Statistics of the asynchronous log path of one lcore.
+ */
+struct rte_log_async_stats {
+	uint64_t logged;  /**< Messages queued to the log thread. */
+	uint64_t dropped; /**< Messages dropped because the ring was full. */
+};
+
+/**
+ * Switch the logs of the lcores to asynchronous mode.
+ *
+ * In asynchronous mode, rte_log() and rte_vlog() format the message in
+ * a per-lcore ring and return without taking any lock; a background
+ * thread, running on the CPUs that are not used by EAL lcores, writes
+ * the queued messages to the log stream. If the ring of the lcore is
+ * full, the message is dropped and counted. Messages at RTE_LOG_CRIT
+ * level or above are still written synchronously.
+ *
+ * Messages longer than 255 characters are truncated.
+ *
+ * @param ring_size
+ *   Size of the ring of each lcore, a power of 2. The rings are created
+ *   the first time this function is called and reused afterwards, so
+ *   the value is ignored on later calls.
+ * @return
+ *   - 0: Success.
+ *   - (-EALREADY) if asynchronous mode is already enabled.
+ *   - (-EINVAL) if *ring_size* is not a power of 2.
+ *   - (-ENOMEM) if the rings cannot be allocated.
+ *   - Other negative values if the log thread cannot be created.
+ */
+int rte_log_async_enable(unsigned ring_size);
+
+/**
+ * Switch the logs back to synchronous mode.
+ *
+ * This function returns once the log thread has written all the
+ * messages queued so far.
+ */
+void rte_log_async_disable(void);
+
+/**
+ * Get the statistics of the asynchronous log path of one lcore.
+ *
+ * @param lcore_id
+ *   The lcore identifier.
+ * @param stats
+ *   A pointer to a structure filled with the statistics.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL) if the parameters are invalid.
+ */
+int rte_log_async_get_stats(unsigned lcore_id,
+			    struct rte_log_async_stats *stats);
+
 /**
  * Generates a log message.
  *
@@ -277,8 +401,43 @@ int rte_vlog(uint32_t level, uint32_t logtype, const char *format, va_list ap);
  */
 #define RTE_LOG(l, t, ...)					\
 	(((RTE_LOG_ ## l <= RTE_LOG_LEVEL) &&			\
-	  (RTE_LOG_ ## l <= rte_logs.level) &&			\
-	  (RTE_LOGTYPE_ ## t & rte_logs.type)) ?		\
+	  (RTE_LOG_ ## l <= rte_log_get_level(RTE_LOGTYPE_ ## t))) ? \
+	 rte_log(RTE_LOG_ ## l,					\
+		 RTE_LOGTYPE_ ## t, # t ": " __VA_ARGS__) :	\
+	 0)
+
+/**
+ * Generates a log message from a fast path.
+ *
+ * The RTE_LOG_DP() is equivalent to RTE_LOG(), except that the messages
+ * whose level is above the RTE_LOG_DP_LEVEL configuration option are
+ * removed at compilation time. Messages that are compiled in cost a
+ * single table lookup when they are filtered at run time, so they can be
+ * enabled on one lcore with rte_set_log_lcore_level() without slowing
+ * down the others.
+ *
+ * @param l
+ *   Log level. A value between EMERG (1) and DEBUG (8). The short name is
+ *   expanded by the macro, so it cannot be an integer value.
+ * @param t
+ *   The log type, for example, EAL. The short name is expanded by the
+ *   macro, so it cannot be an integer value.
+ * @param fmt
+ *   The fmt string, as in printf(3), followed by the variable arguments
+ *   required by the format.
+ * @param args
+ *   The variable list of arguments according to the format string.
+ * @return
+ *   - 0: Success.
+ *   - Negative on error.
+ */
+#ifndef RTE_LOG_DP_LEVEL
+#define RTE_LOG_DP_LEVEL RTE_LOG_LEVEL
+#endif
+
+#define RTE_LOG_DP(l, t, ...)					\
+	(((RTE_LOG_ ## l <= RTE_LOG_DP_LEVEL) &&		\
+	  (RTE_LOG_ ## l <= rte_log_get_level(RTE_LOGTYPE_ ## t))) ? \
 	 rte_log(RTE_LOG_ ## l,					\
 		 RTE_LOGTYPE_ ## t, # t ": " __VA_ARGS__) :	\
 	 0)
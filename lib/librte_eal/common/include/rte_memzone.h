@@ -62,6 +62,7 @@ extern "C" {
 #define RTE_MEMZONE_2MB            0x00000001   /**< Use 2MB pages. */
 #define RTE_MEMZONE_1GB            0x00000002   /**< Use 1GB pages. */
 #define RTE_MEMZONE_SIZE_HINT_ONLY 0x00000004   /**< Use available page size */
+#define RTE_MEMZONE_LARGEST_PAGE   0x00000008   /**< Use largest page size */
 
 /**
  * A structure describing a memzone, which is a contiguous portion of
@@ -113,6 +114,10 @@ struct rte_memzone {
  *                                  If this flag is not set, the function
  *                                  will return error on an unavailable size
  *                                  request.
+ *   - RTE_MEMZONE_LARGEST_PAGE - Reserve from the largest page size that
+ *                                can hold the zone, falling back to smaller
+ *                                page sizes. It cannot be combined with
+ *                                RTE_MEMZONE_2MB or RTE_MEMZONE_1GB.
  * @return
  *   A pointer to a correctly-filled read-only memzone descriptor, or NULL
  *   on error.
@@ -160,6 +165,10 @@ const struct rte_memzone *rte_memzone_reserve(const char *name,
  *                                  If this flag is not set, the function
  *                                  will return error on an unavailable size
  *                                  request.
+ *   - RTE_MEMZONE_LARGEST_PAGE - Reserve from the largest page size that
+ *                                can hold the zone, falling back to smaller
+ *                                page sizes. It cannot be combined with
+ *                                RTE_MEMZONE_2MB or RTE_MEMZONE_1GB.
  * @return
  *   A pointer to a correctly-filled read-only memzone descriptor, or NULL
  *   on error.
@@ -193,6 +202,61 @@ const struct rte_memzone *rte_memzone_lookup(const char *name);
  */
 void rte_memzone_dump(void);
 
+struct rte_mem_config;
+
+/**
+ * Usage of a memory segment by memzones.
+ */
+struct rte_memseg_usage {
+	uint64_t used_len;         /**< Length covered by memzones. */
+	uint64_t free_len;         /**< Length not covered by memzones. */
+	uint64_t largest_free_len; /**< Length of the largest free fragment. */
+	unsigned nb_memzones;      /**< Number of memzones in the segment. */
+	unsigned nb_free_frags;    /**< Number of free fragments. */
+};
+
+/**
+ * Get the name of the library owning a memzone, guessed from the
+ * prefix of the memzone name ("mempool", "ring", "malloc", "hash",
+ * "fbk_hash", "lpm", "ethdev", "pmd" or "other").
+ *
+ * @param mz
+ *   The memzone.
+ * @return
+ *   A constant string naming the owner.
+ */
+const char *rte_memzone_owner(const struct rte_memzone *mz);
+
+/**
+ * Get the usage of a memory segment by the reserved memzones. Free
+ * fragments include the padding added to align memzones.
+ *
+ * @param mcfg
+ *   The memory configuration to read, or NULL for the one of the
+ *   running process. A configuration mapped from the runtime config
+ *   file of another process can be given.
+ * @param memseg_idx
+ *   Index of the memory segment in the physical memory layout.
+ * @param usage
+ *   Structure filled with the segment usage.
+ * @return
+ *   0 on success, -EINVAL if the segment does not exist.
+ */
+int rte_memseg_usage_get(const struct rte_mem_config *mcfg,
+		unsigned memseg_idx, struct rte_memseg_usage *usage);
+
+/**
+ * Dump a report of the memory map to the console: for each NUMA
+ * socket, the memory segments with their page size, the memzones and
+ * free fragments in each segment, and the amount of memory used by
+ * each owner (mempools, rings, malloc heaps...).
+ *
+ * @param mcfg
+ *   The memory configuration to read, or NULL for the one of the
+ *   running process.
+ */
+void rte_memory_map_dump(const struct rte_mem_config *mcfg);
+
 #ifdef __cplusplus
 }
 #endif
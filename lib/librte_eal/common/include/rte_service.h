@@ -0,0 +1,215 @@
+/*-
+ *   BSD LICENSE
+ * 
+ *   Copyright(c) 2010-2012 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ * 
+ *   Redistribution and use in source and binary forms, with or without 
+ *   modification, are permitted provided that the following conditions 
+ *   are met:
+ * 
+ *     * Redistributions of source code must retain the above copyright 
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright 
+ *       notice, this list of conditions and the following disclaimer in 
+ *       the documentation and/or other materials provided with the 
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its 
+ *       contributors may be used to endorse or promote products derived 
+ *       from this software without specific prior written permission.
+ * 
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *  version: DPDK.L.1.2.3-3
+ */
+
+#ifndef _RTE_SERVICE_H_
+#define _RTE_SERVICE_H_
+
+/**
+ * @file
+ *
+ * Service functions
+ *
+ * A service is a named function that has to be polled regularly, like
+ * the timer management or the collection of statistics. Instead of
+ * dedicating an lcore to each of these duties, services are mapped on
+ * one or several lcores running rte_service_lcore_run(), or called
+ * from the main loop of the application with rte_service_run_round().
+ *
+ * On each round, an lcore calls each enabled service mapped on it as
+ * many times as the weight of the mapping, in the order of service
+ * identifiers. The number of calls and the cycles spent in each
+ * service are accounted per lcore.
+ *
+ * Services can be mapped, unmapped, enabled and disabled at any time,
+ * while lcores are running them. Services can be registered from any
+ * thread, including while lcores are running other services.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define RTE_SERVICE_NAMESIZE 32 /**< Max length of a service name. */
+#define RTE_SERVICE_MAX      64 /**< Max number of services. */
+
+/**
+ * Signature of a service function.
+ */
+typedef void (rte_service_func_t)(void *arg);
+
+/**
+ * Statistics of a service.
+ */
+struct rte_service_stats {
+	uint64_t calls;  /**< Number of calls of the service function. */
+	uint64_t cycles; /**< Number of TSC cycles spent in the function. */
+};
+
+/**
+ * Register a service. The service is disabled and not mapped on any
+ * lcore.
+ *
+ * @param name
+ *   The name of the service.
+ * @param f
+ *   The function to call.
+ * @param arg
+ *   The argument given to f.
+ * @return
+ *   - The identifier of the service on success.
+ *   - (-EINVAL): Invalid name or function.
+ *   - (-EEXIST): A service with the same name is already registered.
+ *   - (-ENOSPC): The maximum number of services is reached.
+ */
+int rte_service_register(const char *name, rte_service_func_t *f, void *arg);
+
+/**
+ * Get the identifier of a service from its name.
+ *
+ * @param name
+ *   The name of the service.
+ * @return
+ *   - The identifier of the service on success.
+ *   - (-ENOENT): No service with this name.
+ */
+int rte_service_lookup(const char *name);
+
+/**
+ * Get the name of a service.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @return
+ *   The name of the service, or NULL if the identifier is invalid.
+ */
+const char *rte_service_name(unsigned id);
+
+/**
+ * Map a service on an lcore, or change the weight of the mapping.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @param lcore_id
+ *   The lcore that runs the service.
+ * @param weight
+ *   The number of calls of the service on each round of the lcore.
+ *   A weight of 0 unmaps the service from the lcore.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid service or lcore identifier.
+ */
+int rte_service_map_lcore(unsigned id, unsigned lcore_id, unsigned weight);
+
+/**
+ * Enable a service: it is called by the lcores it is mapped on.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid service identifier.
+ */
+int rte_service_enable(unsigned id);
+
+/**
+ * Disable a service. The service may still be running on some lcores
+ * when the function returns.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid service identifier.
+ */
+int rte_service_disable(unsigned id);
+
+/**
+ * Run one round of the services mapped on the calling lcore.
+ *
+ * @return
+ *   The number of services that were called.
+ */
+unsigned rte_service_run_round(void);
+
+/**
+ * Run rounds of the services mapped on the calling lcore, until
+ * rte_service_lcore_stop() is called for this lcore. This function can
+ * be launched on an lcore with rte_eal_remote_launch().
+ *
+ * @param arg
+ *   Unused.
+ * @return
+ *   0.
+ */
+int rte_service_lcore_run(void *arg);
+
+/**
+ * Ask an lcore to return from rte_service_lcore_run(). The request is
+ * kept until the lcore sees it, so it can be done just after launching
+ * the lcore. Use rte_eal_wait_lcore() to wait until it returns.
+ *
+ * @param lcore_id
+ *   The lcore running rte_service_lcore_run().
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid lcore identifier.
+ */
+int rte_service_lcore_stop(unsigned lcore_id);
+
+/**
+ * Get the statistics of a service, summed on all lcores.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @param stats
+ *   The structure filled with the statistics.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid service identifier.
+ */
+int rte_service_get_stats(unsigned id, struct rte_service_stats *stats);
+
+/**
+ * Dump the services, their mapping and their statistics.
+ */
+void rte_service_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_SERVICE_H_ */
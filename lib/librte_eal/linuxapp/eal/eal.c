@@ -49,6 +49,7 @@
 #include <errno.h>
 #include <limits.h>
 #include <errno.h>
+#include <ctype.h>
 #include <sys/mman.h>
 #include <sys/queue.h>
 
@@ -86,6 +87,7 @@
 #define OPT_NO_HUGE     "no-huge"
 #define OPT_FILE_PREFIX "file-prefix"
 #define OPT_SYSLOG      "syslog"
+#define OPT_SOCKET_MEM  "socket-mem"
 
 #define RTE_EAL_BLACKLIST_SIZE	0x100
 
@@ -282,15 +284,18 @@ eal_usage(const char *prgname)
 	       "  -b <domain:bus:devid.func>: to prevent EAL from using specified PCI device\n"
 	       "               (multiple -b options are alowed)\n"
 	       "  -m MB      : memory to allocate (default = size of hugemem)\n"
+	       "  --"OPT_SOCKET_MEM" : memory to allocate on specific \n"
+	       "                 sockets (use comma separated values)\n"
 	       "  -r NUM     : force number of memory ranks (don't detect)\n"
 	       "  -d LIB.so  : add driver (can be used multiple times)\n"
 	       "  --"OPT_SYSLOG"   : set syslog facility\n"
 	       "  --"OPT_HUGE_DIR" : directory where hugetlbfs is mounted\n"
 	       "  --"OPT_PROC_TYPE": type of this process\n"
 	       "  --"OPT_FILE_PREFIX": prefix for hugepage filenames\n"
-	       "  --"OPT_VMWARE_TSC_MAP"  : use VMware TSC map instead of native RDTSC\n\n"
+	       "  --"OPT_VMWARE_TSC_MAP"  : use VMware TSC map instead of native RDTSC\n"
+	       "  --"OPT_NO_HUGE"  : use anonymous memory (transparent hugepages)\n"
+	       "               instead of hugetlbfs, no multi-process support\n\n"
 	       "\nEAL options for DEBUG use only:\n"
-	       "  --"OPT_NO_HUGE"  : use malloc instead of hugetlbfs\n"
 	       "  --"OPT_NO_PCI"   : disable pci\n"
 	       "  --"OPT_NO_HPET"  : disable hpet\n"
 	       "  --"OPT_NO_SHCONF": no shared config (mmap'd files)\n\n",
@@ -332,6 +337,52 @@ eal_parse_coremask(const char *coremask)
 	return 0;
 }
 
+/*
+ * Parse the per-socket memory amounts given as a comma separated list
+ * of megabytes, e.g. "1024,0,1024". Sockets that are not listed get no
+ * memory.
+ */
+static int
+eal_parse_socket_mem(const char *socket_mem)
+{
+	char buf[BUFSIZ];
+	char *arg[RTE_MAX_NUMA_NODES];
+	char *end;
+	int i, len;
+
+	len = strnlen(socket_mem, sizeof(buf));
+	if (len == 0 || len == sizeof(buf))
+		return -1;
+	rte_snprintf(buf, sizeof(buf), "%s", socket_mem);
+
+	/* all other error cases will be caught by strtoull below */
+	if (!isdigit(buf[len - 1]))
+		return -1;
+
+	len = rte_strsplit(buf, sizeof(buf), arg, RTE_MAX_NUMA_NODES, ',');
+	if (len <= 0 || len > RTE_MAX_NUMA_NODES)
+		return -1;
+
+	internal_config.memory = 0;
+	for (i = 0; i < len; i++) {
+		errno = 0;
+		end = NULL;
+		internal_config.socket_mem[i] = strtoull(arg[i], &end, 10);
+		if (errno != 0 || arg[i][0] == '\0' || end == NULL ||
+				*end != '\0')
+			return -1;
+		internal_config.socket_mem[i] *= 1024ULL;
+		internal_config.socket_mem[i] *= 1024ULL;
+		internal_config.memory += internal_config.socket_mem[i];
+	}
+
+	/* check if we have a positive amount of total memory */
+	if (internal_config.memory == 0)
+		return -1;
+
+	return 0;
+}
+
 static inline uint64_t
 eal_get_hugepage_mem_size(void)
 {
@@ -433,10 +484,11 @@ eal_parse_syslog(const char *facility)
 static int
 eal_parse_args(int argc, char **argv)
 {
-	int opt, ret;
+	int opt, ret, i;
 	char **argvopt;
 	int option_index;
 	int coremask_ok = 0;
+	int mem_given = 0;
 	ssize_t blacklist_index = 0;;
 	char *prgname = argv[0];
 	static struct option lgopts[] = {
@@ -449,6 +501,7 @@ eal_parse_args(int argc, char **argv)
 		{OPT_PROC_TYPE, 1, 0, 0},
 		{OPT_FILE_PREFIX, 1, 0, 0},
 		{OPT_SYSLOG, 1, 0, 0},
+		{OPT_SOCKET_MEM, 1, 0, 0},
 		{0, 0, 0, 0}
 	};
 	struct shared_driver *solib;
@@ -456,6 +509,9 @@ eal_parse_args(int argc, char **argv)
 	argvopt = argv;
 
 	internal_config.memory = 0;
+	internal_config.force_sockets = 0;
+	for (i = 0; i < RTE_MAX_NUMA_NODES; i++)
+		internal_config.socket_mem[i] = 0;
 	internal_config.force_nrank = 0;
 	internal_config.force_nchannel = 0;
 	internal_config.hugefile_prefix = HUGEFILE_PREFIX_DEFAULT;
@@ -507,6 +563,7 @@ eal_parse_args(int argc, char **argv)
 			internal_config.memory = atoi(optarg);
 			internal_config.memory *= 1024ULL;
 			internal_config.memory *= 1024ULL;
+			mem_given = 1;
 			break;
 		/* force number of channels */
 		case 'n':
@@ -569,6 +626,15 @@ eal_parse_args(int argc, char **argv)
 					return -1;
 				}
 			}
+			else if (!strcmp(lgopts[option_index].name, OPT_SOCKET_MEM)) {
+				if (eal_parse_socket_mem(optarg) < 0) {
+					RTE_LOG(ERR, EAL, "invalid parameters for --"
+							OPT_SOCKET_MEM "\n");
+					eal_usage(prgname);
+					return -1;
+				}
+				internal_config.force_sockets = 1;
+			}
 			break;
 
 		default:
@@ -597,6 +663,12 @@ eal_parse_args(int argc, char **argv)
 		eal_usage(prgname);
 		return -1;
 	}
+	if (internal_config.force_sockets && mem_given) {
+		RTE_LOG(ERR, EAL, "Options -m and --"OPT_SOCKET_MEM" cannot be "
+				"specified at the same time\n");
+		eal_usage(prgname);
+		return -1;
+	}
 	if (index(internal_config.hugefile_prefix,'%') != NULL){
 		RTE_LOG(ERR, EAL, "Invalid char, '%%', in '"OPT_FILE_PREFIX"' option\n");
 		eal_usage(prgname);
@@ -635,7 +707,8 @@ rte_eal_init(int argc, char **argv)
 	if (fctret < 0)
 		exit(1);
 
-	if (eal_hugepage_info_init() < 0)
+	if (internal_config.no_hugetlbfs == 0 &&
+			eal_hugepage_info_init() < 0)
 		rte_panic("Cannot get hugepage information\n");
 
 	if (internal_config.memory == 0) {
@@ -692,15 +765,9 @@ rte_eal_init(int argc, char **argv)
 
 	RTE_LCORE_FOREACH_SLAVE(i) {
 
-		/*
-		 * create communication pipes between master thread
-		 * and children
-		 */
-		if (pipe(lcore_config[i].pipe_master2slave) < 0)
-			rte_panic("Cannot create pipe\n");
-		if (pipe(lcore_config[i].pipe_slave2master) < 0)
-			rte_panic("Cannot create pipe\n");
-
+		/* the mailbox of the lcore is empty */
+		lcore_config[i].launch_seq = 0;
+		lcore_config[i].sleeping = 0;
 		lcore_config[i].state = WAIT;
 
 		/* create a thread for each lcore */
@@ -33,10 +33,12 @@
  *  version: DPDK.L.1.2.3-3
  */
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
 #include <signal.h>
 #include <errno.h>
 #include <string.h>
+#include <time.h>
 #include <sys/queue.h>
 #include <sys/time.h>
 #include <sys/timerfd.h>
@@ -54,31 +56,73 @@
 #include <rte_errno.h>
 #include <rte_malloc.h>
 #include <rte_spinlock.h>
+#include <rte_cycles.h>
 #include <eal_private.h>
 
 #define NS_PER_US 1000
 #define US_PER_MS 1000
 #define MS_PER_S 1000
 #define US_PER_S (US_PER_MS * MS_PER_S)
+#define NS_PER_S (NS_PER_US * US_PER_S)
 
-struct alarm_entry {
-	LIST_ENTRY(alarm_entry) next;
-	struct timeval time;
-	rte_eal_alarm_callback cb_fn;
-	void *cb_arg;
-	volatile int executing;
-};
+/* initial size of the heap of armed alarms */
+#define ALARM_HEAP_MIN_SIZE 64
+
+TAILQ_HEAD(alarm_queue, rte_eal_alarm);
+
+/*
+ * The armed alarms are kept in a binary min-heap ordered by expiration
+ * time; each alarm knows its position in the heap so that it can be
+ * removed in O(log n). Everything is protected by alarm_list_lk.
+ */
+static struct rte_eal_alarm **alarm_heap;
+static unsigned alarm_heap_len;
+static unsigned alarm_heap_size;
+
+/*
+ * expired alarms to be run by each lcore; the alarms are linked through
+ * their handle rather than put in a ring, so that a queue can never be
+ * full and an expired alarm never has to be dropped or kept in the heap
+ */
+static struct alarm_queue alarm_lcore_queue[RTE_MAX_LCORE];
+
+/* slot of alarm_running used by the interrupt thread */
+#define ALARM_INTR_THREAD RTE_MAX_LCORE
+
+/*
+ * alarm whose callback is running on each lcore and on the interrupt
+ * thread; the handles are not touched once their callback is called,
+ * as the callback may free them
+ */
+static struct rte_eal_alarm *alarm_running[RTE_MAX_LCORE + 1];
 
-static LIST_HEAD(alarm_list, alarm_entry) alarm_list = LIST_HEAD_INITIALIZER();
 static rte_spinlock_t alarm_list_lk = RTE_SPINLOCK_INITIALIZER;
 
+/* latency statistics, protected by alarm_list_lk */
+static struct rte_eal_alarm_stats alarm_stats;
+
 static struct rte_intr_handle intr_handle = {.fd = -1 };
 static int handler_registered = 0;
 static void eal_alarm_callback(struct rte_intr_handle *hdl, void *arg);
 
+/* current time in nanoseconds, from a clock that never goes back */
+static inline uint64_t
+alarm_get_time(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * NS_PER_S + now.tv_nsec;
+}
+
 int
 rte_eal_alarm_init(void)
 {
+	unsigned lcore_id;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++)
+		TAILQ_INIT(&alarm_lcore_queue[lcore_id]);
+
 	intr_handle.type = RTE_INTR_HANDLE_ALARM;
 	/* create a timerfd file descriptor */
 	intr_handle.fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
@@ -92,141 +136,377 @@ error:
 	return -1;
 }
 
+/* swap two entries of the heap */
+static inline void
+heap_swap(unsigned i, unsigned j)
+{
+	struct rte_eal_alarm *tmp = alarm_heap[i];
+
+	alarm_heap[i] = alarm_heap[j];
+	alarm_heap[j] = tmp;
+	alarm_heap[i]->heap_idx = (int)i;
+	alarm_heap[j]->heap_idx = (int)j;
+}
+
+/* move up the entry i of the heap while it expires before its parent */
+static void
+heap_sift_up(unsigned i)
+{
+	unsigned parent;
+
+	while (i > 0) {
+		parent = (i - 1) / 2;
+		if (alarm_heap[parent]->expire <= alarm_heap[i]->expire)
+			break;
+		heap_swap(i, parent);
+		i = parent;
+	}
+}
+
+/* move down the entry i of the heap while a child expires before it */
+static void
+heap_sift_down(unsigned i)
+{
+	unsigned child;
+
+	while ((child = 2 * i + 1) < alarm_heap_len) {
+		if (child + 1 < alarm_heap_len &&
+		    alarm_heap[child + 1]->expire < alarm_heap[child]->expire)
+			child++;
+		if (alarm_heap[i]->expire <= alarm_heap[child]->expire)
+			break;
+		heap_swap(i, child);
+		i = child;
+	}
+}
+
+/* add an alarm in the heap, which must have a free entry */
+static void
+heap_insert(struct rte_eal_alarm *alarm)
+{
+	alarm->heap_idx = (int)alarm_heap_len;
+	alarm_heap[alarm_heap_len++] = alarm;
+	heap_sift_up(alarm->heap_idx);
+}
+
+/* remove an alarm from the heap */
+static void
+heap_remove(struct rte_eal_alarm *alarm)
+{
+	unsigned i = (unsigned)alarm->heap_idx;
+
+	alarm->heap_idx = -1;
+	alarm_heap_len--;
+	if (i == alarm_heap_len)
+		return;
+
+	alarm_heap[i] = alarm_heap[alarm_heap_len];
+	alarm_heap[i]->heap_idx = (int)i;
+	heap_sift_up(i);
+	heap_sift_down((unsigned)alarm_heap[i]->heap_idx);
+}
+
+/* make sure that one more alarm can be added in the heap */
+static int
+heap_reserve(void)
+{
+	struct rte_eal_alarm **heap;
+	unsigned size;
+
+	if (alarm_heap_len < alarm_heap_size)
+		return 0;
+
+	size = alarm_heap_size == 0 ? ALARM_HEAP_MIN_SIZE : alarm_heap_size * 2;
+	heap = realloc(alarm_heap, size * sizeof(*heap));
+	if (heap == NULL)
+		return -ENOMEM;
+	alarm_heap = heap;
+	alarm_heap_size = size;
+	return 0;
+}
+
+/* program the timerfd for the first alarm of the heap */
+static int
+alarm_program_timerfd(void)
+{
+	struct itimerspec atime = { .it_interval = { 0, 0 } };
+	uint64_t expire;
+
+	if (alarm_heap_len == 0)
+		return 0;
+
+	/* a null time would disarm the timer */
+	expire = alarm_heap[0]->expire;
+	if (expire == 0)
+		expire = 1;
+	atime.it_value.tv_sec = expire / NS_PER_S;
+	atime.it_value.tv_nsec = expire % NS_PER_S;
+	return timerfd_settime(intr_handle.fd, TFD_TIMER_ABSTIME, &atime, NULL);
+}
+
+/*
+ * Run the callback of an alarm from the given slot of alarm_running,
+ * with the lock held. The lock is released during the callback, which
+ * may re-arm or free the alarm: it is stopped before the call, and only
+ * the alarms allocated by rte_eal_alarm_set(), which the callback cannot
+ * reach, are touched after it.
+ */
+static void
+alarm_run(struct rte_eal_alarm *alarm, unsigned slot)
+{
+	rte_eal_alarm_callback cb_fn = alarm->cb_fn;
+	void *cb_arg = alarm->cb_arg;
+	int allocated = alarm->allocated;
+	uint64_t start;
+
+	alarm->state = RTE_ALARM_STOPPED;
+	alarm_running[slot] = alarm;
+	rte_spinlock_unlock(&alarm_list_lk);
+
+	start = rte_rdtsc();
+	cb_fn(cb_arg);
+	start = rte_rdtsc() - start;
+
+	rte_spinlock_lock(&alarm_list_lk);
+	rte_histogram_add(&alarm_stats.callback, start);
+	alarm_running[slot] = NULL;
+	if (allocated)
+		rte_free(alarm);
+}
+
+/* tell whether the callback of an alarm is running, with the lock held */
+static int
+alarm_is_running(const struct rte_eal_alarm *alarm)
+{
+	unsigned slot;
+
+	for (slot = 0; slot <= ALARM_INTR_THREAD; slot++) {
+		if (alarm_running[slot] == alarm)
+			return 1;
+	}
+	return 0;
+}
+
 static void
 eal_alarm_callback(struct rte_intr_handle *hdl __rte_unused,
 		void *arg __rte_unused)
 {
-	struct timeval now;
-	struct alarm_entry *ap;
+	struct rte_eal_alarm *alarm;
+	uint64_t now;
+
+	rte_spinlock_lock(&alarm_list_lk);
+	now = alarm_get_time();
+	while (alarm_heap_len != 0 && alarm_heap[0]->expire <= now) {
+		alarm = alarm_heap[0];
+		heap_remove(alarm);
+		/* for the alarms delivered to an lcore, this is the time
+		 * until they are queued, not until the lcore runs them */
+		rte_histogram_add(&alarm_stats.lateness,
+				  (now - alarm->expire) / NS_PER_US);
+
+		/* deliver it to its lcore */
+		if (alarm->lcore_id != (unsigned)LCORE_ID_ANY) {
+			alarm->state = RTE_ALARM_QUEUED;
+			TAILQ_INSERT_TAIL(&alarm_lcore_queue[alarm->lcore_id],
+					  alarm, next);
+			continue;
+		}
+
+		alarm_run(alarm, ALARM_INTR_THREAD);
+		now = alarm_get_time();
+	}
+
+	alarm_program_timerfd();
+	rte_spinlock_unlock(&alarm_list_lk);
+}
+
+/* initialize an alarm handle */
+void
+rte_eal_alarm_handle_init(struct rte_eal_alarm *alarm)
+{
+	memset(alarm, 0, sizeof(*alarm));
+	alarm->heap_idx = -1;
+	alarm->state = RTE_ALARM_STOPPED;
+}
+
+/* arm an alarm, with the lock held */
+static int
+alarm_arm(struct rte_eal_alarm *alarm, uint64_t ns, unsigned lcore_id,
+	  rte_eal_alarm_callback cb_fn, void *cb_arg)
+{
+	uint64_t now = alarm_get_time();
+	int ret = 0;
+
+	if (ns > UINT64_MAX - now)
+		return -EINVAL;
+
+	if (alarm->state == RTE_ALARM_ARMED ||
+	    alarm->state == RTE_ALARM_QUEUED)
+		return -EBUSY;
+
+	if (!handler_registered) {
+		ret = rte_intr_callback_register(&intr_handle,
+				eal_alarm_callback, NULL);
+		if (ret < 0)
+			return ret;
+		handler_registered = 1;
+	}
+
+	if (heap_reserve() < 0)
+		return -ENOMEM;
+
+	alarm->expire = now + ns;
+	alarm->cb_fn = cb_fn;
+	alarm->cb_arg = cb_arg;
+	alarm->lcore_id = lcore_id;
+	alarm->state = RTE_ALARM_ARMED;
+	heap_insert(alarm);
+
+	if (alarm_heap[0] == alarm)
+		ret = alarm_program_timerfd();
+
+	return ret;
+}
+
+/* arm an alarm given by the caller */
+int
+rte_eal_alarm_arm(struct rte_eal_alarm *alarm, uint64_t ns,
+		  unsigned lcore_id, rte_eal_alarm_callback cb_fn,
+		  void *cb_arg)
+{
+	int ret;
+
+	if (alarm == NULL || ns < 1 || cb_fn == NULL)
+		return -EINVAL;
+	if (lcore_id != (unsigned)LCORE_ID_ANY &&
+	    lcore_id >= RTE_MAX_LCORE)
+		return -EINVAL;
 
 	rte_spinlock_lock(&alarm_list_lk);
-	while ((ap = LIST_FIRST(&alarm_list)) !=NULL &&
-			gettimeofday(&now, NULL) == 0 &&
-			(ap->time.tv_sec < now.tv_sec || (ap->time.tv_sec == now.tv_sec &&
-						ap->time.tv_usec <= now.tv_usec))){
-		ap->executing = 1;
-		rte_spinlock_unlock(&alarm_list_lk);
-
-		ap->cb_fn(ap->cb_arg);
-
-		rte_spinlock_lock(&alarm_list_lk);
-		LIST_REMOVE(ap, next);
-		rte_free(ap);
+	ret = alarm_arm(alarm, ns, lcore_id, cb_fn, cb_arg);
+	rte_spinlock_unlock(&alarm_list_lk);
+
+	return ret;
+}
+
+/* disarm an alarm given by the caller */
+int
+rte_eal_alarm_disarm(struct rte_eal_alarm *alarm)
+{
+	int ret = 0;
+
+	rte_spinlock_lock(&alarm_list_lk);
+	switch (alarm->state) {
+	case RTE_ALARM_ARMED:
+		heap_remove(alarm);
+		alarm->state = RTE_ALARM_STOPPED;
+		break;
+	case RTE_ALARM_QUEUED:
+		TAILQ_REMOVE(&alarm_lcore_queue[alarm->lcore_id], alarm, next);
+		alarm->state = RTE_ALARM_STOPPED;
+		break;
+	default:
+		ret = alarm_is_running(alarm) ? -EINPROGRESS : -ENOENT;
+		break;
 	}
+	rte_spinlock_unlock(&alarm_list_lk);
+
+	return ret;
+}
 
-	if (!LIST_EMPTY(&alarm_list)) {
-		struct itimerspec atime = { .it_interval = { 0, 0 } };
+/* run the expired alarms delivered to the calling lcore */
+unsigned
+rte_eal_alarm_process(void)
+{
+	unsigned lcore_id = rte_lcore_id();
+	struct alarm_queue *queue = &alarm_lcore_queue[lcore_id];
+	struct rte_eal_alarm *alarm;
+	unsigned n = 0;
 
-		ap = LIST_FIRST(&alarm_list);
-		atime.it_value.tv_sec = ap->time.tv_sec;
-		atime.it_value.tv_nsec = ap->time.tv_usec * NS_PER_US;
-		/* perform borrow for subtraction if necessary */
-		if (now.tv_usec > ap->time.tv_usec)
-			atime.it_value.tv_sec--, atime.it_value.tv_nsec += US_PER_S * NS_PER_US;
+	/* unlocked check, to avoid taking the lock in the fast path */
+	if (TAILQ_EMPTY(queue))
+		return 0;
 
-		atime.it_value.tv_sec -= now.tv_sec;
-		atime.it_value.tv_nsec -= now.tv_usec * NS_PER_US;
-		timerfd_settime(intr_handle.fd, 0, &atime, NULL);
+	rte_spinlock_lock(&alarm_list_lk);
+	while ((alarm = TAILQ_FIRST(queue)) != NULL) {
+		TAILQ_REMOVE(queue, alarm, next);
+		alarm_run(alarm, lcore_id);
+		n++;
 	}
 	rte_spinlock_unlock(&alarm_list_lk);
+
+	return n;
 }
 
 int
 rte_eal_alarm_set(uint64_t us, rte_eal_alarm_callback cb_fn, void *cb_arg)
 {
-	struct timeval now;
-	int ret = 0;
-	struct alarm_entry *ap, *new_alarm;
+	struct rte_eal_alarm *new_alarm;
+	int ret;
 
 	/* Check parameters, including that us won't cause a uint64_t overflow */
-	if (us < 1 || us > (UINT64_MAX - US_PER_S) || cb_fn == NULL)
+	if (us < 1 || us > (UINT64_MAX - US_PER_S) / NS_PER_US || cb_fn == NULL)
 		return -EINVAL;
 
 	new_alarm = rte_malloc(NULL, sizeof(*new_alarm), 0);
 	if (new_alarm == NULL)
 		return -ENOMEM;
 
-	/* use current time to calculate absolute time of alarm */
-	gettimeofday(&now, NULL);
-
-	new_alarm->cb_fn = cb_fn;
-	new_alarm->cb_arg = cb_arg;
-	new_alarm->time.tv_usec = (now.tv_usec + us) % US_PER_S;
-	new_alarm->time.tv_sec = now.tv_sec + ((now.tv_usec + us) / US_PER_S);
-	new_alarm->executing = 0;
+	rte_eal_alarm_handle_init(new_alarm);
+	new_alarm->allocated = 1;
 
 	rte_spinlock_lock(&alarm_list_lk);
-	if (!handler_registered) {
-		ret |= rte_intr_callback_register(&intr_handle,
-				eal_alarm_callback, NULL);
-		handler_registered = (ret == 0) ? 1 : 0;
-	}
-
-	if (LIST_EMPTY(&alarm_list))
-		LIST_INSERT_HEAD(&alarm_list, new_alarm, next);
-	else {
-		LIST_FOREACH(ap, &alarm_list, next) {
-			if (ap->time.tv_sec > new_alarm->time.tv_sec ||
-					(ap->time.tv_sec == new_alarm->time.tv_sec &&
-							ap->time.tv_usec > new_alarm->time.tv_usec)){
-				LIST_INSERT_BEFORE(ap, new_alarm, next);
-				break;
-			}
-			if (LIST_NEXT(ap, next) == NULL) {
-				LIST_INSERT_AFTER(ap, new_alarm, next);
-				break;
-			}
-		}
-	}
-
-	if (LIST_FIRST(&alarm_list) == new_alarm) {
-		struct itimerspec alarm_time = {
-			.it_interval = {0, 0},
-			.it_value = {
-				.tv_sec = us / US_PER_S,
-				.tv_nsec = (us % US_PER_S) * NS_PER_US,
-			},
-		};
-		ret |= timerfd_settime(intr_handle.fd, 0, &alarm_time, NULL);
-	}
+	ret = alarm_arm(new_alarm, us * NS_PER_US, (unsigned)LCORE_ID_ANY,
+			cb_fn, cb_arg);
 	rte_spinlock_unlock(&alarm_list_lk);
 
+	if (ret < 0)
+		rte_free(new_alarm);
 	return ret;
 }
 
+void
+rte_eal_alarm_get_stats(struct rte_eal_alarm_stats *stats)
+{
+	rte_spinlock_lock(&alarm_list_lk);
+	*stats = alarm_stats;
+	rte_spinlock_unlock(&alarm_list_lk);
+}
+
 int
 rte_eal_alarm_cancel(rte_eal_alarm_callback cb_fn, void *cb_arg)
 {
-	struct alarm_entry *ap, *ap_prev;
+	struct rte_eal_alarm *alarm;
+	unsigned i, len = 0;
 	int count = 0;
 
 	if (!cb_fn)
 		return -1;
 
 	rte_spinlock_lock(&alarm_list_lk);
-	/* remove any matches at the start of the list */
-	while ((ap = LIST_FIRST(&alarm_list)) != NULL &&
-			cb_fn == ap->cb_fn && ap->executing == 0 &&
-			(cb_arg == (void *)-1 || cb_arg == ap->cb_arg)) {
-		LIST_REMOVE(ap, next);
-		rte_free(ap);
-		count++;
-	}
-	ap_prev = ap;
-
-	/* now go through list, removing entries not at start */
-	LIST_FOREACH(ap, &alarm_list, next) {
-		/* this won't be true first time through */
-		if (cb_fn == ap->cb_fn &&  ap->executing == 0 &&
-				(cb_arg == (void *)-1 || cb_arg == ap->cb_arg)) {
-			LIST_REMOVE(ap,next);
-			rte_free(ap);
+
+	/* remove the matching alarms from the heap array, then rebuild
+	 * the heap: this is O(n) whatever the number of matches */
+	for (i = 0; i < alarm_heap_len; i++) {
+		alarm = alarm_heap[i];
+		if (alarm->allocated && cb_fn == alarm->cb_fn &&
+		    (cb_arg == (void *)-1 || cb_arg == alarm->cb_arg)) {
+			rte_free(alarm);
 			count++;
-			ap = ap_prev;
+			continue;
 		}
-		ap_prev = ap;
+		alarm->heap_idx = (int)len;
+		alarm_heap[len++] = alarm;
 	}
+
+	if (count != 0) {
+		alarm_heap_len = len;
+		for (i = len / 2; i > 0; i--)
+			heap_sift_down(i - 1);
+		if (alarm_heap_len != 0)
+			alarm_program_timerfd();
+	}
+
 	rte_spinlock_unlock(&alarm_list_lk);
 	return count;
 }
-
@@ -43,6 +43,7 @@
 #include <inttypes.h>
 #include <sys/mman.h>
 #include <sys/queue.h>
+#include <time.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <errno.h>
@@ -63,6 +64,12 @@
 /* Maximum number of counters. */
 #define HPET_TIMER_NUM 3
 
+/* duration of the TSC calibration against HPET */
+#define TSC_CALIBRATION_MS 10
+
+/* give up the calibration if the HPET counter does not advance in time */
+#define TSC_CALIBRATION_TIMEOUT_MS (10 * TSC_CALIBRATION_MS)
+
 /* General capabilities register */
 #define CLK_PERIOD_SHIFT     32 /* Clock period shift. */
 #define CLK_PERIOD_MASK      0xffffffff00000000ULL /* Clock period mask. */
@@ -106,6 +113,12 @@ static uint32_t eal_hpet_resolution_fs = 0;
 /* Frequency of the counter in Hz */
 static uint64_t eal_hpet_resolution_hz = 0;
 
+/* Frequency of the TSC in Hz, calibrated even if HPET is used */
+static uint64_t eal_tsc_resolution_hz = 0;
+
+/* True if the TSC is constant and does not stop in deep C-states */
+static int eal_tsc_invariant = 0;
+
 /* Incremented 4 times during one 32bits hpet full count */
 static uint32_t eal_hpet_msb;
 
@@ -162,32 +175,78 @@ get_tsc_freq_from_sleep(void)
 	return rte_rdtsc() - start;
 }
 
+/* return the milliseconds elapsed since a point of the monotonic clock */
+static uint64_t
+elapsed_ms(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)(now.tv_sec - start->tv_sec) * 1000 +
+		(now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+/*
+ * Measure the TSC frequency against the HPET counter, which is much
+ * more accurate than the "cpu MHz" line of /proc/cpuinfo. Only the 32
+ * low bits of the counter are used, so the msb thread is not needed.
+ * Return 0 if the counter is stuck, so that another method is used.
+ */
+static uint64_t
+get_tsc_freq_from_hpet(void)
+{
+	struct timespec start;
+	uint32_t start_hpet, ticks;
+	uint64_t start_tsc, end_tsc;
+
+	ticks = (uint32_t)(eal_hpet_resolution_hz * TSC_CALIBRATION_MS / 1000);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	start_hpet = eal_hpet->counter_l;
+	start_tsc = rte_rdtsc();
+	while ((uint32_t)(eal_hpet->counter_l - start_hpet) < ticks) {
+		if (elapsed_ms(&start) > TSC_CALIBRATION_TIMEOUT_MS) {
+			RTE_LOG(WARNING, EAL, "WARNING: HPET counter does "
+				"not advance, cannot calibrate the TSC "
+				"against it\n");
+			return 0;
+		}
+		rte_pause();
+	}
+	end_tsc = rte_rdtsc();
+
+	return (end_tsc - start_tsc) * 1000 / TSC_CALIBRATION_MS;
+}
+
 static inline void
 set_rdtsc_freq(void)
 {
-	uint64_t freq;
-	freq = get_tsc_freq_from_cpuinfo();
+	uint64_t freq = 0;
+
+	if (eal_hpet != NULL)
+		freq = get_tsc_freq_from_hpet();
+	if (!freq)
+		freq = get_tsc_freq_from_cpuinfo();
 	if (!freq) {
 		RTE_LOG(WARNING, EAL, "WARNING: Cannot read CPU clock\n");
 		freq = get_tsc_freq_from_sleep();
 	}
 	RTE_LOG(INFO, EAL, "TSC clock @ %lu MHz\n",
 		(unsigned long) (freq / (1000000UL)));
-	eal_hpet_resolution_hz = freq;
-	eal_hpet_resolution_fs = (uint32_t)
-			((1.0 / eal_hpet_resolution_hz) / 1e-15);
+	eal_tsc_resolution_hz = freq;
 }
 
-static void
+/* return 1 if the TSC is constant and non-stop */
+static int
 check_tsc_flags(void)
 {
 	char line[512];
 	FILE *stream;
+	int invariant = 0;
 
 	stream = fopen("/proc/cpuinfo", "r");
 	if (!stream) {
 		RTE_LOG(WARNING, EAL, "WARNING: Unable to open /proc/cpuinfo\n");
-		return;
+		return 0;
 	}
 
 	while (fgets(line, sizeof line, stream)) {
@@ -199,7 +258,8 @@ check_tsc_flags(void)
 
 		constant_tsc = strstr(line, "constant_tsc");
 		nonstop_tsc = strstr(line, "nonstop_tsc");
-		if (!constant_tsc || !nonstop_tsc)
+		invariant = (constant_tsc && nonstop_tsc);
+		if (!invariant)
 			RTE_LOG(WARNING, EAL,
 				"WARNING: cpu flags "
 				"constant_tsc=%s "
@@ -211,6 +271,7 @@ check_tsc_flags(void)
 	}
 
 	fclose(stream);
+	return invariant;
 }
 
 /*
@@ -237,6 +298,7 @@ rte_eal_hpet_init(void)
 	if (eal_hpet == MAP_FAILED) {
 		RTE_LOG(WARNING, EAL, "WARNING: Cannot mmap "DEV_HPET"! "
 				"The TSC will be used instead.\n");
+		eal_hpet = NULL;
 		close(fd);
 		goto use_rdtsc;
 	}
@@ -260,12 +322,19 @@ rte_eal_hpet_init(void)
 		goto use_rdtsc;
 	}
 
+	/* the TSC is calibrated in all cases, as it may be used as the
+	 * time reference by the timer library */
+	set_rdtsc_freq();
+	eal_tsc_invariant = check_tsc_flags();
 	return 0;
 
 use_rdtsc:
 	internal_config.no_hpet = 1;
 	set_rdtsc_freq();
-	check_tsc_flags();
+	eal_tsc_invariant = check_tsc_flags();
+	eal_hpet_resolution_hz = eal_tsc_resolution_hz;
+	eal_hpet_resolution_fs = (uint32_t)
+			((1.0 / eal_hpet_resolution_hz) / 1e-15);
 	return 0;
 }
 
@@ -275,6 +344,18 @@ rte_get_hpet_hz(void)
 	return eal_hpet_resolution_hz;
 }
 
+uint64_t
+rte_get_tsc_hz(void)
+{
+	return eal_tsc_resolution_hz;
+}
+
+int
+rte_tsc_is_invariant(void)
+{
+	return eal_tsc_invariant;
+}
+
 uint64_t
 rte_get_hpet_cycles(void)
 {
@@ -44,6 +44,8 @@
 #include <string.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <sys/epoll.h>
 #include <sys/signalfd.h>
 
@@ -71,6 +73,9 @@
 
 #define EAL_INTR_EPOLL_WAIT_FOREVER (-1)
 
+/* maximum number of fds reported by one rte_intr_wait_epoll() call */
+#define EAL_INTR_WAIT_EVENTS_MAX 32
+
 /**
  * union for pipe fds.
  */
@@ -317,6 +322,120 @@ rte_intr_disable(struct rte_intr_handle *intr_handle)
 	return 0;
 }
 
+/*
+ * Check that the calling thread can wait on a handle, and make its fd
+ * non-blocking: all waiters share the same open file, so the event
+ * counter may already have been consumed by another thread when we get
+ * to read it, and read() must never block.
+ */
+static int
+intr_wait_prepare(struct rte_intr_handle *intr_handle)
+{
+	int flags;
+
+	if (!intr_handle || intr_handle->fd < 0)
+		return -1;
+
+	if (intr_handle->type != RTE_INTR_HANDLE_UIO) {
+		RTE_LOG(ERR, EAL, "Cannot wait on handle type of fd %d\n",
+				intr_handle->fd);
+		return -1;
+	}
+
+	flags = fcntl(intr_handle->fd, F_GETFL);
+	if (flags < 0)
+		return -1;
+	if (!(flags & O_NONBLOCK) &&
+	    fcntl(intr_handle->fd, F_SETFL, flags | O_NONBLOCK) < 0)
+		return -1;
+	return 0;
+}
+
+/* read out to clear the ready-to-be-read flag for poll */
+static int
+intr_wait_clear(int fd)
+{
+	uint32_t count;
+
+	if (read(fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+		RTE_LOG(ERR, EAL, "Error reading from file descriptor"
+			" %d, error: %d\n", fd, errno);
+		return -1;
+	}
+	return 0;
+}
+
+int
+rte_intr_wait(struct rte_intr_handle *intr_handle, int timeout)
+{
+	struct pollfd pfd;
+	int ret;
+
+	if (intr_wait_prepare(intr_handle) < 0)
+		return -1;
+
+	pfd.fd = intr_handle->fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	do {
+		ret = poll(&pfd, 1, timeout);
+	} while (ret < 0 && errno == EINTR);
+	if (ret < 0) {
+		RTE_LOG(ERR, EAL, "Error waiting on fd %d, error: %d\n",
+				intr_handle->fd, errno);
+		return -1;
+	}
+	if (ret == 0)
+		return 0;
+
+	if (intr_wait_clear(intr_handle->fd) < 0)
+		return -1;
+	return 1;
+}
+
+int
+rte_intr_wait_add(int epfd, struct rte_intr_handle *intr_handle)
+{
+	struct epoll_event ev;
+
+	if (epfd < 0 || intr_wait_prepare(intr_handle) < 0)
+		return -1;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = intr_handle->fd;
+	if (epoll_ctl(epfd, EPOLL_CTL_ADD, intr_handle->fd, &ev) < 0 &&
+	    errno != EEXIST) {
+		RTE_LOG(ERR, EAL, "Error adding fd %d to epoll set, "
+			"error: %d\n", intr_handle->fd, errno);
+		return -1;
+	}
+	return 0;
+}
+
+int
+rte_intr_wait_epoll(int epfd, int timeout)
+{
+	struct epoll_event events[EAL_INTR_WAIT_EVENTS_MAX];
+	int i, nfds;
+
+	do {
+		nfds = epoll_wait(epfd, events, EAL_INTR_WAIT_EVENTS_MAX,
+				  timeout);
+	} while (nfds < 0 && errno == EINTR);
+	if (nfds < 0) {
+		RTE_LOG(ERR, EAL, "Error waiting on epoll set %d, "
+			"error: %d\n", epfd, errno);
+		return -1;
+	}
+
+	for (i = 0; i < nfds; i++) {
+		if (intr_wait_clear(events[i].data.fd) < 0)
+			return -1;
+	}
+	return nfds;
+}
+
 static int
 eal_intr_process_interrupts(struct epoll_event *events, int nfds)
 {
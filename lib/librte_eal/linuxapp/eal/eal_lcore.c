@@ -40,6 +40,7 @@
 #include <inttypes.h>
 #include <string.h>
 #include <errno.h>
+#include <limits.h>
 #include <sys/queue.h>
 
 #include <rte_log.h>
@@ -51,10 +52,15 @@
 #include <rte_per_lcore.h>
 #include <rte_lcore.h>
 #include <rte_debug.h>
+#include <rte_string_fns.h>
 
 #include "eal_private.h"
 
 #define PROC_CPUINFO "/proc/cpuinfo"
+#define SYS_CPU_DIR "/sys/devices/system/cpu/cpu%u"
+#define CORE_ID_FILE "topology/core_id"
+#define CACHE_DIR "cache/index%u"
+#define CACHE_MAX_INDEX 8
 #define PROC_PROCESSOR_FMT ""
 
 /* parse one line and try to match "processor : %d". */
@@ -103,6 +109,85 @@ parse_socket_id(const char *buf, unsigned *socket_id)
 	return 0;
 }
 
+/*
+ * Read the first unsigned integer of a sysfs file of the cpu
+ * lcore_id. It works for files containing a list of cpus, like
+ * shared_cpu_list, in which case the first cpu of the list is
+ * returned.
+ */
+static int
+lcore_parse_sysfs_value(unsigned lcore_id, const char *file, unsigned *val)
+{
+	FILE *f;
+	char path[PATH_MAX];
+	char buf[BUFSIZ];
+	char *end = NULL;
+	int len;
+
+	len = rte_snprintf(path, sizeof(path), SYS_CPU_DIR "/", lcore_id);
+	if (len < 0 || len >= (int)sizeof(path))
+		return -1;
+	len = rte_snprintf(path + len, sizeof(path) - len, "%s", file);
+	if (len < 0)
+		return -1;
+
+	f = fopen(path, "r");
+	if (f == NULL)
+		return -1;
+	if (fgets(buf, sizeof(buf), f) == NULL) {
+		fclose(f);
+		return -1;
+	}
+	fclose(f);
+
+	errno = 0;
+	*val = strtoul(buf, &end, 10);
+	if (errno != 0 || end == buf)
+		return -1;
+	return 0;
+}
+
+/*
+ * Find the core id and the L2 and L3 cache domains of an lcore in
+ * sysfs. A cache domain is identified by the first cpu sharing the
+ * cache. If the information is not available, the lcore is supposed
+ * to be alone on its core and in its caches.
+ */
+static void
+lcore_get_topology(unsigned lcore_id)
+{
+	struct lcore_config *cfg = &lcore_config[lcore_id];
+	char file[PATH_MAX];
+	unsigned idx, level, first;
+
+	cfg->core_id = lcore_id;
+	cfg->l2_id = lcore_id;
+	cfg->l3_id = lcore_id;
+
+	if (lcore_parse_sysfs_value(lcore_id, CORE_ID_FILE,
+				    &cfg->core_id) < 0) {
+		RTE_LOG(DEBUG, EAL, "No topology information for lcore %u\n",
+			lcore_id);
+		cfg->core_id = lcore_id;
+	}
+
+	for (idx = 0; idx < CACHE_MAX_INDEX; idx++) {
+		rte_snprintf(file, sizeof(file), CACHE_DIR "/level", idx);
+		if (lcore_parse_sysfs_value(lcore_id, file, &level) < 0)
+			break;
+		if (level != 2 && level != 3)
+			continue;
+		rte_snprintf(file, sizeof(file), CACHE_DIR "/shared_cpu_list",
+			     idx);
+		if (lcore_parse_sysfs_value(lcore_id, file, &first) < 0)
+			continue;
+		if (level == 2)
+			cfg->l2_id = first;
+		else
+			cfg->l3_id = first;
+	}
+}
+
 /*
  * Parse /proc/cpuinfo to get the number of physical and logical
  * processors on the machine. The function will fill the cpu_info
@@ -168,6 +253,12 @@ rte_eal_cpu_init(void)
 
 			lcore_config[lcore_id].detected = 1;
 			lcore_config[lcore_id].socket_id = socket_id;
+			lcore_get_topology(lcore_id);
+			RTE_LOG(DEBUG, EAL, "lcore %u is on core %u, "
+				"L2 domain %u, L3 domain %u\n", lcore_id,
+				lcore_config[lcore_id].core_id,
+				lcore_config[lcore_id].l2_id,
+				lcore_config[lcore_id].l3_id);
 
 		}
 	}
@@ -190,3 +281,36 @@ rte_eal_cpu_init(void)
 
 	return 0;
 }
+
+/*
+ * Select enabled lcores, at most one per physical core, skipping the
+ * cores of the lcores already in the array.
+ */
+unsigned
+rte_lcore_select_per_core(int socket_id, int skip_master,
+			  unsigned *lcores, unsigned *nb, unsigned max)
+{
+	unsigned lcore_id, i, added = 0;
+
+	RTE_LCORE_FOREACH(lcore_id) {
+		if (*nb >= max)
+			break;
+		if (skip_master && lcore_id == rte_get_master_lcore())
+			continue;
+		if (socket_id != SOCKET_ID_ANY &&
+		    rte_lcore_to_socket_id(lcore_id) != (unsigned)socket_id)
+			continue;
+
+		for (i = 0; i < *nb; i++) {
+			if (lcores[i] == lcore_id ||
+			    rte_lcore_is_sibling(lcores[i], lcore_id))
+				break;
+		}
+		if (i < *nb)
+			continue;
+
+		lcores[(*nb)++] = lcore_id;
+		added++;
+	}
+	return added;
+}
@@ -51,7 +51,12 @@
 #include <unistd.h>
 #include <limits.h>
 #include <errno.h>
+#include <pthread.h>
+#include <sched.h>
 #include <sys/ioctl.h>
+#include <sys/time.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
 
 #include <rte_log.h>
 #include <rte_memory.h>
@@ -84,6 +89,9 @@
 
 #define RANDOMIZE_VA_SPACE_FILE "/proc/sys/kernel/randomize_va_space"
 
+/* page size of the anonymous memory used when hugetlbfs is disabled */
+#define NOHUGE_PAGE_SZ RTE_PGSIZE_2M
+
 /*
  * Check whether address-space layout randomization is enabled in
  * the kernel. This is important for multi-process as it can prevent
@@ -166,8 +174,10 @@ get_virtual_area(uint64_t *size, uint64_t hugepage_sz)
  * Mmap all hugepages of hugepage table: it first open a file in
  * hugetlbfs, then mmap() hugepage_sz data in it. If orig is set, the
  * virtual address is stored in hugepg_tbl[i].orig_va, else it is stored
- * in hugepg_tbl[i].final_va. The second mapping (when orig is 0) tries to
- * map continguous physical blocks in contiguous virtual blocks.
+ * in hugepg_tbl[i].final_va. The first mapping (when orig is 1) tries to
+ * map all pages in one virtual area, in file order. The second mapping
+ * (when orig is 0) tries to map continguous physical blocks in contiguous
+ * virtual blocks. Pages are not touched here, see fault_all_hugepages().
  */
 static int
 map_all_hugepages(struct hugepage *hugepg_tbl,
@@ -200,18 +210,25 @@ map_all_hugepages(struct hugepage *hugepg_tbl,
 			continue;
 		}
 #endif
-		else if (vma_len == 0) {
+
+		if (vma_len == 0) {
 			unsigned j, num_pages;
 
 			/* reserve a virtual area for next contiguous
 			 * physical block: count the number of
-			 * contiguous physical pages. */
-			for (j = i+1; j < hpi->num_pages ; j++) {
-				if (hugepg_tbl[j].physaddr !=
-				    hugepg_tbl[j-1].physaddr + hugepage_sz)
-					break;
+			 * contiguous physical pages. Physical addresses
+			 * are not known yet for the first mapping, so ask
+			 * for all the remaining pages. */
+			if (orig)
+				num_pages = hpi->num_pages - i;
+			else {
+				for (j = i+1; j < hpi->num_pages ; j++) {
+					if (hugepg_tbl[j].physaddr !=
+					    hugepg_tbl[j-1].physaddr + hugepage_sz)
+						break;
+				}
+				num_pages = j - i;
 			}
-			num_pages = j - i;
 			vma_len = num_pages * hugepage_sz;
 
 			/* get the biggest virtual memory area up to
@@ -237,13 +254,10 @@ map_all_hugepages(struct hugepage *hugepg_tbl,
 			close(fd);
 			return -1;
 		}
-		if (orig) {
+		if (orig)
 			hugepg_tbl[i].orig_va = virtaddr;
-			memset(virtaddr, 0, hugepage_sz);
-		}
-		else {
+		else
 			hugepg_tbl[i].final_va = virtaddr;
-		}
 
 		vma_addr = (char *)vma_addr + hugepage_sz;
 		vma_len -= hugepage_sz;
@@ -252,6 +266,94 @@ map_all_hugepages(struct hugepage *hugepg_tbl,
 	return 0;
 }
 
+/* argument of a thread zeroing a range of the hugepage table */
+struct hugepage_fault_arg {
+	struct hugepage *hugepg_tbl;
+	uint64_t hugepage_sz;
+	unsigned first;     /**< first page to zero */
+	unsigned last;      /**< last page to zero (excluded) */
+	unsigned lcore_id;  /**< lcore the thread runs on */
+};
+
+static void
+fault_hugepage_range(const struct hugepage_fault_arg *fa)
+{
+	unsigned i;
+
+	for (i = fa->first; i < fa->last; i++)
+		memset(fa->hugepg_tbl[i].orig_va, 0, fa->hugepage_sz);
+}
+
+static void *
+fault_hugepage_thread(void *arg)
+{
+	const struct hugepage_fault_arg *fa = arg;
+	cpu_set_t cpuset;
+
+	/* run on the lcore, so that pages are allocated on its socket */
+	CPU_ZERO(&cpuset);
+	CPU_SET(fa->lcore_id, &cpuset);
+	pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+
+	fault_hugepage_range(fa);
+	return NULL;
+}
+
+/*
+ * Zero all pages of the first mapping, which makes the kernel allocate
+ * them. It is the most expensive part of the initialization, so the
+ * table is split among one thread per enabled lcore. Each thread runs
+ * on its lcore, so pages are allocated on the sockets of the lcores.
+ */
+static int
+fault_all_hugepages(struct hugepage *hugepg_tbl, struct hugepage_info *hpi)
+{
+	struct hugepage_fault_arg fa[RTE_MAX_LCORE];
+	pthread_t threads[RTE_MAX_LCORE];
+	unsigned lcore_id, nb_threads = 0, nb_started = 0;
+	unsigned i;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		if (!rte_lcore_is_enabled(lcore_id))
+			continue;
+		fa[nb_threads].lcore_id = lcore_id;
+		nb_threads++;
+	}
+	if (nb_threads > hpi->num_pages)
+		nb_threads = hpi->num_pages;
+	if (nb_threads == 0)
+		nb_threads = 1;
+
+	for (i = 0; i < nb_threads; i++) {
+		fa[i].hugepg_tbl = hugepg_tbl;
+		fa[i].hugepage_sz = hpi->hugepage_sz;
+		fa[i].first = (hpi->num_pages * i) / nb_threads;
+		fa[i].last = (hpi->num_pages * (i + 1)) / nb_threads;
+	}
+
+	/* if only one thread is needed, do the job in this one */
+	if (nb_threads == 1) {
+		fault_hugepage_range(&fa[0]);
+		return 0;
+	}
+
+	for (i = 0; i < nb_threads; i++) {
+		if (pthread_create(&threads[i], NULL, fault_hugepage_thread,
+				&fa[i]) != 0)
+			break;
+		nb_started++;
+	}
+
+	/* zero the ranges of the threads that could not be created */
+	for (i = nb_started; i < nb_threads; i++)
+		fault_hugepage_range(&fa[i]);
+
+	for (i = 0; i < nb_started; i++)
+		pthread_join(threads[i], NULL);
+
+	return 0;
+}
+
 /* Unmap all hugepages from original mapping. */
 static int
 unmap_all_hugepages_orig(struct hugepage *hugepg_tbl, struct hugepage_info *hpi)
@@ -277,58 +379,102 @@ rte_mem_lock_page(const void *virt)
 }
 
 /*
- * Get physical address of any mapped virtual address in the current process.
+ * Get physical address of a virtual address of the current process,
+ * using an already opened /proc/self/pagemap file.
  */
-phys_addr_t
-rte_mem_virt2phy(const void *virt)
+static phys_addr_t
+virt2phy(int fdmem, const void *virt)
 {
-	int fdmem;
 	uint64_t page;
 	off_t offset;
 	unsigned long virtual = (unsigned long)virt;
 	int page_size = getpagesize();
 
-	fdmem = open("/proc/self/pagemap", O_RDONLY);
-	if (fdmem < 0) {
-		RTE_LOG(ERR, EAL, "%s(): cannot open /proc/self/pagemap: %s\n",
-		                  __func__, strerror(errno));
-		return RTE_BAD_PHYS_ADDR;
-	}
 	offset = (off_t) (virtual / page_size) * sizeof(uint64_t);
-	if (lseek(fdmem, offset, SEEK_SET) == (off_t) -1) {
-		RTE_LOG(ERR, EAL, "%s(): seek error in /proc/self/pagemap: %s\n",
+	if (pread(fdmem, &page, sizeof(uint64_t), offset) !=
+			sizeof(uint64_t)) {
+		RTE_LOG(ERR, EAL, "%s(): cannot read /proc/self/pagemap: %s\n",
 		                  __func__, strerror(errno));
-		close(fdmem);
 		return RTE_BAD_PHYS_ADDR;
 	}
-	if (read(fdmem, &page, sizeof(uint64_t)) <= 0) {
-		RTE_LOG(ERR, EAL, "%s(): cannot read /proc/self/pagemap: %s\n",
+
+	/* pfn (page frame number) are bits 0-54 (see pagemap.txt in Linux doc) */
+	return ((page & 0x7fffffffffffffULL) * page_size) + (virtual % page_size);
+}
+
+/*
+ * Get physical address of any mapped virtual address in the current process.
+ */
+phys_addr_t
+rte_mem_virt2phy(const void *virt)
+{
+	int fdmem;
+	phys_addr_t physaddr;
+
+	fdmem = open("/proc/self/pagemap", O_RDONLY);
+	if (fdmem < 0) {
+		RTE_LOG(ERR, EAL, "%s(): cannot open /proc/self/pagemap: %s\n",
 		                  __func__, strerror(errno));
-		close(fdmem);
 		return RTE_BAD_PHYS_ADDR;
 	}
+	physaddr = virt2phy(fdmem, virt);
 	close (fdmem);
 
-	/* pfn (page frame number) are bits 0-54 (see pagemap.txt in Linux doc) */
-	return ((page & 0x7fffffffffffffULL) * page_size) + (virtual % page_size);
+	return physaddr;
 }
 
 /*
- * For each hugepage in hugepg_tbl, fill the physaddr value.
+ * For each hugepage in hugepg_tbl, fill the physaddr value. The
+ * pagemap file is opened only once for the whole table.
  */
 static int
 find_physaddr(struct hugepage *hugepg_tbl, struct hugepage_info *hpi)
 {
+	int fdmem;
 	unsigned i;
 
+	fdmem = open("/proc/self/pagemap", O_RDONLY);
+	if (fdmem < 0) {
+		RTE_LOG(ERR, EAL, "%s(): cannot open /proc/self/pagemap: %s\n",
+		                  __func__, strerror(errno));
+		return -1;
+	}
+
 	for (i = 0; i < hpi->num_pages; i++) {
-		hugepg_tbl[i].physaddr = rte_mem_virt2phy(hugepg_tbl[i].orig_va);
-		if (hugepg_tbl[i].physaddr == RTE_BAD_PHYS_ADDR)
+		hugepg_tbl[i].physaddr = virt2phy(fdmem, hugepg_tbl[i].orig_va);
+		if (hugepg_tbl[i].physaddr == RTE_BAD_PHYS_ADDR) {
+			close(fdmem);
 			return -1;
+		}
 	}
+	close(fdmem);
 	return 0;
 }
 
+/* compare two hugepage table entries by first virtual address */
+static int
+cmp_orig_va(const void *a, const void *b)
+{
+	const struct hugepage *hpa = *(struct hugepage * const *)a;
+	const struct hugepage *hpb = *(struct hugepage * const *)b;
+
+	if (hpa->orig_va < hpb->orig_va)
+		return -1;
+	return hpa->orig_va > hpb->orig_va;
+}
+
+/* compare a virtual address with the first virtual address of a page */
+static int
+cmp_va_key(const void *key, const void *elt)
+{
+	const void *va = key;
+	const struct hugepage *hp = *(struct hugepage * const *)elt;
+
+	if (va < hp->orig_va)
+		return -1;
+	return va > hp->orig_va;
+}
+
 /*
  * Parse /proc/self/numa_maps to get the NUMA socket ID for each huge
  * page.
@@ -342,6 +488,7 @@ find_numasocket(struct hugepage *hugepg_tbl, struct hugepage_info *hpi)
 	uint64_t virt_addr;
 	char buf[BUFSIZ];
 	char hugedir_str[PATH_MAX];
+	struct hugepage **by_va, **hp;
 	FILE *f;
 
 	f = fopen("/proc/self/numa_maps", "r");
@@ -351,6 +498,16 @@ find_numasocket(struct hugepage *hugepg_tbl, struct hugepage_info *hpi)
 		return 0;
 	}
 
+	/* index the pages by virtual address to look them up quickly */
+	by_va = malloc(hpi->num_pages * sizeof(by_va[0]));
+	if (by_va == NULL) {
+		fclose(f);
+		return -1;
+	}
+	for (i = 0; i < hpi->num_pages; i++)
+		by_va[i] = &hugepg_tbl[i];
+	qsort(by_va, hpi->num_pages, sizeof(by_va[0]), cmp_orig_va);
+
 	rte_snprintf(hugedir_str, sizeof(hugedir_str),
 			"%s/", hpi->hugedir);
 
@@ -391,67 +548,76 @@ find_numasocket(struct hugepage *hugepg_tbl, struct hugepage_info *hpi)
 		}
 
 		/* if we find this page in our mappings, set socket_id */
-		for (i = 0; i < hpi->num_pages; i++) {
-			void *va = (void *)(unsigned long)virt_addr;
-			if (hugepg_tbl[i].orig_va == va) {
-				hugepg_tbl[i].socket_id = socket_id;
-				hp_count++;
-			}
+		hp = bsearch((void *)(unsigned long)virt_addr, by_va,
+				hpi->num_pages, sizeof(by_va[0]), cmp_va_key);
+		if (hp != NULL) {
+			(*hp)->socket_id = socket_id;
+			hp_count++;
 		}
 	}
 	if (hp_count < hpi->num_pages)
 		goto error;
+	free(by_va);
 	fclose(f);
 	return 0;
 
 error:
+	free(by_va);
 	fclose(f);
 	return -1;
 }
 
+/* compare two hugepage table entries by physical address */
+static int
+cmp_physaddr(const void *a, const void *b)
+{
+	const struct hugepage *hpa = a;
+	const struct hugepage *hpb = b;
+
+	if (hpa->physaddr < hpb->physaddr)
+		return -1;
+	return hpa->physaddr > hpb->physaddr;
+}
+
 /*
- * Sort the hugepg_tbl by physical address (lower addresses first). We
- * use a slow algorithm, but we won't have millions of pages, and this
- * is only done at init time.
+ * Sort the hugepg_tbl by physical address (lower addresses first).
  */
 static int
 sort_by_physaddr(struct hugepage *hugepg_tbl, struct hugepage_info *hpi)
 {
-	unsigned i, j;
-	int smallest_idx;
-	uint64_t smallest_addr;
-	struct hugepage tmp;
-
-	for (i = 0; i < hpi->num_pages; i++) {
-		smallest_addr = 0;
-		smallest_idx = -1;
+	qsort(hugepg_tbl, hpi->num_pages, sizeof(struct hugepage),
+			cmp_physaddr);
+	return 0;
+}
 
-		/*
-		 * browse all entries starting at 'i', and find the
-		 * entry with the smallest addr
-		 */
-		for (j=i; j<hpi->num_pages; j++) {
+/*
+ * Return 1 if the first mapping of the (sorted) table already has
+ * increasing virtual addresses. As all pages were mapped in one area
+ * in file order, physically contiguous pages are then also virtually
+ * contiguous and the second mapping would not improve anything.
+ */
+static int
+orig_va_is_sorted(const struct hugepage *hugepg_tbl,
+		const struct hugepage_info *hpi)
+{
+	unsigned i;
 
-			if (smallest_addr == 0 ||
-			    hugepg_tbl[j].physaddr < smallest_addr) {
-				smallest_addr = hugepg_tbl[j].physaddr;
-				smallest_idx = j;
-			}
-		}
+	for (i = 1; i < hpi->num_pages; i++)
+		if (hugepg_tbl[i].orig_va <= hugepg_tbl[i-1].orig_va)
+			return 0;
+	return 1;
+}
 
-		/* should not happen */
-		if (smallest_idx == -1) {
-			RTE_LOG(ERR, EAL, "%s(): error in physaddr sorting\n", __func__);
-			return -1;
-		}
+/* Use the first mapping of all pages as final mapping. */
+static void
+keep_orig_mapping(struct hugepage *hugepg_tbl, struct hugepage_info *hpi)
+{
+	unsigned i;
 
-		/* swap the 2 entries in the table */
-		memcpy(&tmp, &hugepg_tbl[smallest_idx], sizeof(struct hugepage));
-		memcpy(&hugepg_tbl[smallest_idx], &hugepg_tbl[i],
-				sizeof(struct hugepage));
-		memcpy(&hugepg_tbl[i], &tmp, sizeof(struct hugepage));
+	for (i = 0; i < hpi->num_pages; i++) {
+		hugepg_tbl[i].final_va = hugepg_tbl[i].orig_va;
+		hugepg_tbl[i].orig_va = NULL;
 	}
-	return 0;
 }
 
 /*
@@ -526,95 +692,406 @@ calc_num_pages(uint64_t memory,
 	return total_num_pages;
 }
 
+/*
+ * For each NUMA socket, calculate the number of pages of each size
+ * needed to fulfill the per-socket memory request, using only the
+ * pages found on that socket. pages_per_socket[i][s] is the number of
+ * pages of size hp_info[i] to take from socket s. Returns 0 on
+ * success, -1 if one socket does not have enough memory.
+ */
+static int
+calc_num_pages_per_socket(const struct hugepage *hugepg_tbl,
+		struct hugepage_info *hp_info,
+		unsigned num_hp_info,
+		unsigned pages_per_socket[][RTE_MAX_NUMA_NODES])
+{
+	struct hugepage_info avail[MAX_HUGEPAGE_SIZES];
+	struct hugepage_info used[MAX_HUGEPAGE_SIZES];
+	uint64_t total_mem, avail_mem;
+	unsigned socket, i, j, offset;
+
+	for (socket = 0; socket < RTE_MAX_NUMA_NODES; socket++) {
+		memset(avail, 0, sizeof(avail));
+		memset(used, 0, sizeof(used));
+
+		/* count the pages of each size located on this socket */
+		avail_mem = 0;
+		offset = 0;
+		for (i = 0; i < num_hp_info; i++) {
+			avail[i].hugepage_sz = hp_info[i].hugepage_sz;
+			avail[i].hugedir = hp_info[i].hugedir;
+			for (j = 0; j < hp_info[i].num_pages; j++)
+				if (hugepg_tbl[offset + j].socket_id == (int)socket)
+					avail[i].num_pages++;
+			avail_mem += avail[i].num_pages * avail[i].hugepage_sz;
+			offset += hp_info[i].num_pages;
+		}
+
+		if (internal_config.socket_mem[socket] == 0) {
+			for (i = 0; i < num_hp_info; i++)
+				pages_per_socket[i][socket] = 0;
+			continue;
+		}
+
+		calc_num_pages(internal_config.socket_mem[socket], avail, used,
+				num_hp_info);
+
+		total_mem = 0;
+		for (i = 0; i < num_hp_info; i++) {
+			pages_per_socket[i][socket] = used[i].num_pages;
+			total_mem += used[i].num_pages * used[i].hugepage_sz;
+			if (used[i].num_pages > 0)
+				RTE_LOG(INFO, EAL, "Requesting %u pages of size %"
+						PRIu64"MB from socket %u\n",
+						used[i].num_pages,
+						used[i].hugepage_sz / 0x100000, socket);
+		}
+
+		if (total_mem < internal_config.socket_mem[socket]) {
+			RTE_LOG(ERR, EAL, "Not enough memory available on socket %u! "
+					"Requested: %"PRIu64"MB, available: %"PRIu64"MB\n",
+					socket,
+					internal_config.socket_mem[socket] / 0x100000,
+					avail_mem / 0x100000);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Keep only the pages of hugepg_tbl needed by pages_per_socket. As
+ * the table is sorted by physical address, the lowest pages of each
+ * socket are kept. The other pages are unmapped and their files are
+ * removed from hugetlbfs so that they go back to the system. The kept
+ * entries are packed at the beginning of the table and hpi->num_pages
+ * is updated.
+ */
+static int
+unmap_unneeded_hugepages(struct hugepage *hugepg_tbl,
+		struct hugepage_info *hpi, const unsigned *pages_per_socket)
+{
+	unsigned needed[RTE_MAX_NUMA_NODES];
+	unsigned i, kept = 0;
+	int socket;
+
+	memcpy(needed, pages_per_socket, sizeof(needed));
+
+	for (i = 0; i < hpi->num_pages; i++) {
+		socket = hugepg_tbl[i].socket_id;
+		if (socket >= 0 && socket < RTE_MAX_NUMA_NODES &&
+				needed[socket] > 0) {
+			needed[socket]--;
+			if (kept != i)
+				memcpy(&hugepg_tbl[kept], &hugepg_tbl[i],
+						sizeof(struct hugepage));
+			kept++;
+			continue;
+		}
+
+		munmap(hugepg_tbl[i].orig_va, hpi->hugepage_sz);
+		if (unlink(hugepg_tbl[i].filepath) < 0) {
+			RTE_LOG(ERR, EAL, "%s(): unlinking %s failed: %s\n",
+					__func__, hugepg_tbl[i].filepath,
+					strerror(errno));
+			return -1;
+		}
+	}
+
+	hpi->num_pages = kept;
+	return 0;
+}
+/*
+ * Map an anonymous area of size bytes, aligned on NOHUGE_PAGE_SZ so that
+ * the kernel can back it with transparent hugepages. The area is only
+ * reserved here, pages are allocated by nohuge_populate().
+ */
+static void *
+nohuge_map(uint64_t size)
+{
+	void *addr, *aligned;
+	uint64_t map_sz = size + NOHUGE_PAGE_SZ;
+	uintptr_t head, tail;
+
+	addr = mmap(NULL, map_sz, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (addr == MAP_FAILED) {
+		RTE_LOG(ERR, EAL, "%s(): cannot map %"PRIu64" bytes of "
+				"anonymous memory: %s\n", __func__, size,
+				strerror(errno));
+		return NULL;
+	}
+
+	/* give back what is before and after the aligned area */
+	aligned = RTE_ALIGN_CEIL(addr, NOHUGE_PAGE_SZ);
+	head = RTE_PTR_DIFF(aligned, addr);
+	tail = map_sz - head - size;
+	if (head != 0)
+		munmap(addr, head);
+	if (tail != 0)
+		munmap(RTE_PTR_ADD(aligned, size), tail);
+
+#ifdef MADV_HUGEPAGE
+	if (madvise(aligned, size, MADV_HUGEPAGE) < 0)
+		RTE_LOG(WARNING, EAL, "Transparent hugepages not available "
+				"(%s), using small pages\n", strerror(errno));
+#endif
+	return aligned;
+}
+
+/*
+ * Bind an anonymous area to a NUMA node. mbind is called directly
+ * to avoid a dependency on libnuma.
+ */
+static int
+nohuge_bind(void *addr, uint64_t size, unsigned socket_id)
+{
+	unsigned long nodemask[RTE_MAX_NUMA_NODES / (8 * sizeof(unsigned long)) + 1];
+	const unsigned bits = 8 * sizeof(unsigned long);
+
+	memset(nodemask, 0, sizeof(nodemask));
+	nodemask[socket_id / bits] |= 1UL << (socket_id % bits);
+	if (syscall(__NR_mbind, addr, size, MPOL_BIND, nodemask,
+			sizeof(nodemask) * 8, MPOL_MF_STRICT) < 0) {
+		RTE_LOG(ERR, EAL, "%s(): cannot bind memory to socket %u: %s\n",
+				__func__, socket_id, strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Allocate all pages of an anonymous area. This is not done with
+ * MAP_POPULATE because the pages would be allocated by mmap(), before
+ * the hugepage advice and the NUMA policy are applied. Writing one
+ * byte per small page is enough: when a transparent hugepage is
+ * available, the first write allocates the whole 2MB page.
+ */
+static void
+nohuge_populate(void *addr, uint64_t size)
+{
+	const uint64_t page_sz = getpagesize();
+	uint64_t off;
+
+	for (off = 0; off < size; off += page_sz)
+		*(volatile char *)RTE_PTR_ADD(addr, off) = 0;
+}
+
+/* return the NUMA node where the page of addr is allocated */
+static unsigned
+nohuge_socket_id(void *addr)
+{
+	int node = 0;
+
+	if (syscall(__NR_get_mempolicy, &node, NULL, 0, addr,
+			MPOL_F_NODE | MPOL_F_ADDR) < 0 ||
+			node < 0 || node >= RTE_MAX_NUMA_NODES)
+		return 0;
+	return node;
+}
+
+/*
+ * Fill the memsegs with anonymous memory when hugetlbfs is disabled.
+ * With --socket-mem, one memseg is allocated and bound on each socket,
+ * otherwise a single memseg is allocated with the default NUMA policy.
+ * There is no physical address information: as for the malloc based
+ * mode, the physical address of a memseg is its virtual address.
+ */
+static int
+nohuge_init(struct rte_mem_config *mcfg)
+{
+	uint64_t size;
+	unsigned socket_id, seg = 0;
+	void *addr;
+
+	for (socket_id = 0; socket_id < RTE_MAX_NUMA_NODES; socket_id++) {
+		if (internal_config.force_sockets)
+			size = internal_config.socket_mem[socket_id];
+		else
+			size = socket_id == 0 ? internal_config.memory : 0;
+		if (size == 0)
+			continue;
+
+		size = RTE_ALIGN_CEIL(size, NOHUGE_PAGE_SZ);
+		addr = nohuge_map(size);
+		if (addr == NULL)
+			return -1;
+		if (internal_config.force_sockets &&
+				nohuge_bind(addr, size, socket_id) < 0) {
+			munmap(addr, size);
+			return -1;
+		}
+		nohuge_populate(addr, size);
+
+		mcfg->memseg[seg].phys_addr = (unsigned long)addr;
+		mcfg->memseg[seg].addr = addr;
+		mcfg->memseg[seg].len = size;
+		mcfg->memseg[seg].hugepage_sz = NOHUGE_PAGE_SZ;
+		mcfg->memseg[seg].socket_id = internal_config.force_sockets ?
+				socket_id : nohuge_socket_id(addr);
+		RTE_LOG(INFO, EAL, "Using %"PRIu64"MB of anonymous memory on "
+				"socket %d\n", size >> 20, mcfg->memseg[seg].socket_id);
+		seg++;
+	}
+	return 0;
+}
+
+
 /*
  * Prepare physical memory mapping: fill configuration structure with
  * these infos, return 0 on success.
- *  1. map N huge pages in separate files in hugetlbfs
+ *  1. map N huge pages in separate files in hugetlbfs, and fault them
+ *     from several threads
  *  2. find associated physical addr
  *  3. find associated NUMA socket ID
  *  4. sort all huge pages by physical address
- *  5. remap these N huge pages in the correct order
- *  6. unmap the first mapping
- *  7. fill memsegs in configuration with contiguous zones
+ *  5. if memory was requested per socket, release the pages that are
+ *     not needed on each socket
+ *  6. remap these N huge pages in the correct order, unless the first
+ *     mapping is already in that order
+ *  7. unmap the first mapping
+ *  8. fill memsegs in configuration with contiguous zones
  */
 static int
 rte_eal_hugepage_init(void)
 {
 	struct rte_mem_config *mcfg;
-	struct hugepage *hugepage;
+	struct hugepage *hugepage, *tmp_hp;
 	struct hugepage_info used_hp[MAX_HUGEPAGE_SIZES];
+	unsigned pages_per_socket[MAX_HUGEPAGE_SIZES][RTE_MAX_NUMA_NODES];
+	unsigned tbl_offset[MAX_HUGEPAGE_SIZES];
+	unsigned hp_offset;
 	int i, j, new_memseg;
 	int nrpages;
-	void *addr;
+	struct timeval start, end;
 
 	memset(used_hp, 0, sizeof(used_hp));
+	gettimeofday(&start, NULL);
 
 	/* get pointer to global configuration */
 	mcfg = rte_eal_get_configuration()->mem_config;
 
-	/* for debug purposes, hugetlbfs can be disabled */
-	if (internal_config.no_hugetlbfs) {
-		addr = malloc(internal_config.memory);
-		mcfg->memseg[0].phys_addr = (unsigned long)addr;
-		mcfg->memseg[0].addr = addr;
-		mcfg->memseg[0].len = internal_config.memory;
-		mcfg->memseg[0].socket_id = 0;
-		return 0;
+	/* hugetlbfs can be disabled, anonymous memory is used instead */
+	if (internal_config.no_hugetlbfs)
+		return nohuge_init(mcfg);
+
+	if (internal_config.force_sockets) {
+		/* the socket of a page is only known once it is mapped, so
+		 * map all available pages and release the unneeded ones
+		 * later */
+		nrpages = 0;
+		for (i = 0; i < (int)internal_config.num_hugepage_sizes; i++) {
+			used_hp[i] = internal_config.hugepage_info[i];
+			nrpages += used_hp[i].num_pages;
+		}
 	}
+	else {
+		nrpages = calc_num_pages(internal_config.memory,
+				&internal_config.hugepage_info[0], &used_hp[0],
+				internal_config.num_hugepage_sizes);
+		for (i = 0; i < (int)internal_config.num_hugepage_sizes; i++)
+			RTE_LOG(INFO, EAL, "Requesting %u pages of size %"PRIu64"\n",
+					used_hp[i].num_pages, used_hp[i].hugepage_sz);
+	}
+	if (nrpages <= 0)
+		return -1;
 
-	nrpages = calc_num_pages(internal_config.memory,
-			&internal_config.hugepage_info[0], &used_hp[0],
-			internal_config.num_hugepage_sizes);
-	for (i = 0; i < (int)internal_config.num_hugepage_sizes; i++)
-		RTE_LOG(INFO, EAL, "Requesting %u pages of size %"PRIu64"\n",
-				used_hp[i].num_pages, used_hp[i].hugepage_sz);
-
-	hugepage = create_shared_memory(eal_hugepage_info_path(),
-			nrpages * sizeof(struct hugepage));
-	if (hugepage == NULL)
+	tmp_hp = malloc(nrpages * sizeof(struct hugepage));
+	if (tmp_hp == NULL)
 		return -1;
-	memset(hugepage, 0, nrpages * sizeof(struct hugepage));
+	memset(tmp_hp, 0, nrpages * sizeof(struct hugepage));
 
-	unsigned hp_offset = 0; /* where we start the current page size entries */
+	hp_offset = 0; /* where we start the current page size entries */
 	for (i = 0; i < (int)internal_config.num_hugepage_sizes; i ++){
 		struct hugepage_info *hpi = &used_hp[i];
+
+		tbl_offset[i] = hp_offset;
 		if (hpi->num_pages == 0)
 			continue;
 
-		if (map_all_hugepages(&hugepage[hp_offset], hpi, 1) < 0){
+		if (map_all_hugepages(&tmp_hp[hp_offset], hpi, 1) < 0){
 			RTE_LOG(DEBUG, EAL, "Failed to mmap %u MB hugepages\n",
 					(unsigned)(hpi->hugepage_sz / 0x100000));
 			goto fail;
 		}
 
-		if (find_physaddr(&hugepage[hp_offset], hpi) < 0){
+		if (fault_all_hugepages(&tmp_hp[hp_offset], hpi) < 0)
+			goto fail;
+
+		if (find_physaddr(&tmp_hp[hp_offset], hpi) < 0){
 			RTE_LOG(DEBUG, EAL, "Failed to find phys addr for %u MB pages\n",
 					(unsigned)(hpi->hugepage_sz / 0x100000));
 			goto fail;
 		}
 
-		if (find_numasocket(&hugepage[hp_offset], hpi) < 0){
+		if (find_numasocket(&tmp_hp[hp_offset], hpi) < 0){
 			RTE_LOG(DEBUG, EAL, "Failed to find NUMA socket for %u MB pages\n",
 					(unsigned)(hpi->hugepage_sz / 0x100000));
 			goto fail;
 		}
 
-		if (sort_by_physaddr(&hugepage[hp_offset], hpi) < 0)
+		if (sort_by_physaddr(&tmp_hp[hp_offset], hpi) < 0)
 			goto fail;
 
-		if (map_all_hugepages(&hugepage[hp_offset], hpi, 0) < 0){
+		/* we have processed a num of hugepages of this size, so inc offset */
+		hp_offset += hpi->num_pages;
+	}
+
+	if (internal_config.force_sockets) {
+		if (calc_num_pages_per_socket(tmp_hp, used_hp,
+				internal_config.num_hugepage_sizes,
+				pages_per_socket) < 0)
+			goto fail;
+
+		for (i = 0; i < (int)internal_config.num_hugepage_sizes; i++) {
+			if (used_hp[i].num_pages == 0)
+				continue;
+			if (unmap_unneeded_hugepages(&tmp_hp[tbl_offset[i]],
+					&used_hp[i], pages_per_socket[i]) < 0)
+				goto fail;
+		}
+	}
+
+	nrpages = 0;
+	for (i = 0; i < (int)internal_config.num_hugepage_sizes; i ++){
+		struct hugepage_info *hpi = &used_hp[i];
+		if (hpi->num_pages == 0)
+			continue;
+
+		if (orig_va_is_sorted(&tmp_hp[tbl_offset[i]], hpi)) {
+			RTE_LOG(DEBUG, EAL, "No remap needed for %u MB pages\n",
+					(unsigned)(hpi->hugepage_sz / 0x100000));
+			keep_orig_mapping(&tmp_hp[tbl_offset[i]], hpi);
+			nrpages += hpi->num_pages;
+			continue;
+		}
+
+		if (map_all_hugepages(&tmp_hp[tbl_offset[i]], hpi, 0) < 0){
 			RTE_LOG(DEBUG, EAL, "Failed to remap %u MB pages\n",
 					(unsigned)(hpi->hugepage_sz / 0x100000));
 			goto fail;
 		}
 
-		if (unmap_all_hugepages_orig(&hugepage[hp_offset], hpi) < 0)
+		if (unmap_all_hugepages_orig(&tmp_hp[tbl_offset[i]], hpi) < 0)
 			goto fail;
 
-		/* we have processed a num of hugepages of this size, so inc offset */
-		hp_offset += hpi->num_pages;
+		nrpages += hpi->num_pages;
 	}
 
+	/* store the final table in shared memory for secondary processes */
+	hugepage = create_shared_memory(eal_hugepage_info_path(),
+			nrpages * sizeof(struct hugepage));
+	if (hugepage == NULL)
+		goto fail;
+	hp_offset = 0;
+	for (i = 0; i < (int)internal_config.num_hugepage_sizes; i ++){
+		memcpy(&hugepage[hp_offset], &tmp_hp[tbl_offset[i]],
+				used_hp[i].num_pages * sizeof(struct hugepage));
+		hp_offset += used_hp[i].num_pages;
+	}
+	free(tmp_hp);
+	tmp_hp = NULL;
+
 	memset(mcfg->memseg, 0, sizeof(mcfg->memseg));
 	j = -1;
 	for (i = 0; i < nrpages; i++) {
@@ -652,10 +1129,16 @@ rte_eal_hugepage_init(void)
 		hugepage[i].memseg_id = j;
 	}
 
+	gettimeofday(&end, NULL);
+	RTE_LOG(INFO, EAL, "Hugepage init of %d pages done in %lu ms\n",
+			nrpages, (unsigned long)((end.tv_sec - start.tv_sec) * 1000 +
+			(end.tv_usec - start.tv_usec) / 1000));
+
 	return 0;
 
 
  fail:
+	free(tmp_hp);
 	return -1;
 }
 
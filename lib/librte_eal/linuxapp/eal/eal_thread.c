@@ -41,8 +41,11 @@
 #include <pthread.h>
 #include <sched.h>
 #include <sys/queue.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 #include <rte_debug.h>
+#include <rte_common.h>
 #include <rte_atomic.h>
 #include <rte_launch.h>
 #include <rte_log.h>
@@ -53,47 +56,94 @@
 #include <rte_eal.h>
 #include <rte_per_lcore.h>
 #include <rte_lcore.h>
+#include <rte_spinlock.h>
 
 #include "eal_private.h"
 #include "eal_thread.h"
 
 RTE_DEFINE_PER_LCORE(unsigned, _lcore_id);
 
+/* kind of the thread, regarding lcore ids */
+#define THREAD_FOREIGN    0 /**< not created by EAL, not registered */
+#define THREAD_EAL        1 /**< EAL thread */
+#define THREAD_REGISTERED 2 /**< registered with rte_thread_register() */
+static RTE_DEFINE_PER_LCORE(int, _thread_kind);
+
+/* value of the lcore id of a foreign thread, restored on unregister */
+static RTE_DEFINE_PER_LCORE(unsigned, _foreign_lcore_id);
+
+/* protect the lcore roles when registering threads */
+static rte_spinlock_t thread_register_lock = RTE_SPINLOCK_INITIALIZER;
+
+/*
+ * Number of rte_pause() iterations (a few milliseconds) during which an
+ * idle slave polls its mailbox before going to sleep on the futex.
+ */
+#define LAUNCH_SPIN_COUNT 100000
+
+static inline void
+eal_futex_wait(volatile uint32_t *addr, uint32_t val)
+{
+	syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+static inline void
+eal_futex_wake(volatile uint32_t *addr)
+{
+	syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
 /*
- * Send a message to a slave lcore identified by slave_id to call a
- * function f with argument arg. Once the execution is done, the
- * remote lcore switch in FINISHED state.
+ * Post a command in the mailbox of a slave lcore identified by
+ * slave_id to call a function f with argument arg. The lcore is
+ * switched to RUNNING state here, so there is no need to wait for an
+ * acknowledge. Once the execution is done, the remote lcore switch in
+ * FINISHED state.
  */
 int
 rte_eal_remote_launch(int (*f)(void *), void *arg, unsigned slave_id)
 {
-	int n;
-	char c = 0;
-	int m2s = lcore_config[slave_id].pipe_master2slave[1];
-	int s2m = lcore_config[slave_id].pipe_slave2master[0];
+	struct lcore_config *cfg = &lcore_config[slave_id];
 
-	if (lcore_config[slave_id].state != WAIT)
+	if (cfg->state != WAIT)
 		return -EBUSY;
 
-	lcore_config[slave_id].f = f;
-	lcore_config[slave_id].arg = arg;
+	cfg->f = f;
+	cfg->arg = arg;
+	cfg->state = RUNNING;
+	rte_wmb();
+	cfg->launch_seq++;
 
-	/* send message */
-	n = 0;
-	while (n == 0 || (n < 0 && errno == EINTR))
-		n = write(m2s, &c, 1);
-	if (n < 0)
-		rte_panic("cannot write on configuration pipe\n");
+	/* the slave only needs a syscall if it is sleeping */
+	rte_mb();
+	if (cfg->sleeping)
+		eal_futex_wake(&cfg->launch_seq);
 
-	/* wait ack */
-	do {
-		n = read(s2m, &c, 1);
-	} while (n < 0 && errno == EINTR);
+	return 0;
+}
 
-	if (n <= 0)
-		rte_panic("cannot read on configuration pipe\n");
+/*
+ * Wait until the launch sequence number of the lcore changes from
+ * seq: poll it for a while, then sleep on the futex.
+ */
+static void
+eal_thread_wait_command(struct lcore_config *cfg, uint32_t seq)
+{
+	unsigned i;
 
-	return 0;
+	for (i = 0; i < LAUNCH_SPIN_COUNT; i++) {
+		if (cfg->launch_seq != seq)
+			return;
+		rte_pause();
+	}
+
+	while (cfg->launch_seq == seq) {
+		cfg->sleeping = 1;
+		rte_mb();
+		if (cfg->launch_seq == seq)
+			eal_futex_wait(&cfg->launch_seq, seq);
+		cfg->sleeping = 0;
+	}
 }
 
 /* set affinity for current thread */
@@ -158,21 +208,89 @@ void eal_thread_init_master(unsigned lcore_id)
 {
 	/* set the lcore ID in per-lcore memory area */
 	RTE_PER_LCORE(_lcore_id) = lcore_id;
+	RTE_PER_LCORE(_thread_kind) = THREAD_EAL;
 
 	/* set CPU affinity */
 	if (eal_thread_set_affinity() < 0)
 		rte_panic("cannot set affinity\n");
 }
 
+/*
+ * Give a free lcore id to a thread which was not created by EAL. The
+ * id is marked with the ROLE_NON_EAL role, so that it is not seen as
+ * an enabled lcore.
+ */
+int
+rte_thread_register(void)
+{
+	struct rte_config *cfg = rte_eal_get_configuration();
+	unsigned lcore_id;
+	int cpu;
+
+	if (RTE_PER_LCORE(_thread_kind) != THREAD_FOREIGN)
+		return -EEXIST;
+
+	rte_spinlock_lock(&thread_register_lock);
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		if (cfg->lcore_role[lcore_id] == ROLE_OFF)
+			break;
+	}
+	if (lcore_id == RTE_MAX_LCORE) {
+		rte_spinlock_unlock(&thread_register_lock);
+		return -ENOSPC;
+	}
+	cfg->lcore_role[lcore_id] = ROLE_NON_EAL;
+	rte_spinlock_unlock(&thread_register_lock);
+
+	/* the lcore is on the socket of the cpu we are running on */
+	cpu = sched_getcpu();
+	if (cpu >= 0 && cpu < RTE_MAX_LCORE && lcore_config[cpu].detected)
+		lcore_config[lcore_id].socket_id = lcore_config[cpu].socket_id;
+	else
+		lcore_config[lcore_id].socket_id = 0;
+	lcore_config[lcore_id].thread_id = pthread_self();
+
+	RTE_PER_LCORE(_foreign_lcore_id) = RTE_PER_LCORE(_lcore_id);
+	RTE_PER_LCORE(_lcore_id) = lcore_id;
+	RTE_PER_LCORE(_thread_kind) = THREAD_REGISTERED;
+
+	RTE_LOG(DEBUG, EAL, "Thread (tid=%x) registered as lcore %u on "
+		"socket %u\n", (int)pthread_self(), lcore_id,
+		lcore_config[lcore_id].socket_id);
+	return lcore_id;
+}
+
+/* release the lcore id of a registered thread */
+int
+rte_thread_unregister(void)
+{
+	struct rte_config *cfg = rte_eal_get_configuration();
+	unsigned lcore_id = RTE_PER_LCORE(_lcore_id);
+
+	if (RTE_PER_LCORE(_thread_kind) != THREAD_REGISTERED)
+		return -EINVAL;
+
+	RTE_PER_LCORE(_lcore_id) = RTE_PER_LCORE(_foreign_lcore_id);
+	RTE_PER_LCORE(_thread_kind) = THREAD_FOREIGN;
+
+	rte_spinlock_lock(&thread_register_lock);
+	cfg->lcore_role[lcore_id] = ROLE_OFF;
+	rte_spinlock_unlock(&thread_register_lock);
+
+	RTE_LOG(DEBUG, EAL, "Thread (tid=%x) unregistered from lcore %u\n",
+		(int)pthread_self(), lcore_id);
+	return 0;
+}
+
 /* main loop of threads */
 __attribute__((noreturn)) void *
 eal_thread_loop(__attribute__((unused)) void *arg)
 {
-	char c;
-	int n, ret;
+	int ret;
 	unsigned lcore_id;
 	pthread_t thread_id;
-	int m2s, s2m;
+	struct lcore_config *cfg;
+	uint32_t seq = 0;
 
 	thread_id = pthread_self();
 
@@ -187,46 +305,34 @@ eal_thread_loop(__attribute__((unused)) void *arg)
 	RTE_LOG(DEBUG, EAL, "Core %u is ready (tid=%x)\n",
 		lcore_id, (int)thread_id);
 
-	m2s = lcore_config[lcore_id].pipe_master2slave[0];
-	s2m = lcore_config[lcore_id].pipe_slave2master[1];
+	cfg = &lcore_config[lcore_id];
 
 	/* set the lcore ID in per-lcore memory area */
 	RTE_PER_LCORE(_lcore_id) = lcore_id;
+	RTE_PER_LCORE(_thread_kind) = THREAD_EAL;
 
 	/* set CPU affinity */
 	if (eal_thread_set_affinity() < 0)
 		rte_panic("cannot set affinity\n");
 
-	/* read on our pipe to get commands */
+	/* wait for commands in our mailbox */
 	while (1) {
 		void *fct_arg;
 
 		/* wait command */
-		do {
-			n = read(m2s, &c, 1);
-		} while (n < 0 && errno == EINTR);
-
-		if (n <= 0)
-			rte_panic("cannot read on configuration pipe\n");
-
-		lcore_config[lcore_id].state = RUNNING;
-
-		/* send ack */
-		n = 0;
-		while (n == 0 || (n < 0 && errno == EINTR))
-			n = write(s2m, &c, 1);
-		if (n < 0)
-			rte_panic("cannot write on configuration pipe\n");
+		eal_thread_wait_command(cfg, seq);
+		seq = cfg->launch_seq;
+		rte_rmb();
 
-		if (lcore_config[lcore_id].f == NULL)
+		if (cfg->f == NULL)
 			rte_panic("NULL function pointer\n");
 
 		/* call the function and store the return value */
-		fct_arg = lcore_config[lcore_id].arg;
-		ret = lcore_config[lcore_id].f(fct_arg);
-		lcore_config[lcore_id].ret = ret;
+		fct_arg = cfg->arg;
+		ret = cfg->f(fct_arg);
+		cfg->ret = ret;
 		rte_wmb();
-		lcore_config[lcore_id].state = FINISHED;
+		cfg->state = FINISHED;
 	}
 
 	/* never reached */
@@ -51,13 +51,16 @@
 struct lcore_config {
 	unsigned detected;         /**< true if lcore was detected */
 	pthread_t thread_id;       /**< pthread identifier */
-	int pipe_master2slave[2];  /**< communication pipe with master */
-	int pipe_slave2master[2];  /**< communication pipe with master */
+	volatile uint32_t launch_seq; /**< incremented at each launch */
+	volatile int sleeping;     /**< true if waiting on launch_seq futex */
 	lcore_function_t * volatile f;         /**< function to call */
 	void * volatile arg;       /**< argument of function */
 	volatile int ret;          /**< return value of function */
 	volatile enum rte_lcore_state_t state; /**< lcore state */
 	unsigned socket_id;        /**< physical socket id for this lcore */
+	unsigned core_id;          /**< physical core id in the socket */
+	unsigned l2_id;            /**< first lcore sharing the L2 cache */
+	unsigned l3_id;            /**< first lcore sharing the L3 cache */
 };
 
 /**
@@ -89,4 +92,64 @@ rte_lcore_to_socket_id(unsigned lcore_id)
 	return lcore_config[lcore_id].socket_id;
 }
 
+/**
+ * Get the ID of the physical core of the specified lcore. Two lcores
+ * are hyperthreads of the same core if they have the same socket ID
+ * and core ID.
+ *
+ * @param lcore_id
+ *   the targeted lcore, which MUST be between 0 and RTE_MAX_LCORE-1.
+ * @return
+ *   the ID of lcore_id's physical core in its socket
+ */
+static inline unsigned
+rte_lcore_to_core_id(unsigned lcore_id)
+{
+	return lcore_config[lcore_id].core_id;
+}
+
+/**
+ * Test if two lcores are hyperthreads of the same physical core.
+ *
+ * @param lcore_a
+ *   the first lcore, which MUST be between 0 and RTE_MAX_LCORE-1.
+ * @param lcore_b
+ *   the second lcore, which MUST be between 0 and RTE_MAX_LCORE-1.
+ * @return
+ *   True if the lcores are different and on the same physical core.
+ */
+static inline int
+rte_lcore_is_sibling(unsigned lcore_a, unsigned lcore_b)
+{
+	return lcore_a != lcore_b &&
+		lcore_config[lcore_a].socket_id ==
+		lcore_config[lcore_b].socket_id &&
+		lcore_config[lcore_a].core_id == lcore_config[lcore_b].core_id;
+}
+
+/**
+ * Test if two lcores share a cache of the given level.
+ *
+ * @param lcore_a
+ *   the first lcore, which MUST be between 0 and RTE_MAX_LCORE-1.
+ * @param lcore_b
+ *   the second lcore, which MUST be between 0 and RTE_MAX_LCORE-1.
+ * @param level
+ *   the cache level, 2 or 3.
+ * @return
+ *   True if the lcores share the cache, false otherwise or if the
+ *   level is not 2 or 3.
+ */
+static inline int
+rte_lcore_share_cache(unsigned lcore_a, unsigned lcore_b, unsigned level)
+{
+	if (level == 2)
+		return lcore_config[lcore_a].l2_id ==
+			lcore_config[lcore_b].l2_id;
+	if (level == 3)
+		return lcore_config[lcore_a].l3_id ==
+			lcore_config[lcore_b].l3_id;
+	return 0;
+}
+
 #endif /* _RTE_LCORE_H_ */
@@ -300,6 +300,13 @@ rte_eth_dev_configure(uint8_t port_id, uint16_t nb_rx_q, uint16_t nb_tx_q,
 		return (-EINVAL);
 	}
 
+	/* RX queue interrupts and LSC share the single device interrupt */
+	if (dev_conf->intr_conf.rxq != 0 && dev_conf->intr_conf.lsc != 0) {
+		PMD_DEBUG_TRACE("ethdev port_id=%d rxq and lsc interrupts "
+				"cannot be enabled together", port_id);
+		return (-EINVAL);
+	}
+
 	/* Copy the dev_conf parameter into the dev structure */
 	memcpy(&dev->data->dev_conf, dev_conf, sizeof(dev->data->dev_conf));
 
@@ -1155,6 +1162,100 @@ rte_eth_led_off(uint8_t port_id)
 	return ((*dev->dev_ops->dev_led_off)(dev));
 }
 
+int
+rte_eth_dev_rx_queue_intr_enable(uint8_t port_id, uint16_t queue_id)
+{
+	struct rte_eth_dev *dev;
+
+	if (port_id >= nb_ports) {
+		PMD_DEBUG_TRACE("Invalid port_id=%d\n", port_id);
+		return (-ENODEV);
+	}
+
+	dev = &rte_eth_devices[port_id];
+	if (queue_id >= dev->data->nb_rx_queues) {
+		PMD_DEBUG_TRACE("Invalid RX queue_id=%d\n", queue_id);
+		return (-EINVAL);
+	}
+	if (dev->data->dev_conf.intr_conf.rxq == 0)
+		return (-ENOTSUP);
+
+	FUNC_PTR_OR_ERR_RET(*dev->dev_ops->rx_queue_intr_enable, -ENOTSUP);
+	return ((*dev->dev_ops->rx_queue_intr_enable)(dev, queue_id));
+}
+
+int
+rte_eth_dev_rx_queue_intr_disable(uint8_t port_id, uint16_t queue_id)
+{
+	struct rte_eth_dev *dev;
+
+	if (port_id >= nb_ports) {
+		PMD_DEBUG_TRACE("Invalid port_id=%d\n", port_id);
+		return (-ENODEV);
+	}
+
+	dev = &rte_eth_devices[port_id];
+	if (queue_id >= dev->data->nb_rx_queues) {
+		PMD_DEBUG_TRACE("Invalid RX queue_id=%d\n", queue_id);
+		return (-EINVAL);
+	}
+	if (dev->data->dev_conf.intr_conf.rxq == 0)
+		return (-ENOTSUP);
+
+	FUNC_PTR_OR_ERR_RET(*dev->dev_ops->rx_queue_intr_disable, -ENOTSUP);
+	return ((*dev->dev_ops->rx_queue_intr_disable)(dev, queue_id));
+}
+
+int
+rte_eth_dev_rx_queue_wait(uint8_t port_id, uint16_t queue_id, int timeout)
+{
+	struct rte_eth_dev *dev;
+	int ret;
+
+	if (port_id >= nb_ports) {
+		PMD_DEBUG_TRACE("Invalid port_id=%d\n", port_id);
+		return (-ENODEV);
+	}
+
+	dev = &rte_eth_devices[port_id];
+	if (queue_id >= dev->data->nb_rx_queues) {
+		PMD_DEBUG_TRACE("Invalid RX queue_id=%d\n", queue_id);
+		return (-EINVAL);
+	}
+	if (dev->data->dev_conf.intr_conf.rxq == 0)
+		return (-ENOTSUP);
+
+	/* all queues of the port share the interrupt of the device */
+	ret = rte_intr_wait(&dev->pci_dev->intr_handle, timeout);
+	if (ret < 0)
+		return (-EIO);
+	return ret;
+}
+
+int
+rte_eth_dev_rx_queue_intr_add(uint8_t port_id, uint16_t queue_id, int epfd)
+{
+	struct rte_eth_dev *dev;
+
+	if (port_id >= nb_ports) {
+		PMD_DEBUG_TRACE("Invalid port_id=%d\n", port_id);
+		return (-ENODEV);
+	}
+
+	dev = &rte_eth_devices[port_id];
+	if (queue_id >= dev->data->nb_rx_queues) {
+		PMD_DEBUG_TRACE("Invalid RX queue_id=%d\n", queue_id);
+		return (-EINVAL);
+	}
+	if (dev->data->dev_conf.intr_conf.rxq == 0)
+		return (-ENOTSUP);
+
+	/* all queues of the port share the interrupt of the device */
+	if (rte_intr_wait_add(epfd, &dev->pci_dev->intr_handle) < 0)
+		return (-EIO);
+	return 0;
+}
+
 /*
  * Returns index into MAC address array of addr. Use 00:00:00:00:00:00 to find
  * an empty spot.
@@ -509,6 +509,12 @@ struct rte_eth_fdir {
 struct rte_intr_conf {
 	/** enable/disable lsc interrupt. 0 (default) - disable, 1 enable */
 	uint16_t lsc;
+	/**
+	 * enable/disable rx queue interrupts. 0 (default) - disable, 1 enable.
+	 * All queues of a port share the device interrupt, so this cannot be
+	 * combined with lsc.
+	 */
+	uint16_t rxq;
 };
 
 /**
@@ -703,6 +709,14 @@ typedef int (*eth_dev_led_on_t)(struct rte_eth_dev *dev);
 typedef int (*eth_dev_led_off_t)(struct rte_eth_dev *dev);
 /**<  Turn off SW controllable LED on an Ethernet device */
 
+typedef int (*eth_rx_queue_intr_enable_t)(struct rte_eth_dev *dev,
+					  uint16_t rx_queue_id);
+/**< Enable the receive interrupt of an RX queue of an Ethernet device. */
+
+typedef int (*eth_rx_queue_intr_disable_t)(struct rte_eth_dev *dev,
+					   uint16_t rx_queue_id);
+/**< Disable the receive interrupt of an RX queue of an Ethernet device. */
+
 typedef void (*eth_mac_addr_remove_t)(struct rte_eth_dev *dev, uint32_t index);
 /**< Remove MAC address from receive address register */
 
@@ -736,6 +750,10 @@ struct eth_dev_ops {
 	flow_ctrl_set_t            flow_ctrl_set; /**< Setup flow control. */
 	eth_mac_addr_remove_t      mac_addr_remove; /**< Remove MAC address */
 	eth_mac_addr_add_t         mac_addr_add;  /**< Add a MAC address */
+	/** Enable RX queue interrupt. */
+	eth_rx_queue_intr_enable_t  rx_queue_intr_enable;
+	/** Disable RX queue interrupt. */
+	eth_rx_queue_intr_disable_t rx_queue_intr_disable;
 
 	/** Add a signature filter. */
 	fdir_add_signature_filter_t fdir_add_signature_filter;
@@ -1673,6 +1691,104 @@ int rte_eth_dev_callback_unregister(uint8_t port_id,
 void _rte_eth_dev_callback_process(struct rte_eth_dev *dev,
 				enum rte_eth_event_type event);
 
+/**
+ * Enable the receive interrupt of an RX queue of an Ethernet device.
+ *
+ * The port must have been configured with *intr_conf.rxq* set. Once the
+ * interrupt is enabled, the caller can sleep in rte_eth_dev_rx_queue_wait()
+ * until packets arrive, then disable the interrupt again and go back to
+ * polling with rte_eth_rx_burst(). Packets received since the interrupt
+ * was last disabled raise it as soon as it is enabled, so none is missed
+ * between the last poll of the queue and the sleep.
+ *
+ * @param port_id
+ *   The port identifier of the Ethernet device.
+ * @param queue_id
+ *   The index of the receive queue.
+ * @return
+ *   - (0) if successful.
+ *   - (-ENOTSUP) if underlying hardware OR driver doesn't support
+ *     that operation, or RX queue interrupts are not configured.
+ *   - (-ENODEV) if *port_id* invalid.
+ *   - (-EINVAL) if *queue_id* invalid.
+ */
+int rte_eth_dev_rx_queue_intr_enable(uint8_t port_id, uint16_t queue_id);
+
+/**
+ * Disable the receive interrupt of an RX queue of an Ethernet device.
+ * Any pending interrupt of the queue is acknowledged.
+ *
+ * All the queues of a port share the same device interrupt, which the
+ * kernel driver masks each time it fires, whichever queue it fired for.
+ * This function enables it again for the other queues, so it must be
+ * called as soon as the caller is woken up: until then, the lcores
+ * sleeping on the other queues of the port are only woken up by their
+ * timeout.
+ *
+ * @param port_id
+ *   The port identifier of the Ethernet device.
+ * @param queue_id
+ *   The index of the receive queue.
+ * @return
+ *   - (0) if successful.
+ *   - (-ENOTSUP) if underlying hardware OR driver doesn't support
+ *     that operation, or RX queue interrupts are not configured.
+ *   - (-ENODEV) if *port_id* invalid.
+ *   - (-EINVAL) if *queue_id* invalid.
+ *   - (-EIO) if the device interrupt cannot be enabled again.
+ */
+int rte_eth_dev_rx_queue_intr_disable(uint8_t port_id, uint16_t queue_id);
+
+/**
+ * Wait for the receive interrupt of an RX queue of an Ethernet device.
+ *
+ * The interrupt must have been enabled by rte_eth_dev_rx_queue_intr_enable().
+ * All the queues of a port share the same device interrupt: a return
+ * value of 1 means that one of them may have received packets, so the
+ * caller must poll its queue to find out.
+ *
+ * @param port_id
+ *   The port identifier of the Ethernet device.
+ * @param queue_id
+ *   The index of the receive queue.
+ * @param timeout
+ *   Maximum time to wait in milliseconds, or -1 to wait forever.
+ * @return
+ *   - (1) if the device interrupt fired.
+ *   - (0) if the timeout expired.
+ *   - (-ENOTSUP) if RX queue interrupts are not configured.
+ *   - (-ENODEV) if *port_id* invalid.
+ *   - (-EINVAL) if *queue_id* invalid.
+ *   - (-EIO) if waiting on the interrupt failed.
+ */
+int rte_eth_dev_rx_queue_wait(uint8_t port_id, uint16_t queue_id,
+			      int timeout);
+
+/**
+ * Add the receive interrupt of an RX queue of an Ethernet device to an
+ * epoll set, so that an lcore can wait for all its queues at once with
+ * rte_intr_wait_epoll() instead of rte_eth_dev_rx_queue_wait().
+ *
+ * The interrupt must be enabled by rte_eth_dev_rx_queue_intr_enable()
+ * before each wait. As all the queues of a port share the same device
+ * interrupt, adding several queues of a port adds it once.
+ *
+ * @param port_id
+ *   The port identifier of the Ethernet device.
+ * @param queue_id
+ *   The index of the receive queue.
+ * @param epfd
+ *   The epoll set, created with epoll_create().
+ * @return
+ *   - (0) if successful.
+ *   - (-ENOTSUP) if RX queue interrupts are not configured.
+ *   - (-ENODEV) if *port_id* invalid.
+ *   - (-EINVAL) if *queue_id* invalid.
+ *   - (-EIO) if the interrupt could not be added to the set.
+ */
+int rte_eth_dev_rx_queue_intr_add(uint8_t port_id, uint16_t queue_id,
+				  int epfd);
+
 /**
  * Turn on the LED on the Ethernet device.
  * This function turns on the LED on the Ethernet device.
@@ -208,3 +208,102 @@ rte_fbk_hash_free(struct rte_fbk_hash_table *ht)
 	return;
 }
 
+
+/* Size of a serialized entry: a 4-byte key and its 2-byte value. */
+#define FBK_SERIALIZE_RECORD_SIZE	(sizeof(uint32_t) + sizeof(uint16_t))
+
+/**
+ * Get the size of the buffer needed to serialize a hash table.
+ *
+ * @param ht
+ *   Hash table to serialize.
+ */
+size_t
+rte_fbk_hash_serialize_size(const struct rte_fbk_hash_table *ht)
+{
+	if (ht == NULL)
+		return 0;
+	return sizeof(struct rte_fbk_hash_serialize_hdr) +
+		ht->used_entries * FBK_SERIALIZE_RECORD_SIZE;
+}
+
+/**
+ * Write all entries of a hash table to a buffer.
+ *
+ * @param ht
+ *   Hash table to serialize.
+ * @param buf
+ *   Buffer to write to.
+ * @param size
+ *   Size of the buffer.
+ */
+ssize_t
+rte_fbk_hash_serialize(const struct rte_fbk_hash_table *ht, void *buf,
+		       size_t size)
+{
+	struct rte_fbk_hash_serialize_hdr hdr;
+	uint8_t *rec = (uint8_t *)buf + sizeof(hdr);
+	uint8_t *end = (uint8_t *)buf + size;
+	uint32_t key, next = 0;
+	uint16_t value;
+
+	if (ht == NULL || buf == NULL)
+		return -EINVAL;
+	if (size < sizeof(hdr))
+		return -ENOSPC;
+
+	hdr.magic = RTE_FBK_HASH_SERIALIZE_MAGIC;
+	hdr.nb_keys = 0;
+	while (rte_fbk_hash_iterate(ht, &key, &value, &next) == 0) {
+		if ((size_t)(end - rec) < FBK_SERIALIZE_RECORD_SIZE)
+			return -ENOSPC;
+		memcpy(rec, &key, sizeof(key));
+		memcpy(rec + sizeof(key), &value, sizeof(value));
+		rec += FBK_SERIALIZE_RECORD_SIZE;
+		hdr.nb_keys++;
+	}
+
+	memcpy(buf, &hdr, sizeof(hdr));
+	return rec - (uint8_t *)buf;
+}
+
+/**
+ * Add all entries of a buffer written by rte_fbk_hash_serialize() to a hash
+ * table.
+ *
+ * @param ht
+ *   Hash table to add the entries to.
+ * @param buf
+ *   Buffer to read from.
+ * @param size
+ *   Size of the buffer.
+ */
+int
+rte_fbk_hash_deserialize(struct rte_fbk_hash_table *ht, const void *buf,
+			 size_t size)
+{
+	struct rte_fbk_hash_serialize_hdr hdr;
+	const uint8_t *rec = (const uint8_t *)buf + sizeof(hdr);
+	uint32_t i, key;
+	uint16_t value;
+	int ret;
+
+	if (ht == NULL || buf == NULL || size < sizeof(hdr))
+		return -EINVAL;
+
+	memcpy(&hdr, buf, sizeof(hdr));
+	if (hdr.magic != RTE_FBK_HASH_SERIALIZE_MAGIC ||
+	    (size - sizeof(hdr)) / FBK_SERIALIZE_RECORD_SIZE < hdr.nb_keys)
+		return -EINVAL;
+
+	for (i = 0; i < hdr.nb_keys; i++) {
+		memcpy(&key, rec, sizeof(key));
+		memcpy(&value, rec + sizeof(key), sizeof(value));
+		ret = rte_fbk_hash_add_key(ht, key, value);
+		if (ret < 0)
+			return ret;
+		rec += FBK_SERIALIZE_RECORD_SIZE;
+	}
+
+	return (int)hdr.nb_keys;
+}
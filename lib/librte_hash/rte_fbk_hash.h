@@ -47,8 +47,10 @@
  */
 
 #include <stdint.h>
+#include <stddef.h>
 #include <errno.h>
 #include <sys/queue.h>
+#include <sys/types.h>
 #include <rte_hash_crc.h>
 
 #ifdef __cplusplus
@@ -269,6 +271,48 @@ rte_fbk_hash_clear_all(struct rte_fbk_hash_table *ht)
 	ht->used_entries = 0;
 }
 
+/**
+ * Get the next entry of a hash table, to walk all entries, e.g. to age them
+ * a slice at a time. The cursor starts at 0 and is updated by each call.
+ * Entries of a bucket are walked from the last one, so deleting the returned
+ * key, which moves the last entry of its bucket into its place, does not
+ * disturb the walk. Keys added during the walk may or may not be returned.
+ * This operation is not multi-thread safe and should only be called from
+ * the thread changing the table.
+ *
+ * @param ht
+ *   Hash table to walk.
+ * @param key
+ *   Output containing the key of the entry.
+ * @param value
+ *   Output containing the value of the entry.
+ * @param next
+ *   Cursor of the walk, 0 to start from the first entry.
+ * @return
+ *   0 if an entry was returned, or -ENOENT if there are no more entries.
+ */
+static inline int
+rte_fbk_hash_iterate(const struct rte_fbk_hash_table *ht, uint32_t *key,
+		     uint16_t *value, uint32_t *next)
+{
+	uint32_t i, bucket, slot;
+
+	for (i = *next; i < ht->entries; i++) {
+		bucket = i & ~(ht->entries_per_bucket - 1);
+		slot = ht->entries_per_bucket - 1 -
+				(i & (ht->entries_per_bucket - 1));
+		if (ht->t[bucket + slot].entry.is_entry) {
+			*key = ht->t[bucket + slot].entry.key;
+			*value = ht->t[bucket + slot].entry.value;
+			*next = i + 1;
+			return 0;
+		}
+	}
+
+	*next = ht->entries;
+	return -ENOENT;
+}
+
 /**
  * Find what fraction of entries are being used.
  *
@@ -327,6 +371,67 @@ rte_fbk_hash_create(const struct rte_fbk_hash_params *params);
  */
 void rte_fbk_hash_free(struct rte_fbk_hash_table *ht);
 
+/** Value of the magic field of a serialized four-byte key hash table. */
+#define RTE_FBK_HASH_SERIALIZE_MAGIC	0x46424b31
+
+/**
+ * Header of the buffer written by rte_fbk_hash_serialize(). It is followed
+ * by nb_keys packed records of a 4-byte key and its 2-byte value.
+ */
+struct rte_fbk_hash_serialize_hdr {
+	uint32_t magic;		/**< RTE_FBK_HASH_SERIALIZE_MAGIC. */
+	uint32_t nb_keys;	/**< Number of records. */
+};
+
+/**
+ * Get the size of the buffer needed to serialize a hash table.
+ *
+ * @param ht
+ *   Hash table to serialize.
+ * @return
+ *   The size in bytes, or 0 if ht is NULL.
+ */
+size_t rte_fbk_hash_serialize_size(const struct rte_fbk_hash_table *ht);
+
+/**
+ * Write all entries of a hash table to a buffer, e.g. to restore them after
+ * a restart with rte_fbk_hash_deserialize(). This operation is not
+ * multi-thread safe, see rte_fbk_hash_iterate().
+ *
+ * @param ht
+ *   Hash table to serialize.
+ * @param buf
+ *   Buffer to write to.
+ * @param size
+ *   Size of the buffer, see rte_fbk_hash_serialize_size().
+ * @return
+ *   - -EINVAL if the parameters are invalid.
+ *   - -ENOSPC if the buffer is too small.
+ *   - The number of bytes written.
+ */
+ssize_t rte_fbk_hash_serialize(const struct rte_fbk_hash_table *ht,
+			       void *buf, size_t size);
+
+/**
+ * Add all entries of a buffer written by rte_fbk_hash_serialize() to a hash
+ * table, which may have a different size or hash function. This operation
+ * is not multi-thread safe, see rte_fbk_hash_add_key().
+ *
+ * @param ht
+ *   Hash table to add the entries to.
+ * @param buf
+ *   Buffer to read from.
+ * @param size
+ *   Size of the buffer.
+ * @return
+ *   - -EINVAL if the parameters are invalid or the buffer is malformed.
+ *   - -ENOSPC if there is no space in the hash for a key, in which case the
+ *     keys before it have been added.
+ *   - The number of entries added.
+ */
+int rte_fbk_hash_deserialize(struct rte_fbk_hash_table *ht, const void *buf,
+			     size_t size);
+
 #ifdef __cplusplus
 }
 #endif
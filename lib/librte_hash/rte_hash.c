@@ -39,11 +39,15 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <sys/queue.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include <rte_common.h>
 #include <rte_memory.h>         /* for definition of CACHE_LINE_SIZE */
 #include <rte_log.h>
 #include <rte_memcpy.h>
+#include <rte_atomic.h>
 #include <rte_prefetch.h>
 #include <rte_branch_prediction.h>
 #include <rte_memzone.h>
@@ -96,6 +100,63 @@ static struct rte_hash_list *hash_list;
 /* The high bit is always set in real signatures */
 #define NULL_SIGNATURE          0
 
+/* Mixing constant used to derive the alternative bucket of a signature */
+#define CUCKOO_ALT_MULT         0x5bd1e995
+
+/* Maximum number of buckets visited when searching for a cuckoo path */
+#define CUCKOO_BFS_MAX          512
+
+/* Grow a resizable hash when more than 3/4 of its entries are used */
+#define RESIZE_LOAD_NUM         3
+#define RESIZE_LOAD_DEN         4
+
+/* Allocate the next table of a resizable hash once half of them are used */
+#define RESIZE_PREPARE_NUM      1
+#define RESIZE_PREPARE_DEN      2
+
+/* Minimum number of bytes of the next table zeroed by each add */
+#define RESIZE_PREPARE_MIN      4096
+
+/* Adds waited for before allocating the next table again after a failure,
+ * doubled after each failure */
+#define RESIZE_ALLOC_BACKOFF_MIN 64
+#define RESIZE_ALLOC_BACKOFF_MAX (1 << 16)
+
+/* Buckets of the previous table moved by each change of a resizable hash */
+#define RESIZE_MIGRATE_BUCKETS  4
+
+/* Maximum number of tables allocated by a resizable hash */
+#define RESIZE_TABLES_MAX       32
+
+/* Bit of the walk cursor of a resizable hash set once in its current table */
+#define RESIZE_ITER_CUR         0x80000000
+
+/*
+ * State of a resizable hash. Tables replaced by a larger one are only freed
+ * with the hash, as lookups running concurrently may still read them.
+ */
+struct rte_hash_resize {
+	struct rte_hash *cur;		/* table keys are added to */
+	struct rte_hash *old;		/* table being migrated, or NULL */
+	struct rte_hash *next;		/* table being prepared, or NULL */
+	uint32_t next_zeroed;		/* bytes of next zeroed so far */
+	uint32_t next_slots;		/* free slots of next set so far */
+	uint32_t alloc_backoff;		/* adds between allocation attempts */
+	uint32_t alloc_wait;		/* adds left before the next attempt */
+	uint32_t migrate_bucket;	/* next bucket of old to migrate */
+	uint32_t nb_keys;		/* keys in both tables */
+	int socket_id;			/* NUMA socket of the tables */
+	uint32_t nb_tables;		/* tables allocated so far */
+	struct rte_hash *tables[RESIZE_TABLES_MAX];
+};
+
+/* Bucket visited by the cuckoo path search */
+struct cuckoo_node {
+	uint32_t bkt;		/* bucket index */
+	int32_t parent;		/* node the entry moving here comes from */
+	uint32_t slot;		/* slot of that entry in the parent bucket */
+};
+
 /* Returns a pointer to the first signature in specified bucket. */
 static inline hash_sig_t *
 get_sig_tbl_bucket(const struct rte_hash *h, uint32_t bucket_index)
@@ -119,6 +180,135 @@ get_key_from_bucket(const struct rte_hash *h, uint8_t *bkt, uint32_t pos)
 	return (void *) &bkt[pos * h->key_tbl_key_size];
 }
 
+/* Returns a pointer to the first key index in specified bucket. */
+static inline uint32_t *
+get_idx_tbl_bucket(const struct rte_hash *h, uint32_t bucket_index)
+{
+	return (uint32_t *)
+			&(h->idx_tbl[bucket_index * h->sig_tbl_bucket_size]);
+}
+
+/*
+ * Returns a pointer to the data stored with the key at a position. Keys are
+ * stored in position order in both modes.
+ */
+static inline void **
+get_data_from_position(const struct rte_hash *h, uint32_t pos)
+{
+	return (void **) &(h->key_tbl[pos * h->key_tbl_key_size +
+				      h->key_tbl_data_offset]);
+}
+
+/* Sets the data of the key at a position, in tables that store data. */
+static inline void
+set_data(const struct rte_hash *h, uint32_t pos, void *data)
+{
+	if (h->flags & HASH_F_DATA)
+		*get_data_from_position(h, pos) = data;
+}
+
+/*
+ * Returns a pointer to the key stored at a position, which is the key index
+ * in cuckoo mode.
+ */
+static inline void *
+get_key_from_index(const struct rte_hash *h, uint32_t idx)
+{
+	return (void *) &(h->key_tbl[idx * h->key_tbl_key_size]);
+}
+
+/*
+ * Returns the other candidate bucket of a signature stored in a bucket. It
+ * only depends on the signature and the current bucket, so entries can be
+ * moved without access to their key. Xoring an odd value makes sure both
+ * buckets differ when there is more than one.
+ */
+static inline uint32_t
+get_alt_bucket_index(const struct rte_hash *h, uint32_t bucket_index,
+		     hash_sig_t sig)
+{
+	return (bucket_index ^ (((sig >> 16) * CUCKOO_ALT_MULT) | 1)) &
+		h->bucket_bitmask;
+}
+
+/*
+ * Table changes are bracketed by two version increments, so that lookups
+ * running on other lcores can detect them without taking a lock.
+ */
+static inline void
+version_write_begin(const struct rte_hash *h)
+{
+	(*h->version)++;
+	rte_wmb();
+}
+
+static inline void
+version_write_end(const struct rte_hash *h)
+{
+	rte_wmb();
+	(*h->version)++;
+}
+
+static inline uint32_t
+version_read_begin(const struct rte_hash *h)
+{
+	uint32_t version = *h->version;
+
+	rte_rmb();
+	return version;
+}
+
+/* Returns true if the table changed since version_read_begin(). */
+static inline int
+version_read_retry(const struct rte_hash *h, uint32_t version)
+{
+	rte_rmb();
+	return unlikely((version & 1) || (*h->version != version));
+}
+
+/*
+ * Returns a bitmask of the slots of a bucket holding a signature. The
+ * bucket size is a multiple of SIG_BUCKET_ALIGNMENT, and unused slots at
+ * the end of a bucket never match as real signatures have the high bit set.
+ */
+static inline uint32_t
+compare_signatures(const struct rte_hash *h, const hash_sig_t *sig_bucket,
+		   hash_sig_t sig)
+{
+	uint32_t mask = 0, i;
+#if defined(__SSE2__)
+	const __m128i *sigs = (const __m128i *)sig_bucket;
+	__m128i sig_x4 = _mm_set1_epi32(sig);
+
+	for (i = 0; i < h->sig_tbl_bucket_size / sizeof(__m128i); i++)
+		mask |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(
+			_mm_cmpeq_epi32(_mm_load_si128(&sigs[i]), sig_x4))) <<
+			(i * 4);
+#else
+	for (i = 0; i < h->bucket_entries; i++)
+		if (sig_bucket[i] == sig)
+			mask |= 1 << i;
+#endif
+	return mask & ((1 << h->bucket_entries) - 1);
+}
+
+/*
+ * Returns the position of a signature matched by lookup_bulk(), the bits of
+ * the secondary bucket of cuckoo tables following those of the primary one.
+ */
+static inline uint32_t
+get_match_position(const struct rte_hash *h, uint32_t prim, uint32_t sec,
+		   uint32_t bit)
+{
+	uint32_t slot = bit % RTE_HASH_BUCKET_ENTRIES_MAX;
+	uint32_t bucket_index = (bit < RTE_HASH_BUCKET_ENTRIES_MAX) ?
+		prim : sec;
+
+	if (h->flags & HASH_F_CUCKOO)
+		return get_idx_tbl_bucket(h, bucket_index)[slot];
+	return bucket_index * h->bucket_entries + slot;
+}
+
 /* Does integer division with rounding-up of result. */
 static inline uint32_t
 div_roundup(uint32_t numerator, uint32_t denominator)
@@ -162,37 +352,21 @@ rte_hash_find_existing(const char *name)
 	return h;
 }
 
-struct rte_hash *
-rte_hash_create(const struct rte_hash_parameters *params)
+/*
+ * Allocates and initialises a table, which is not added to the list of
+ * tables. Parameters must have been checked. Unless zero is set, only the
+ * table header is initialised: signatures, keys and free slots are left
+ * to the caller.
+ */
+static struct rte_hash *
+hash_table_alloc(const struct rte_hash_parameters *params,
+		 const char *mem_name, int zero)
 {
 	struct rte_hash *h = NULL;
-	uint32_t num_buckets, sig_bucket_size, key_size,
-		hash_tbl_size, sig_tbl_size, key_tbl_size, mem_size;
-	char hash_name[RTE_HASH_NAMESIZE];
-
-	if (rte_eal_process_type() == RTE_PROC_SECONDARY){
-		rte_errno = E_RTE_SECONDARY;
-		return NULL;
-	}
-
-	/* check that we have an initialised tail queue */
-	CHECK_HASH_LIST_CREATED();
-
-	/* Check for valid parameters */
-	if ((params == NULL) ||
-			(params->entries > RTE_HASH_ENTRIES_MAX) ||
-			(params->bucket_entries > RTE_HASH_BUCKET_ENTRIES_MAX) ||
-			(params->entries < params->bucket_entries) ||
-			!rte_is_power_of_2(params->entries) ||
-			!rte_is_power_of_2(params->bucket_entries) ||
-			(params->key_len == 0) ||
-			(params->key_len > RTE_HASH_KEY_LENGTH_MAX)) {
-		rte_errno = EINVAL;
-		RTE_LOG(ERR, HASH, "rte_hash_create has invalid parameters\n");
-		return NULL;
-	}
-
-	rte_snprintf(hash_name, sizeof(hash_name), "HT_%s", params->name);
+	uint32_t num_buckets, sig_bucket_size, key_size, data_offset,
+		hash_tbl_size, sig_tbl_size, key_tbl_size, idx_tbl_size,
+		free_slots_size, mem_size, i;
+	int cuckoo = (params->flags & HASH_F_CUCKOO) != 0;
 
 	/* Calculate hash dimensions */
 	num_buckets = params->entries / params->bucket_entries;
@@ -200,33 +374,56 @@ rte_hash_create(const struct rte_hash_parameters *params)
 				     sizeof(hash_sig_t), SIG_BUCKET_ALIGNMENT);
 	key_size =  align_size(params->key_len, KEY_ALIGNMENT);
 
-	hash_tbl_size = align_size(sizeof(struct rte_hash), CACHE_LINE_SIZE);
+	/* Data is stored right after the key, in the same key slot, so that
+	 * it is in the cache line already loaded to compare the key */
+	data_offset = 0;
+	if (params->flags & HASH_F_DATA) {
+		data_offset = align_size(params->key_len, sizeof(void *));
+		key_size = align_size(data_offset + sizeof(void *),
+				      KEY_ALIGNMENT);
+	}
+
+	/* The version counter written by each change gets its own line */
+	hash_tbl_size = align_size(sizeof(struct rte_hash), CACHE_LINE_SIZE) +
+		CACHE_LINE_SIZE;
 	sig_tbl_size = align_size(num_buckets * sig_bucket_size,
 				  CACHE_LINE_SIZE);
 	key_tbl_size = align_size(num_buckets * key_size *
 				  params->bucket_entries, CACHE_LINE_SIZE);
 
+	/* Cuckoo tables store key indexes next to signatures, so that keys
+	 * do not move when their signature moves to another bucket */
+	idx_tbl_size = 0;
+	free_slots_size = 0;
+	if (cuckoo) {
+		idx_tbl_size = sig_tbl_size;
+		free_slots_size = align_size(sizeof(struct rte_hash_free_slots) +
+				params->entries * sizeof(uint32_t),
+				CACHE_LINE_SIZE);
+	}
+
 	/* Total memory required for hash context */
-	mem_size = hash_tbl_size + sig_tbl_size + key_tbl_size;
+	mem_size = hash_tbl_size + sig_tbl_size + key_tbl_size +
+		idx_tbl_size + free_slots_size;
 
 	/* Allocate as a memzone, or in normal memory space */
 #if defined(RTE_LIBRTE_HASH_USE_MEMZONE)
 	const struct rte_memzone *mz;
-	mz = rte_memzone_reserve(hash_name, mem_size, params->socket_id, 0);
+	mz = rte_memzone_reserve(mem_name, mem_size, params->socket_id, 0);
 	if (mz == NULL) {
 		RTE_LOG(ERR, HASH, "memzone reservation failed\n");
 		return NULL;
 	}
-	memset(mz->addr, 0, mem_size);
 	h = (struct rte_hash *)mz->addr;
 #else
-	h = (struct rte_hash *)rte_zmalloc(hash_name, mem_size,
-					   CACHE_LINE_SIZE);
+	h = (struct rte_hash *)rte_malloc(mem_name, mem_size,
+					  CACHE_LINE_SIZE);
 	if (h == NULL) {
 		RTE_LOG(ERR, HASH, "memory allocation failed\n");
 		return NULL;
 	}
 #endif
+	memset(h, 0, zero ? mem_size : hash_tbl_size);
 
 	/* Setup hash context */
 	rte_snprintf(h->name, sizeof(h->name), "%s", params->name);
@@ -237,10 +434,25 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	h->num_buckets = num_buckets;
 	h->bucket_bitmask = h->num_buckets - 1;
 	h->sig_msb = 1 << (sizeof(hash_sig_t) * 8 - 1);
+	h->version = (volatile uint32_t *)((uint8_t *)h + hash_tbl_size -
+					   CACHE_LINE_SIZE);
 	h->sig_tbl = (uint8_t *)h + hash_tbl_size;
 	h->sig_tbl_bucket_size = sig_bucket_size;
 	h->key_tbl = h->sig_tbl + sig_tbl_size;
 	h->key_tbl_key_size = key_size;
+	h->key_tbl_data_offset = data_offset;
+	h->flags = params->flags;
+	if (cuckoo) {
+		h->idx_tbl = h->key_tbl + key_tbl_size;
+		h->free_slots = (struct rte_hash_free_slots *)
+			(h->idx_tbl + idx_tbl_size);
+		if (zero) {
+			/* hand out low key indexes first */
+			for (i = 0; i < params->entries; i++)
+				h->free_slots->idx[i] = params->entries - 1 - i;
+			h->free_slots->count = params->entries;
+		}
+	}
 	h->hash_func = (params->hash_func == NULL) ?
 		DEFAULT_HASH_FUNC : params->hash_func;
 
@@ -252,6 +464,143 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		h->hash_func = rte_jhash;
 	}
 
+	return h;
+}
+
+/*
+ * Allocates a table of a resizable hash, with twice as many entries as the
+ * current one, or with the entries given at creation for the first one.
+ * Only the first one is zeroed, see resize_prepare().
+ */
+static struct rte_hash *
+resize_table_alloc(const struct rte_hash *h)
+{
+	struct rte_hash_resize *r = h->resize;
+	struct rte_hash_parameters params;
+	char mem_name[RTE_HASH_NAMESIZE];
+	struct rte_hash *t;
+
+	if (r->nb_tables == RESIZE_TABLES_MAX ||
+	    (r->cur != NULL && r->cur->entries * 2 > RTE_HASH_ENTRIES_MAX))
+		return NULL;
+
+	memset(&params, 0, sizeof(params));
+	params.name = h->name;
+	params.entries = (r->cur == NULL) ? h->entries : r->cur->entries * 2;
+	params.bucket_entries = h->bucket_entries;
+	params.key_len = h->key_len;
+	params.hash_func = h->hash_func;
+	params.hash_func_init_val = h->hash_func_init_val;
+	params.socket_id = r->socket_id;
+	params.flags = h->flags & ~HASH_F_RESIZE;
+
+	rte_snprintf(mem_name, sizeof(mem_name), "HT_%s_%u", h->name,
+		     r->nb_tables);
+	t = hash_table_alloc(&params, mem_name, r->cur == NULL);
+	if (t != NULL)
+		r->tables[r->nb_tables++] = t;
+	return t;
+}
+
+/*
+ * Resizable hashes are a handle to the tables holding the keys, which
+ * lookups get through the handle, so it never changes.
+ */
+static struct rte_hash *
+resize_create(const struct rte_hash_parameters *params, const char *mem_name)
+{
+	struct rte_hash *h = NULL;
+	uint32_t hash_tbl_size, mem_size;
+
+	hash_tbl_size = align_size(sizeof(struct rte_hash), CACHE_LINE_SIZE) +
+		CACHE_LINE_SIZE;
+	mem_size = hash_tbl_size +
+		align_size(sizeof(struct rte_hash_resize), CACHE_LINE_SIZE);
+
+#if defined(RTE_LIBRTE_HASH_USE_MEMZONE)
+	const struct rte_memzone *mz;
+	mz = rte_memzone_reserve(mem_name, mem_size, params->socket_id, 0);
+	if (mz == NULL) {
+		RTE_LOG(ERR, HASH, "memzone reservation failed\n");
+		return NULL;
+	}
+	memset(mz->addr, 0, mem_size);
+	h = (struct rte_hash *)mz->addr;
+#else
+	h = (struct rte_hash *)rte_zmalloc(mem_name, mem_size,
+					   CACHE_LINE_SIZE);
+	if (h == NULL) {
+		RTE_LOG(ERR, HASH, "memory allocation failed\n");
+		return NULL;
+	}
+#endif
+
+	rte_snprintf(h->name, sizeof(h->name), "%s", params->name);
+	h->entries = params->entries;
+	h->bucket_entries = params->bucket_entries;
+	h->key_len = params->key_len;
+	h->hash_func = params->hash_func;
+	h->hash_func_init_val = params->hash_func_init_val;
+	h->sig_msb = 1 << (sizeof(hash_sig_t) * 8 - 1);
+	h->version = (volatile uint32_t *)((uint8_t *)h + hash_tbl_size -
+					   CACHE_LINE_SIZE);
+	h->flags = params->flags;
+	h->resize = (struct rte_hash_resize *)((uint8_t *)h + hash_tbl_size);
+	h->resize->socket_id = params->socket_id;
+
+	h->resize->cur = resize_table_alloc(h);
+	if (h->resize->cur == NULL) {
+#if !defined(RTE_LIBRTE_HASH_USE_MEMZONE)
+		rte_free(h);
+#endif
+		return NULL;
+	}
+	/* use the hash function after the SSE4.2 check */
+	h->hash_func = h->resize->cur->hash_func;
+	return h;
+}
+
+struct rte_hash *
+rte_hash_create(const struct rte_hash_parameters *params)
+{
+	struct rte_hash *h = NULL;
+	char hash_name[RTE_HASH_NAMESIZE];
+
+	if (rte_eal_process_type() == RTE_PROC_SECONDARY){
+		rte_errno = E_RTE_SECONDARY;
+		return NULL;
+	}
+
+	/* check that we have an initialised tail queue */
+	CHECK_HASH_LIST_CREATED();
+
+	/* Check for valid parameters */
+	if ((params == NULL) ||
+			(params->entries > RTE_HASH_ENTRIES_MAX) ||
+			(params->bucket_entries > RTE_HASH_BUCKET_ENTRIES_MAX) ||
+			(params->entries < params->bucket_entries) ||
+			!rte_is_power_of_2(params->entries) ||
+			!rte_is_power_of_2(params->bucket_entries) ||
+			(params->key_len == 0) ||
+			(params->key_len > RTE_HASH_KEY_LENGTH_MAX) ||
+			(params->flags & ~(HASH_F_CUCKOO | HASH_F_DATA |
+					   HASH_F_RESIZE)) ||
+			((params->flags & HASH_F_RESIZE) &&
+			 (~params->flags & (HASH_F_CUCKOO | HASH_F_DATA)))) {
+		rte_errno = EINVAL;
+		RTE_LOG(ERR, HASH, "rte_hash_create has invalid parameters\n");
+		return NULL;
+	}
+
+	rte_snprintf(hash_name, sizeof(hash_name), "HT_%s", params->name);
+
+	if (params->flags & HASH_F_RESIZE)
+		h = resize_create(params, hash_name);
+	else
+		h = hash_table_alloc(params, hash_name, 1);
+	if (h == NULL)
+		return NULL;
+
 	TAILQ_INSERT_TAIL(hash_list, h, next);
 	return h;
 }
@@ -263,93 +612,227 @@ rte_hash_free(struct rte_hash *h)
 		return;
 #if !defined(RTE_LIBRTE_HASH_USE_MEMZONE)
 	TAILQ_REMOVE(hash_list, h, next);
+	if (h->flags & HASH_F_RESIZE) {
+		uint32_t i;
+		for (i = 0; i < h->resize->nb_tables; i++)
+			rte_free(h->resize->tables[i]);
+	}
 	rte_free(h);
 #endif
 	/* No way to deallocate memzones */
 	return;
 }
 
-int32_t
-rte_hash_add_key(const struct rte_hash *h, const void *key)
+/* Looks a key up in both candidate buckets of a cuckoo table. */
+static inline int32_t
+cuckoo_lookup(const struct rte_hash *h, const void *key, hash_sig_t sig)
 {
-	hash_sig_t sig, *sig_bucket;
-	uint8_t *key_bucket;
+	hash_sig_t *sig_bucket;
+	uint32_t *idx_bucket;
 	uint32_t bucket_index, i;
-	int32_t pos;
-
-	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
 
-	/* Get the hash signature and bucket index */
-	sig = h->hash_func(key, h->key_len, h->hash_func_init_val) | h->sig_msb;
 	bucket_index = sig & h->bucket_bitmask;
 	sig_bucket = get_sig_tbl_bucket(h, bucket_index);
-	key_bucket = get_key_tbl_bucket(h, bucket_index);
+	idx_bucket = get_idx_tbl_bucket(h, bucket_index);
+	for (i = 0; i < h->bucket_entries; i++) {
+		if ((sig == sig_bucket[i]) &&
+		    likely(memcmp(key, get_key_from_index(h, idx_bucket[i]),
+				  h->key_len) == 0))
+			return idx_bucket[i];
+	}
 
-	/* Check if key is already present in the hash */
+	bucket_index = get_alt_bucket_index(h, bucket_index, sig);
+	sig_bucket = get_sig_tbl_bucket(h, bucket_index);
+	idx_bucket = get_idx_tbl_bucket(h, bucket_index);
 	for (i = 0; i < h->bucket_entries; i++) {
 		if ((sig == sig_bucket[i]) &&
-		    likely(memcmp(key, get_key_from_bucket(h, key_bucket, i),
-				  h->key_len) == 0)) {
-			return bucket_index * h->bucket_entries + i;
+		    likely(memcmp(key, get_key_from_index(h, idx_bucket[i]),
+				  h->key_len) == 0))
+			return idx_bucket[i];
+	}
+
+	return -ENOENT;
+}
+
+/*
+ * Moves the entries along a path found by cuckoo_make_space(), starting from
+ * its end, so that every entry stays present in the table. Returns the slot
+ * freed in the first bucket of the path.
+ */
+static int
+cuckoo_move_path(const struct rte_hash *h, const struct cuckoo_node *nodes,
+		 int32_t n, int pos, uint32_t *bucket_index)
+{
+	const struct cuckoo_node *from;
+	hash_sig_t *from_sig, *to_sig;
+	uint32_t *from_idx, *to_idx;
+
+	while (nodes[n].parent >= 0) {
+		from = &nodes[nodes[n].parent];
+		from_sig = get_sig_tbl_bucket(h, from->bkt);
+		from_idx = get_idx_tbl_bucket(h, from->bkt);
+		to_sig = get_sig_tbl_bucket(h, nodes[n].bkt);
+		to_idx = get_idx_tbl_bucket(h, nodes[n].bkt);
+
+		/* a bucket may appear twice on the path, so check that the
+		 * entry still belongs to the destination bucket */
+		if (unlikely(to_sig[pos] != NULL_SIGNATURE ||
+			     get_alt_bucket_index(h, from->bkt,
+				     from_sig[nodes[n].slot]) != nodes[n].bkt))
+			return -ENOSPC;
+
+		to_idx[pos] = from_idx[nodes[n].slot];
+		to_sig[pos] = from_sig[nodes[n].slot];
+		from_sig[nodes[n].slot] = NULL_SIGNATURE;
+
+		pos = nodes[n].slot;
+		n = nodes[n].parent;
+	}
+
+	*bucket_index = nodes[n].bkt;
+	return pos;
+}
+
+/*
+ * Makes room in one of two full buckets by displacing entries to their
+ * alternative bucket. The shortest path to a bucket with a free slot is
+ * searched breadth first, so as few entries as possible are moved.
+ */
+static int
+cuckoo_make_space(const struct rte_hash *h, uint32_t prim, uint32_t sec,
+		  uint32_t *bucket_index)
+{
+	struct cuckoo_node nodes[CUCKOO_BFS_MAX];
+	hash_sig_t *sig_bucket;
+	int32_t head, tail;
+	uint32_t i;
+	int pos;
+
+	nodes[0].bkt = prim;
+	nodes[0].parent = -1;
+	nodes[0].slot = 0;
+	nodes[1].bkt = sec;
+	nodes[1].parent = -1;
+	nodes[1].slot = 0;
+	tail = 2;
+
+	for (head = 0; head < tail; head++) {
+		sig_bucket = get_sig_tbl_bucket(h, nodes[head].bkt);
+		pos = find_first(NULL_SIGNATURE, sig_bucket, h->bucket_entries);
+		if (pos >= 0)
+			return cuckoo_move_path(h, nodes, head, pos,
+						bucket_index);
+
+		for (i = 0; i < h->bucket_entries && tail < CUCKOO_BFS_MAX;
+		     i++, tail++) {
+			nodes[tail].bkt = get_alt_bucket_index(h,
+					nodes[head].bkt, sig_bucket[i]);
+			nodes[tail].parent = head;
+			nodes[tail].slot = i;
 		}
 	}
 
-	/* Check if any free slot within the bucket to add the new key */
-	pos = find_first(NULL_SIGNATURE, sig_bucket, h->bucket_entries);
+	return -ENOSPC;
+}
+
+static int32_t
+cuckoo_add_key(const struct rte_hash *h, const void *key, hash_sig_t sig,
+	       void *data, int update)
+{
+	hash_sig_t *sig_bucket;
+	uint32_t *idx_bucket;
+	uint32_t prim, sec, bucket_index, idx;
+	int32_t ret;
+	int pos;
 
-	if (unlikely(pos < 0))
+	ret = cuckoo_lookup(h, key, sig);
+	if (ret >= 0) {
+		if (update) {
+			version_write_begin(h);
+			set_data(h, ret, data);
+			version_write_end(h);
+		}
+		return ret;
+	}
+
+	if (unlikely(h->free_slots->count == 0))
 		return -ENOSPC;
 
-	/* Add the new key to the bucket */
+	version_write_begin(h);
+
+	/* Use a free slot in either bucket, or make one */
+	prim = sig & h->bucket_bitmask;
+	sec = get_alt_bucket_index(h, prim, sig);
+	bucket_index = prim;
+	pos = find_first(NULL_SIGNATURE, get_sig_tbl_bucket(h, prim),
+			 h->bucket_entries);
+	if (pos < 0) {
+		bucket_index = sec;
+		pos = find_first(NULL_SIGNATURE, get_sig_tbl_bucket(h, sec),
+				 h->bucket_entries);
+	}
+	if (pos < 0)
+		pos = cuckoo_make_space(h, prim, sec, &bucket_index);
+	if (unlikely(pos < 0)) {
+		version_write_end(h);
+		return -ENOSPC;
+	}
+
+	/* Store the key before publishing its signature */
+	idx = h->free_slots->idx[--h->free_slots->count];
+	rte_memcpy(get_key_from_index(h, idx), key, h->key_len);
+	set_data(h, idx, data);
+	sig_bucket = get_sig_tbl_bucket(h, bucket_index);
+	idx_bucket = get_idx_tbl_bucket(h, bucket_index);
+	idx_bucket[pos] = idx;
 	sig_bucket[pos] = sig;
-	rte_memcpy(get_key_from_bucket(h, key_bucket, pos), key, h->key_len);
-	return bucket_index * h->bucket_entries + pos;
+
+	version_write_end(h);
+	return idx;
 }
 
-int32_t
-rte_hash_del_key(const struct rte_hash *h, const void *key)
+static int32_t
+cuckoo_del_key(const struct rte_hash *h, const void *key, hash_sig_t sig)
 {
-	hash_sig_t sig, *sig_bucket;
-	uint8_t *key_bucket;
-	uint32_t bucket_index, i;
-
-	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
+	hash_sig_t *sig_bucket;
+	uint32_t *idx_bucket;
+	uint32_t bucket_index, i, n;
 
-	/* Get the hash signature and bucket index */
-	sig = h->hash_func(key, h->key_len, h->hash_func_init_val) | h->sig_msb;
 	bucket_index = sig & h->bucket_bitmask;
-	sig_bucket = get_sig_tbl_bucket(h, bucket_index);
-	key_bucket = get_key_tbl_bucket(h, bucket_index);
-
-	/* Check if key is already present in the hash */
-	for (i = 0; i < h->bucket_entries; i++) {
-		if ((sig == sig_bucket[i]) &&
-		    likely(memcmp(key, get_key_from_bucket(h, key_bucket, i),
-				  h->key_len) == 0)) {
-			sig_bucket[i] = NULL_SIGNATURE;
-			return bucket_index * h->bucket_entries + i;
+	for (n = 0; n < 2; n++) {
+		sig_bucket = get_sig_tbl_bucket(h, bucket_index);
+		idx_bucket = get_idx_tbl_bucket(h, bucket_index);
+		for (i = 0; i < h->bucket_entries; i++) {
+			if ((sig == sig_bucket[i]) &&
+			    likely(memcmp(key,
+					  get_key_from_index(h, idx_bucket[i]),
+					  h->key_len) == 0)) {
+				version_write_begin(h);
+				sig_bucket[i] = NULL_SIGNATURE;
+				h->free_slots->idx[h->free_slots->count++] =
+					idx_bucket[i];
+				version_write_end(h);
+				return idx_bucket[i];
+			}
 		}
+		bucket_index = get_alt_bucket_index(h, bucket_index, sig);
 	}
 
 	return -ENOENT;
 }
 
-int32_t
-rte_hash_lookup(const struct rte_hash *h, const void *key)
+/* Looks a key up in the only bucket it can be stored in. */
+static inline int32_t
+bucket_lookup(const struct rte_hash *h, const void *key, hash_sig_t sig)
 {
-	hash_sig_t sig, *sig_bucket;
+	hash_sig_t *sig_bucket;
 	uint8_t *key_bucket;
 	uint32_t bucket_index, i;
 
-	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
-
-	/* Get the hash signature and bucket index */
-	sig = h->hash_func(key, h->key_len, h->hash_func_init_val) | h->sig_msb;
 	bucket_index = sig & h->bucket_bitmask;
 	sig_bucket = get_sig_tbl_bucket(h, bucket_index);
 	key_bucket = get_key_tbl_bucket(h, bucket_index);
 
-	/* Check if key is already present in the hash */
 	for (i = 0; i < h->bucket_entries; i++) {
 		if ((sig == sig_bucket[i]) &&
 		    likely(memcmp(key, get_key_from_bucket(h, key_bucket, i),
@@ -361,47 +844,958 @@ rte_hash_lookup(const struct rte_hash *h, const void *key)
 	return -ENOENT;
 }
 
-int
+static inline int32_t
+lookup_with_sig(const struct rte_hash *h, const void *key, hash_sig_t sig)
+{
+	if (h->flags & HASH_F_CUCKOO)
+		return cuckoo_lookup(h, key, sig);
+	return bucket_lookup(h, key, sig);
+}
+
+static int32_t resize_add_key(const struct rte_hash *h, const void *key,
+			      hash_sig_t sig, void *data, int update);
+static int32_t resize_del_key(const struct rte_hash *h, const void *key,
+			      hash_sig_t sig);
+static int32_t resize_lookup(const struct rte_hash *h, const void *key,
+			     hash_sig_t sig, void **data);
+static uint64_t resize_lookup_bulk(const struct rte_hash *h,
+				   const void **keys,
+				   const hash_sig_t *key_sigs,
+				   uint32_t num_keys, int32_t *positions,
+				   void **data);
+
+/*
+ * Adds a key, or finds it if already present. The data of a new key is set
+ * to data, and the data of an existing key is only changed if update is set.
+ */
+static int32_t
+add_key_with_sig(const struct rte_hash *h, const void *key, hash_sig_t sig,
+		 void *data, int update)
+{
+	hash_sig_t *sig_bucket;
+	uint8_t *key_bucket;
+	uint32_t bucket_index;
+	int32_t pos;
+	int slot;
+
+	if (h->flags & HASH_F_RESIZE)
+		return resize_add_key(h, key, sig, data, update);
+	if (h->flags & HASH_F_CUCKOO)
+		return cuckoo_add_key(h, key, sig, data, update);
+
+	/* Check if key is already present in the hash */
+	pos = bucket_lookup(h, key, sig);
+	if (pos >= 0) {
+		if (update) {
+			version_write_begin(h);
+			set_data(h, pos, data);
+			version_write_end(h);
+		}
+		return pos;
+	}
+
+	/* Check if any free slot within the bucket to add the new key */
+	bucket_index = sig & h->bucket_bitmask;
+	sig_bucket = get_sig_tbl_bucket(h, bucket_index);
+	key_bucket = get_key_tbl_bucket(h, bucket_index);
+	slot = find_first(NULL_SIGNATURE, sig_bucket, h->bucket_entries);
+
+	if (unlikely(slot < 0))
+		return -ENOSPC;
+
+	/* Add the new key to the bucket */
+	pos = bucket_index * h->bucket_entries + slot;
+	version_write_begin(h);
+	rte_memcpy(get_key_from_bucket(h, key_bucket, slot), key, h->key_len);
+	set_data(h, pos, data);
+	sig_bucket[slot] = sig;
+	version_write_end(h);
+	return pos;
+}
+
+static int32_t
+del_key_with_sig(const struct rte_hash *h, const void *key, hash_sig_t sig)
+{
+	hash_sig_t *sig_bucket;
+	int32_t pos;
+
+	if (h->flags & HASH_F_RESIZE)
+		return resize_del_key(h, key, sig);
+	if (h->flags & HASH_F_CUCKOO)
+		return cuckoo_del_key(h, key, sig);
+
+	pos = bucket_lookup(h, key, sig);
+	if (pos < 0)
+		return pos;
+
+	sig_bucket = get_sig_tbl_bucket(h, sig & h->bucket_bitmask);
+	version_write_begin(h);
+	sig_bucket[pos % h->bucket_entries] = NULL_SIGNATURE;
+	version_write_end(h);
+	return pos;
+}
+
+/* Looks a key up, retrying if the table changed, and returns its data. */
+static inline int32_t
+lookup_data_with_sig(const struct rte_hash *h, const void *key,
+		     hash_sig_t sig, void **data)
+{
+	uint32_t version;
+	int32_t pos;
+
+	if (h->flags & HASH_F_RESIZE)
+		return resize_lookup(h, key, sig, data);
+
+	do {
+		version = version_read_begin(h);
+		pos = lookup_with_sig(h, key, sig);
+		if (pos >= 0 && data != NULL)
+			*data = *get_data_from_position(h, pos);
+	} while (version_read_retry(h, version));
+
+	return pos;
+}
+
+hash_sig_t
+rte_hash_hash(const struct rte_hash *h, const void *key)
+{
+	return h->hash_func(key, h->key_len, h->hash_func_init_val);
+}
+
+int32_t
+rte_hash_add_key(const struct rte_hash *h, const void *key)
+{
+	hash_sig_t sig;
+
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
+
+	sig = h->hash_func(key, h->key_len, h->hash_func_init_val) | h->sig_msb;
+	return add_key_with_sig(h, key, sig, NULL, 0);
+}
+
+int32_t
+rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
+			   hash_sig_t sig)
+{
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
+
+	return add_key_with_sig(h, key, sig | h->sig_msb, NULL, 0);
+}
+
+int32_t
+rte_hash_add_key_data(const struct rte_hash *h, const void *key, void *data)
+{
+	hash_sig_t sig;
+
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
+	if (!(h->flags & HASH_F_DATA))
+		return -EINVAL;
+
+	sig = h->hash_func(key, h->key_len, h->hash_func_init_val) | h->sig_msb;
+	return add_key_with_sig(h, key, sig, data, 1);
+}
+
+int32_t
+rte_hash_add_key_with_hash_data(const struct rte_hash *h, const void *key,
+				hash_sig_t sig, void *data)
+{
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
+	if (!(h->flags & HASH_F_DATA))
+		return -EINVAL;
+
+	return add_key_with_sig(h, key, sig | h->sig_msb, data, 1);
+}
+
+int32_t
+rte_hash_del_key(const struct rte_hash *h, const void *key)
+{
+	hash_sig_t sig;
+
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
+
+	sig = h->hash_func(key, h->key_len, h->hash_func_init_val) | h->sig_msb;
+	return del_key_with_sig(h, key, sig);
+}
+
+int32_t
+rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
+			   hash_sig_t sig)
+{
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
+
+	return del_key_with_sig(h, key, sig | h->sig_msb);
+}
+
+int32_t
+rte_hash_lookup(const struct rte_hash *h, const void *key)
+{
+	hash_sig_t sig;
+
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
+
+	sig = h->hash_func(key, h->key_len, h->hash_func_init_val) | h->sig_msb;
+	return lookup_data_with_sig(h, key, sig, NULL);
+}
+
+int32_t
+rte_hash_lookup_with_hash(const struct rte_hash *h, const void *key,
+			  hash_sig_t sig)
+{
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
+
+	return lookup_data_with_sig(h, key, sig | h->sig_msb, NULL);
+}
+
+int32_t
+rte_hash_lookup_data(const struct rte_hash *h, const void *key, void **data)
+{
+	hash_sig_t sig;
+
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL) || (data == NULL)),
+		       -EINVAL);
+	if (!(h->flags & HASH_F_DATA))
+		return -EINVAL;
+
+	sig = h->hash_func(key, h->key_len, h->hash_func_init_val) | h->sig_msb;
+	return lookup_data_with_sig(h, key, sig, data);
+}
+
+int32_t
+rte_hash_lookup_with_hash_data(const struct rte_hash *h, const void *key,
+			       hash_sig_t sig, void **data)
+{
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL) || (data == NULL)),
+		       -EINVAL);
+	if (!(h->flags & HASH_F_DATA))
+		return -EINVAL;
+
+	return lookup_data_with_sig(h, key, sig | h->sig_msb, data);
+}
+
+/*
+ * Looks up to RTE_HASH_LOOKUP_BULK_MAX keys up, in stages so that the memory
+ * accesses for all keys overlap: signatures are computed and buckets are
+ * prefetched for all keys, then all signatures of each bucket are compared
+ * at once and the matching keys are prefetched, and only then are keys
+ * compared. Signatures are computed unless given by the caller, and
+ * positions and data are returned if asked.
+ */
+static inline uint64_t
+lookup_bulk(const struct rte_hash *h, const void **keys,
+	    const hash_sig_t *key_sigs, uint32_t num_keys,
+	    int32_t *positions, void **data)
+{
+	hash_sig_t sigs[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t prim[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t sec[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t matches[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t cuckoo = h->flags & HASH_F_CUCKOO;
+	uint32_t i, bit, pos, version;
+	uint64_t hits;
+
+	if (h->flags & HASH_F_RESIZE)
+		return resize_lookup_bulk(h, keys, key_sigs, num_keys,
+					  positions, data);
+
+	/* Get the hash signatures and prefetch the buckets */
+	for (i = 0; i < num_keys; i++) {
+		if (key_sigs != NULL)
+			sigs[i] = key_sigs[i] | h->sig_msb;
+		else
+			sigs[i] = h->hash_func(keys[i], h->key_len,
+					h->hash_func_init_val) | h->sig_msb;
+		prim[i] = sigs[i] & h->bucket_bitmask;
+		sec[i] = prim[i];
+		rte_prefetch0((void *) get_sig_tbl_bucket(h, prim[i]));
+		if (cuckoo) {
+			sec[i] = get_alt_bucket_index(h, prim[i], sigs[i]);
+			rte_prefetch0((void *) get_sig_tbl_bucket(h, sec[i]));
+			rte_prefetch0((void *) get_idx_tbl_bucket(h, prim[i]));
+			rte_prefetch0((void *) get_idx_tbl_bucket(h, sec[i]));
+		}
+	}
+
+	do {
+		version = version_read_begin(h);
+
+		/* Compare signatures, and prefetch the first matching key */
+		for (i = 0; i < num_keys; i++) {
+			matches[i] = compare_signatures(h,
+					get_sig_tbl_bucket(h, prim[i]), sigs[i]);
+			if (cuckoo)
+				matches[i] |= compare_signatures(h,
+					get_sig_tbl_bucket(h, sec[i]),
+					sigs[i]) << RTE_HASH_BUCKET_ENTRIES_MAX;
+			if (matches[i] != 0) {
+				bit = __builtin_ctz(matches[i]);
+				pos = get_match_position(h, prim[i], sec[i],
+							 bit);
+				rte_prefetch0((void *) get_key_from_index(h,
+									  pos));
+			}
+		}
+
+		/* Compare keys */
+		hits = 0;
+		for (i = 0; i < num_keys; i++) {
+			if (positions != NULL)
+				positions[i] = -ENOENT;
+			if (data != NULL)
+				data[i] = NULL;
+			while (matches[i] != 0) {
+				bit = __builtin_ctz(matches[i]);
+				matches[i] &= matches[i] - 1;
+				pos = get_match_position(h, prim[i], sec[i],
+							 bit);
+				if (likely(memcmp(keys[i],
+						  get_key_from_index(h, pos),
+						  h->key_len) == 0)) {
+					hits |= 1ULL << i;
+					if (positions != NULL)
+						positions[i] = pos;
+					if (data != NULL)
+						data[i] =
+						*get_data_from_position(h, pos);
+					break;
+				}
+			}
+		}
+	} while (version_read_retry(h, version));
+
+	return hits;
+}
+
+/*
+ * Moves the keys of the next bucket of the previous table of a resizable
+ * hash to the current table. Lookups are retried if they run while a key is
+ * moved, as it could be missed in both tables.
+ */
+static int
+resize_migrate_bucket(const struct rte_hash *h)
+{
+	struct rte_hash_resize *r = h->resize;
+	struct rte_hash *old = r->old;
+	hash_sig_t *sig_bucket = get_sig_tbl_bucket(old, r->migrate_bucket);
+	uint32_t *idx_bucket = get_idx_tbl_bucket(old, r->migrate_bucket);
+	hash_sig_t sig;
+	uint32_t i;
+	int32_t ret;
+	void *key;
+
+	for (i = 0; i < old->bucket_entries; i++) {
+		sig = sig_bucket[i];
+		if (sig == NULL_SIGNATURE)
+			continue;
+		key = get_key_from_index(old, idx_bucket[i]);
+
+		version_write_begin(h);
+		ret = add_key_with_sig(r->cur, key, sig,
+				*get_data_from_position(old, idx_bucket[i]), 1);
+		if (ret >= 0)
+			cuckoo_del_key(old, key, sig);
+		version_write_end(h);
+
+		if (ret < 0)
+			return ret;
+	}
+
+	r->migrate_bucket++;
+	return 0;
+}
+
+/* Migrates up to nb_buckets buckets, and drops the previous table once done. */
+static int
+resize_migrate(const struct rte_hash *h, uint32_t nb_buckets)
+{
+	struct rte_hash_resize *r = h->resize;
+	int ret;
+
+	while (r->old != NULL && nb_buckets > 0) {
+		ret = resize_migrate_bucket(h);
+		if (ret < 0)
+			return ret;
+		nb_buckets--;
+
+		if (r->migrate_bucket == r->old->num_buckets) {
+			version_write_begin(h);
+			r->old = NULL;
+			version_write_end(h);
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Zeroes the next table of a resizable hash and sets its free slots a slice
+ * at a time, rather than in the add that grows the hash. Each slice is the
+ * part left divided by the adds left until the load of the current table
+ * reaches RESIZE_LOAD_NUM / RESIZE_LOAD_DEN, so that the next table is
+ * ready by then. Returns 1 once it is.
+ */
+static int
+resize_prepare(const struct rte_hash *h, uint32_t nb_adds)
+{
+	struct rte_hash_resize *r = h->resize;
+	struct rte_hash *t = r->next;
+	uint32_t zero_size = (uint8_t *)t->free_slots - t->sig_tbl;
+	uint32_t len, n, i;
+
+	if (nb_adds == 0)
+		nb_adds = 1;
+
+	len = (zero_size - r->next_zeroed + nb_adds - 1) / nb_adds;
+	if (len < RESIZE_PREPARE_MIN)
+		len = RESIZE_PREPARE_MIN;
+	if (len > zero_size - r->next_zeroed)
+		len = zero_size - r->next_zeroed;
+	memset(t->sig_tbl + r->next_zeroed, 0, len);
+	r->next_zeroed += len;
+
+	/* hand out low key indexes first */
+	n = (t->entries - r->next_slots + nb_adds - 1) / nb_adds;
+	for (i = r->next_slots; i < r->next_slots + n; i++)
+		t->free_slots->idx[i] = t->entries - 1 - i;
+	r->next_slots += n;
+
+	if (r->next_zeroed < zero_size || r->next_slots < t->entries)
+		return 0;
+	t->free_slots->count = t->entries;
+	return 1;
+}
+
+/*
+ * Allocates the next table of a resizable hash if needed. After a failure,
+ * the following adds do not all try again, they back off exponentially.
+ */
+static int
+resize_next_alloc(const struct rte_hash *h)
+{
+	struct rte_hash_resize *r = h->resize;
+
+	if (r->next != NULL)
+		return 0;
+	if (r->alloc_wait != 0) {
+		r->alloc_wait--;
+		return -ENOMEM;
+	}
+
+	r->next = resize_table_alloc(h);
+	if (r->next == NULL) {
+		if (r->alloc_backoff < RESIZE_ALLOC_BACKOFF_MIN)
+			r->alloc_backoff = RESIZE_ALLOC_BACKOFF_MIN;
+		else if (r->alloc_backoff < RESIZE_ALLOC_BACKOFF_MAX)
+			r->alloc_backoff *= 2;
+		r->alloc_wait = r->alloc_backoff;
+		return -ENOMEM;
+	}
+
+	r->next_zeroed = 0;
+	r->next_slots = 0;
+	r->alloc_backoff = 0;
+	return 0;
+}
+
+/*
+ * Replaces the current table of a resizable hash with the next one, twice
+ * as large. Its keys are then migrated a few buckets at a time by the next
+ * changes. A previous migration still running is only moved along by a
+ * few buckets, and the caller gets -ENOSPC.
+ */
+static int
+resize_grow(const struct rte_hash *h)
+{
+	struct rte_hash_resize *r = h->resize;
+	struct rte_hash *t;
+
+	if (r->old != NULL) {
+		resize_migrate(h, RESIZE_MIGRATE_BUCKETS);
+		return -ENOSPC;
+	}
+
+	if (resize_next_alloc(h) < 0)
+		return -ENOSPC;
+
+	/* the table only fills up earlier than expected on a bucket running
+	 * out of room, the rest of it is then prepared now */
+	resize_prepare(h, 1);
+
+	t = r->next;
+	RTE_LOG(DEBUG, HASH, "%s: growing to %u entries\n", h->name,
+		t->entries);
+
+	version_write_begin(h);
+	r->old = r->cur;
+	r->cur = t;
+	r->next = NULL;
+	r->migrate_bucket = 0;
+	version_write_end(h);
+	return 0;
+}
+
+/*
+ * Moves a resizable hash towards its next growth after an add: the next
+ * table is allocated once half of the current one is used, prepared by
+ * the following adds, and swapped in past RESIZE_LOAD_NUM / RESIZE_LOAD_DEN.
+ */
+static void
+resize_add_step(const struct rte_hash *h)
+{
+	struct rte_hash_resize *r = h->resize;
+	uint32_t grow_keys;
+
+	if (r->old != NULL) {
+		resize_migrate(h, RESIZE_MIGRATE_BUCKETS);
+		return;
+	}
+
+	if (r->nb_keys * RESIZE_PREPARE_DEN <=
+	    r->cur->entries * RESIZE_PREPARE_NUM)
+		return;
+
+	if (r->next == NULL) {
+		resize_next_alloc(h);
+		return;
+	}
+
+	grow_keys = r->cur->entries / RESIZE_LOAD_DEN * RESIZE_LOAD_NUM;
+	if (r->nb_keys < grow_keys)
+		resize_prepare(h, grow_keys - r->nb_keys);
+	else
+		resize_grow(h);
+}
+
+static int32_t
+resize_add_key(const struct rte_hash *h, const void *key, hash_sig_t sig,
+	       void *data, int update)
+{
+	struct rte_hash_resize *r = h->resize;
+	int32_t pos;
+
+	if (lookup_with_sig(r->cur, key, sig) >= 0)
+		pos = add_key_with_sig(r->cur, key, sig, data, update);
+
+	else if (r->old != NULL &&
+		 (pos = lookup_with_sig(r->old, key, sig)) >= 0) {
+		/* the key is moved now rather than updated in place */
+		if (!update)
+			data = *get_data_from_position(r->old, pos);
+		version_write_begin(h);
+		pos = add_key_with_sig(r->cur, key, sig, data, 1);
+		if (pos >= 0)
+			cuckoo_del_key(r->old, key, sig);
+		version_write_end(h);
+
+	} else {
+		pos = add_key_with_sig(r->cur, key, sig, data, update);
+		if (pos == -ENOSPC && resize_grow(h) == 0)
+			pos = add_key_with_sig(r->cur, key, sig, data, update);
+		if (pos >= 0)
+			r->nb_keys++;
+	}
+
+	resize_add_step(h);
+
+	return pos;
+}
+
+static int32_t
+resize_del_key(const struct rte_hash *h, const void *key, hash_sig_t sig)
+{
+	struct rte_hash_resize *r = h->resize;
+	int32_t pos;
+
+	pos = del_key_with_sig(r->cur, key, sig);
+	if (pos == -ENOENT && r->old != NULL)
+		pos = del_key_with_sig(r->old, key, sig);
+	if (pos >= 0)
+		r->nb_keys--;
+
+	if (r->old != NULL)
+		resize_migrate(h, RESIZE_MIGRATE_BUCKETS);
+
+	return pos;
+}
+
+/* Keys are looked up in the current table, then in the previous one. */
+static int32_t
+resize_lookup(const struct rte_hash *h, const void *key, hash_sig_t sig,
+	      void **data)
+{
+	struct rte_hash_resize *r = h->resize;
+	struct rte_hash *old;
+	uint32_t version;
+	int32_t pos;
+
+	do {
+		version = version_read_begin(h);
+		old = r->old;
+		pos = lookup_data_with_sig(r->cur, key, sig, data);
+		if (pos < 0 && old != NULL)
+			pos = lookup_data_with_sig(old, key, sig, data);
+	} while (version_read_retry(h, version));
+
+	return pos;
+}
+
+static uint64_t
+resize_lookup_bulk(const struct rte_hash *h, const void **keys,
+		   const hash_sig_t *key_sigs, uint32_t num_keys,
+		   int32_t *positions, void **data)
+{
+	struct rte_hash_resize *r = h->resize;
+	hash_sig_t sigs[RTE_HASH_LOOKUP_BULK_MAX];
+	const void *miss_keys[RTE_HASH_LOOKUP_BULK_MAX];
+	hash_sig_t miss_sigs[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t miss_idx[RTE_HASH_LOOKUP_BULK_MAX];
+	int32_t miss_pos[RTE_HASH_LOOKUP_BULK_MAX];
+	void *miss_data[RTE_HASH_LOOKUP_BULK_MAX];
+	uint64_t hits, miss_hits, all_hits;
+	uint32_t i, nb_miss, version;
+	struct rte_hash *old;
+
+	for (i = 0; i < num_keys; i++)
+		sigs[i] = (key_sigs != NULL) ? key_sigs[i] :
+			h->hash_func(keys[i], h->key_len,
+				     h->hash_func_init_val);
+	all_hits = (num_keys == 64) ? ~0ULL : (1ULL << num_keys) - 1;
+
+	do {
+		version = version_read_begin(h);
+		old = r->old;
+		hits = lookup_bulk(r->cur, keys, sigs, num_keys, positions,
+				   data);
+		if (old == NULL || hits == all_hits)
+			continue;
+
+		/* look the missing keys up in the previous table */
+		nb_miss = 0;
+		for (i = 0; i < num_keys; i++) {
+			if (hits & (1ULL << i))
+				continue;
+			miss_keys[nb_miss] = keys[i];
+			miss_sigs[nb_miss] = sigs[i];
+			miss_idx[nb_miss++] = i;
+		}
+		miss_hits = lookup_bulk(old, miss_keys, miss_sigs, nb_miss,
+					(positions != NULL) ? miss_pos : NULL,
+					(data != NULL) ? miss_data : NULL);
+		for (i = 0; i < nb_miss; i++) {
+			if (!(miss_hits & (1ULL << i)))
+				continue;
+			hits |= 1ULL << miss_idx[i];
+			if (positions != NULL)
+				positions[miss_idx[i]] = miss_pos[i];
+			if (data != NULL)
+				data[miss_idx[i]] = miss_data[i];
+		}
+	} while (version_read_retry(h, version));
+
+	return hits;
+}
+
+int
 rte_hash_lookup_multi(const struct rte_hash *h, const void **keys,
 		      uint32_t num_keys, int32_t *positions)
 {
-	uint32_t i, j, bucket_index;
-	hash_sig_t sigs[RTE_HASH_LOOKUP_MULTI_MAX];
-
 	RETURN_IF_TRUE(((h == NULL) || (keys == NULL) || (num_keys == 0) ||
 			(num_keys > RTE_HASH_LOOKUP_MULTI_MAX) ||
 			(positions == NULL)), -EINVAL);
 
-	/* Get the hash signature and bucket index */
-	for (i = 0; i < num_keys; i++) {
-		sigs[i] = h->hash_func(keys[i], h->key_len,
-				h->hash_func_init_val) | h->sig_msb;
-		bucket_index = sigs[i] & h->bucket_bitmask;
+	lookup_bulk(h, keys, NULL, num_keys, positions, NULL);
+	return 0;
+}
+
+int
+rte_hash_lookup_multi_data(const struct rte_hash *h, const void **keys,
+			   uint32_t num_keys, int32_t *positions, void **data)
+{
+	RETURN_IF_TRUE(((h == NULL) || (keys == NULL) || (num_keys == 0) ||
+			(num_keys > RTE_HASH_LOOKUP_MULTI_MAX) ||
+			(positions == NULL) || (data == NULL)), -EINVAL);
+	if (!(h->flags & HASH_F_DATA))
+		return -EINVAL;
+
+	lookup_bulk(h, keys, NULL, num_keys, positions, data);
+	return 0;
+}
 
-		/* Pre-fetch relevant buckets */
-		rte_prefetch1((void *) get_sig_tbl_bucket(h, bucket_index));
-		rte_prefetch1((void *) get_key_tbl_bucket(h, bucket_index));
+int
+rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
+		     uint32_t num_keys, int32_t *positions, uint64_t *hit_mask)
+{
+	uint64_t hits;
+
+	RETURN_IF_TRUE(((h == NULL) || (keys == NULL) || (num_keys == 0) ||
+			(num_keys > RTE_HASH_LOOKUP_BULK_MAX) ||
+			(hit_mask == NULL)), -EINVAL);
+
+	hits = lookup_bulk(h, keys, NULL, num_keys, positions, NULL);
+	*hit_mask = hits;
+	return __builtin_popcountll(hits);
+}
+
+int
+rte_hash_lookup_bulk_data(const struct rte_hash *h, const void **keys,
+			  uint32_t num_keys, uint64_t *hit_mask, void **data)
+{
+	uint64_t hits;
+
+	RETURN_IF_TRUE(((h == NULL) || (keys == NULL) || (num_keys == 0) ||
+			(num_keys > RTE_HASH_LOOKUP_BULK_MAX) ||
+			(hit_mask == NULL) || (data == NULL)), -EINVAL);
+	if (!(h->flags & HASH_F_DATA))
+		return -EINVAL;
+
+	hits = lookup_bulk(h, keys, NULL, num_keys, NULL, data);
+	*hit_mask = hits;
+	return __builtin_popcountll(hits);
+}
+
+int
+rte_hash_lookup_bulk_with_hash(const struct rte_hash *h, const void **keys,
+			       const hash_sig_t *sigs, uint32_t num_keys,
+			       int32_t *positions, uint64_t *hit_mask)
+{
+	uint64_t hits;
+
+	RETURN_IF_TRUE(((h == NULL) || (keys == NULL) || (sigs == NULL) ||
+			(num_keys == 0) ||
+			(num_keys > RTE_HASH_LOOKUP_BULK_MAX) ||
+			(hit_mask == NULL)), -EINVAL);
+
+	hits = lookup_bulk(h, keys, sigs, num_keys, positions, NULL);
+	*hit_mask = hits;
+	return __builtin_popcountll(hits);
+}
+
+int
+rte_hash_lookup_bulk_with_hash_data(const struct rte_hash *h,
+				    const void **keys, const hash_sig_t *sigs,
+				    uint32_t num_keys, uint64_t *hit_mask,
+				    void **data)
+{
+	uint64_t hits;
+
+	RETURN_IF_TRUE(((h == NULL) || (keys == NULL) || (sigs == NULL) ||
+			(num_keys == 0) ||
+			(num_keys > RTE_HASH_LOOKUP_BULK_MAX) ||
+			(hit_mask == NULL) || (data == NULL)), -EINVAL);
+	if (!(h->flags & HASH_F_DATA))
+		return -EINVAL;
+
+	hits = lookup_bulk(h, keys, sigs, num_keys, NULL, data);
+	*hit_mask = hits;
+	return __builtin_popcountll(hits);
+}
+
+/*
+ * Returns the next key of a table at or after a cursor, which counts the
+ * slots of all buckets. Deleting keys does not move other keys in either
+ * mode, so keys not yet returned stay after the cursor.
+ */
+static int32_t
+iterate(const struct rte_hash *h, const void **key, void **data,
+	hash_sig_t *sig, uint32_t *next)
+{
+	uint32_t nb_slots = h->num_buckets * h->bucket_entries;
+	uint32_t i, bkt, slot, pos;
+	hash_sig_t *sig_bucket;
+
+	for (i = *next; i < nb_slots; i++) {
+		bkt = i / h->bucket_entries;
+		slot = i % h->bucket_entries;
+		sig_bucket = get_sig_tbl_bucket(h, bkt);
+		if (sig_bucket[slot] == NULL_SIGNATURE)
+			continue;
+
+		if (h->flags & HASH_F_CUCKOO)
+			pos = get_idx_tbl_bucket(h, bkt)[slot];
+		else
+			pos = i;
+		*key = get_key_from_index(h, pos);
+		if (data != NULL)
+			*data = (h->flags & HASH_F_DATA) ?
+				*get_data_from_position(h, pos) : NULL;
+		if (sig != NULL)
+			*sig = sig_bucket[slot];
+		*next = i + 1;
+		return pos;
 	}
 
-	/* Check if key is already present in the hash */
-	for (i = 0; i < num_keys; i++) {
-		bucket_index = sigs[i] & h->bucket_bitmask;
-		hash_sig_t *sig_bucket = get_sig_tbl_bucket(h, bucket_index);
-		uint8_t *key_bucket = get_key_tbl_bucket(h, bucket_index);
+	*next = nb_slots;
+	return -ENOENT;
+}
 
-		positions[i] = -ENOENT;
+/*
+ * Resizable hashes are walked in the table being migrated, then in the
+ * current one, RESIZE_ITER_CUR telling which one the cursor is in. Keys
+ * only move from the first to the second, so none is missed, but the keys
+ * moved by changes made during the walk may be returned twice.
+ */
+static int32_t
+iterate_with_sig(const struct rte_hash *h, const void **key, void **data,
+		 hash_sig_t *sig, uint32_t *next)
+{
+	struct rte_hash_resize *r;
+	uint32_t cursor;
+	int32_t pos;
 
-		for (j = 0; j < h->bucket_entries; j++) {
-			if ((sigs[i] == sig_bucket[j]) &&
-			    likely(memcmp(keys[i],
-					  get_key_from_bucket(h, key_bucket, j),
-					  h->key_len) == 0)) {
-				positions[i] = bucket_index *
-					h->bucket_entries + j;
-				break;
-			}
+	if (!(h->flags & HASH_F_RESIZE))
+		return iterate(h, key, data, sig, next);
+
+	r = h->resize;
+	if (!(*next & RESIZE_ITER_CUR)) {
+		if (r->old != NULL) {
+			pos = iterate(r->old, key, data, sig, next);
+			if (pos >= 0)
+				return pos;
 		}
+		*next = RESIZE_ITER_CUR;
 	}
 
-	return 0;
+	cursor = *next & ~RESIZE_ITER_CUR;
+	pos = iterate(r->cur, key, data, sig, &cursor);
+	*next = cursor | RESIZE_ITER_CUR;
+	return pos;
+}
+
+int32_t
+rte_hash_iterate(const struct rte_hash *h, const void **key, void **data,
+		 uint32_t *next)
+{
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL) || (next == NULL)),
+		       -EINVAL);
+
+	return iterate_with_sig(h, key, data, NULL, next);
+}
+
+/* Returns the size of a serialized key record of a table. */
+static inline size_t
+serialize_record_size(uint32_t key_len, uint32_t flags)
+{
+	return sizeof(hash_sig_t) + key_len +
+		((flags & HASH_F_DATA) ? sizeof(uint64_t) : 0);
+}
+
+/*
+ * Returns the signature of a fixed probe key, which tells whether a table
+ * computes the same signatures as the one a buffer was serialized from.
+ */
+static hash_sig_t
+serialize_hash_check(const struct rte_hash *h)
+{
+	uint8_t probe[RTE_HASH_KEY_LENGTH_MAX];
+	uint32_t i;
+
+	for (i = 0; i < h->key_len; i++)
+		probe[i] = (uint8_t)(i * 0x9d + 0x5b);
+	return h->hash_func(probe, h->key_len, h->hash_func_init_val);
+}
+
+size_t
+rte_hash_serialize_size(const struct rte_hash *h)
+{
+	const void *key;
+	uint32_t next = 0, nb_keys = 0;
+
+	if (h == NULL)
+		return 0;
+
+	while (iterate_with_sig(h, &key, NULL, NULL, &next) >= 0)
+		nb_keys++;
+
+	return sizeof(struct rte_hash_serialize_hdr) +
+		nb_keys * serialize_record_size(h->key_len, h->flags);
+}
+
+ssize_t
+rte_hash_serialize(const struct rte_hash *h, void *buf, size_t size)
+{
+	struct rte_hash_serialize_hdr hdr;
+	uint8_t *rec = (uint8_t *)buf + sizeof(hdr);
+	uint8_t *end = (uint8_t *)buf + size;
+	size_t rec_size;
+	const void *key;
+	void *data;
+	uint64_t data_val;
+	hash_sig_t sig;
+	uint32_t next = 0;
+
+	RETURN_IF_TRUE(((h == NULL) || (buf == NULL)), -EINVAL);
+	if (size < sizeof(hdr))
+		return -ENOSPC;
+
+	rec_size = serialize_record_size(h->key_len, h->flags);
+	hdr.magic = RTE_HASH_SERIALIZE_MAGIC;
+	hdr.key_len = h->key_len;
+	hdr.flags = h->flags & HASH_F_DATA;
+	hdr.hash_func_init_val = h->hash_func_init_val;
+	hdr.hash_func_check = serialize_hash_check(h);
+	hdr.nb_keys = 0;
+
+	while (iterate_with_sig(h, &key, &data, &sig, &next) >= 0) {
+		if ((size_t)(end - rec) < rec_size)
+			return -ENOSPC;
+		memcpy(rec, &sig, sizeof(sig));
+		memcpy(rec + sizeof(sig), key, h->key_len);
+		if (h->flags & HASH_F_DATA) {
+			data_val = (uintptr_t)data;
+			memcpy(rec + sizeof(sig) + h->key_len, &data_val,
+			       sizeof(data_val));
+		}
+		rec += rec_size;
+		hdr.nb_keys++;
+	}
+
+	memcpy(buf, &hdr, sizeof(hdr));
+	return rec - (uint8_t *)buf;
+}
+
+int
+rte_hash_deserialize(const struct rte_hash *h, const void *buf, size_t size)
+{
+	struct rte_hash_serialize_hdr hdr;
+	const uint8_t *rec = (const uint8_t *)buf + sizeof(hdr);
+	size_t rec_size;
+	uint64_t data_val = 0;
+	hash_sig_t sig;
+	uint32_t i;
+	int32_t ret;
+	int same_sigs, with_data;
+
+	RETURN_IF_TRUE(((h == NULL) || (buf == NULL)), -EINVAL);
+	if (size < sizeof(hdr))
+		return -EINVAL;
+
+	memcpy(&hdr, buf, sizeof(hdr));
+	if ((hdr.magic != RTE_HASH_SERIALIZE_MAGIC) ||
+	    (hdr.key_len != h->key_len))
+		return -EINVAL;
+	rec_size = serialize_record_size(hdr.key_len, hdr.flags);
+	if ((size - sizeof(hdr)) / rec_size < hdr.nb_keys)
+		return -EINVAL;
+
+	same_sigs = (hdr.hash_func_init_val == h->hash_func_init_val) &&
+		(hdr.hash_func_check == serialize_hash_check(h));
+	with_data = (hdr.flags & HASH_F_DATA) && (h->flags & HASH_F_DATA);
+
+	for (i = 0; i < hdr.nb_keys; i++) {
+		if (same_sigs)
+			memcpy(&sig, rec, sizeof(sig));
+		else
+			sig = h->hash_func(rec + sizeof(sig), h->key_len,
+					   h->hash_func_init_val);
+		if (with_data)
+			memcpy(&data_val, rec + sizeof(sig) + h->key_len,
+			       sizeof(data_val));
+
+		ret = add_key_with_sig(h, rec + sizeof(sig), sig | h->sig_msb,
+				       (void *)(uintptr_t)data_val, with_data);
+		if (ret < 0)
+			return ret;
+		rec += rec_size;
+	}
+
+	return (int)hdr.nb_keys;
 }
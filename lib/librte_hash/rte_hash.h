@@ -43,7 +43,9 @@
  */
 
 #include <stdint.h>
+#include <stddef.h>
 #include <sys/queue.h>
+#include <sys/types.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -61,9 +63,38 @@ extern "C" {
 /** Max number of keys that can be searched for using rte_hash_lookup_multi. */
 #define RTE_HASH_LOOKUP_MULTI_MAX		16
 
+/** Max number of keys that can be searched for using rte_hash_lookup_bulk. */
+#define RTE_HASH_LOOKUP_BULK_MAX		64
+
 /** Max number of characters in hash name.*/
 #define RTE_HASH_NAMESIZE			32
 
+/**
+ * Use a cuckoo hash table: each key has two candidate buckets, and existing
+ * keys are displaced to their alternative bucket to make room when both are
+ * full. Positions returned by the table stay the same while keys are moved.
+ */
+#define HASH_F_CUCKOO		0x0001
+
+/**
+ * Store a user data pointer with each key, in the same key slot, so that
+ * rte_hash_lookup_data() finds it in the cache line used to compare the key.
+ */
+#define HASH_F_DATA		0x0002
+
+/**
+ * Grow the table when more than 3/4 of its entries are used. A table twice
+ * as large is allocated once half of them are used, and zeroed a slice at
+ * a time by the following adds. Keys are then moved to it a few buckets at
+ * a time by the following adds and deletes. Until they all are, lookups
+ * missing in the new table also check the previous one, so a phase of
+ * lookups only right after growth pays for both. An add finding no room
+ * while keys are being moved fails with -ENOSPC rather than moving all of
+ * them. This flag requires HASH_F_CUCKOO and HASH_F_DATA, as keys change
+ * position when they are moved, and entries is the initial size.
+ */
+#define HASH_F_RESIZE		0x0004
+
 /** Signature of key that is stored internally. */
 typedef uint32_t hash_sig_t;
 
@@ -83,6 +114,15 @@ struct rte_hash_parameters {
 	rte_hash_function hash_func;	/**< Function used to calculate hash. */
 	uint32_t hash_func_init_val;	/**< Init value used by hash_func. */
 	int socket_id;			/**< NUMA Socket ID for memory. */
+	uint32_t flags;			/**< HASH_F_* flags, 0 by default. */
+};
+
+struct rte_hash_resize;
+
+/** Stack of free key indexes used by cuckoo hash tables. */
+struct rte_hash_free_slots {
+	uint32_t count;			/**< Number of free key indexes. */
+	uint32_t idx[0];		/**< Free key indexes. */
 };
 
 /** A hash table structure. */
@@ -107,6 +147,20 @@ struct rte_hash {
 	uint32_t key_tbl_key_size;	/**< Keys may be padded for alignment
 					   reasons, and this is the key size
 					   used	by key_tbl. */
+	uint32_t key_tbl_data_offset;	/**< Offset of the data in a key_tbl
+					   slot, with HASH_F_DATA. */
+	uint32_t flags;			/**< HASH_F_* flags of the table. */
+	uint8_t *idx_tbl;	/**< Cuckoo mode only: flat array of key index
+				   buckets, laid out like sig_tbl. In this mode
+				   key_tbl is indexed by key index. */
+	struct rte_hash_free_slots *free_slots;	/**< Cuckoo mode only: key
+						   indexes not in use. */
+	struct rte_hash_resize *resize;	/**< HASH_F_RESIZE only: tables
+					   holding the keys. */
+	volatile uint32_t *version;	/**< Incremented before and after each
+					   change, odd while a change is in
+					   progress. Lookups are retried when
+					   it changes under them. */
 };
 
 /**
@@ -114,6 +168,12 @@ struct rte_hash {
  * the hash table is allocated in a memzone on a specific NUMA socket ID,
  * otherwise it is allocated in the heap.
  *
+ * By default, a key can only be stored in the bucket selected by its hash
+ * signature, and adding a key fails once that bucket is full. With the
+ * HASH_F_CUCKOO flag, a key can be stored in either of two buckets and keys
+ * already in the table are moved between their two buckets to make room,
+ * which allows the table to be filled to well over 90% of its entries.
+ *
  * @param params
  *   Parameters used to create and initialise the hash table.
  * @return
@@ -157,7 +217,9 @@ rte_hash_free(struct rte_hash *h);
 
 /**
  * Add a key to an existing hash table. This operation is not multi-thread safe
- * and should only be called from one thread.
+ * and should only be called from one thread, but lookups can run concurrently
+ * on other threads. In cuckoo mode, this may move
+ * other keys to their alternative bucket, but their positions do not change.
  *
  * @param h
  *   Hash table to add the key to.
@@ -172,9 +234,33 @@ rte_hash_free(struct rte_hash *h);
 int32_t
 rte_hash_add_key(const struct rte_hash *h, const void *key);
 
+/**
+ * Add a key and its data to an existing hash table, or update the data of a
+ * key already present. The table must have been created with HASH_F_DATA.
+ * This operation is not multi-thread safe and should only be called from one
+ * thread, but lookups can run concurrently on other threads.
+ *
+ * Keys added with rte_hash_add_key() to such a table have NULL data.
+ *
+ * @param h
+ *   Hash table to add the key to.
+ * @param key
+ *   Key to add to the hash table.
+ * @param data
+ *   Data to store with the key.
+ * @return
+ *   - -EINVAL if the parameters are invalid.
+ *   - -ENOSPC if there is no space in the hash for this key.
+ *   - A positive value that can be used by the caller as an offset into an
+ *     array of user data. This value is unique for this key.
+ */
+int32_t
+rte_hash_add_key_data(const struct rte_hash *h, const void *key, void *data);
+
 /**
  * Remove a key from an existing hash table. This operation is not multi-thread
- * safe and should only be called from one thread.
+ * safe and should only be called from one thread, but lookups can run
+ * concurrently on other threads.
  *
  * @param h
  *   Hash table to remove the key from.
@@ -191,7 +277,11 @@ int32_t
 rte_hash_del_key(const struct rte_hash *h, const void *key);
 
 /**
- * Find a key in the hash table. This operation is multi-thread safe.
+ * Find a key in the hash table. This operation is multi-thread safe, also
+ * while another thread adds or removes keys. It uses no lock or atomic
+ * operation: the lookup is done again if the table version changed while it
+ * ran, so a key present during the whole lookup is always found, even if it
+ * is being moved to another bucket.
  *
  * @param h
  *   Hash table to look in.
@@ -208,7 +298,27 @@ int32_t
 rte_hash_lookup(const struct rte_hash *h, const void *key);
 
 /**
- * Find multiple keys in the hash table. This operation is multi-thread safe.
+ * Find a key and its data in a hash table created with HASH_F_DATA. This
+ * operation is multi-thread safe, see rte_hash_lookup().
+ *
+ * @param h
+ *   Hash table to look in.
+ * @param key
+ *   Key to find.
+ * @param data
+ *   Output containing the data stored with the key, if found.
+ * @return
+ *   - -EINVAL if the parameters are invalid.
+ *   - -ENOENT if the key is not found.
+ *   - A positive value that can be used by the caller as an offset into an
+ *     array of user data, as returned when the key was added.
+ */
+int32_t
+rte_hash_lookup_data(const struct rte_hash *h, const void *key, void **data);
+
+/**
+ * Find multiple keys in the hash table. This operation is multi-thread safe,
+ * also while another thread adds or removes keys, see rte_hash_lookup().
  *
  * @param h
  *   Hash table to look in.
@@ -229,6 +339,344 @@ int
 rte_hash_lookup_multi(const struct rte_hash *h, const void **keys,
 		      uint32_t num_keys, int32_t *positions);
 
+/**
+ * Find multiple keys and their data in a hash table created with HASH_F_DATA.
+ * This operation is multi-thread safe, see rte_hash_lookup().
+ *
+ * @param h
+ *   Hash table to look in.
+ * @param keys
+ *   A pointer to a list of keys to look for.
+ * @param num_keys
+ *   How many keys are in the keys list (less than RTE_HASH_LOOKUP_MULTI_MAX).
+ * @param positions
+ *   Output containing the position of each key, or -ENOENT if it was not
+ *   found, as for rte_hash_lookup_multi().
+ * @param data
+ *   Output containing the data stored with each key, or NULL if it was not
+ *   found.
+ * @return
+ *   -EINVAL if there's an error, otherwise 0.
+ */
+int
+rte_hash_lookup_multi_data(const struct rte_hash *h, const void **keys,
+			   uint32_t num_keys, int32_t *positions, void **data);
+
+/**
+ * Find a burst of keys in the hash table. This operation is multi-thread
+ * safe, see rte_hash_lookup(). The lookups of all keys are done in stages,
+ * so that the memory accesses for different keys overlap, and all the
+ * signatures of a bucket are compared at once.
+ *
+ * @param h
+ *   Hash table to look in.
+ * @param keys
+ *   A pointer to a list of keys to look for.
+ * @param num_keys
+ *   How many keys are in the keys list (up to RTE_HASH_LOOKUP_BULK_MAX).
+ * @param positions
+ *   Output containing the position of each key, or -ENOENT if it was not
+ *   found, as for rte_hash_lookup_multi(). May be NULL if only the hit mask
+ *   is needed.
+ * @param hit_mask
+ *   Output containing a bitmask of the keys that were found, bit i being set
+ *   if keys[i] was found.
+ * @return
+ *   -EINVAL if there's an error, otherwise the number of keys found.
+ */
+int
+rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
+		     uint32_t num_keys, int32_t *positions, uint64_t *hit_mask);
+
+/**
+ * Find a burst of keys and their data in a hash table created with
+ * HASH_F_DATA. This operation is multi-thread safe, see rte_hash_lookup().
+ *
+ * @param h
+ *   Hash table to look in.
+ * @param keys
+ *   A pointer to a list of keys to look for.
+ * @param num_keys
+ *   How many keys are in the keys list (up to RTE_HASH_LOOKUP_BULK_MAX).
+ * @param hit_mask
+ *   Output containing a bitmask of the keys that were found, bit i being set
+ *   if keys[i] was found.
+ * @param data
+ *   Output containing the data stored with each key, or NULL if it was not
+ *   found.
+ * @return
+ *   -EINVAL if there's an error, otherwise the number of keys found.
+ */
+int
+rte_hash_lookup_bulk_data(const struct rte_hash *h, const void **keys,
+			  uint32_t num_keys, uint64_t *hit_mask, void **data);
+
+/**
+ * Calculate the hash signature of a key, as done internally by the functions
+ * not taking a signature. Its value can be passed to the *_with_hash
+ * functions, which skip the hash calculation.
+ *
+ * The *_with_hash functions accept any signature, such as the RSS hash
+ * computed by the NIC. The same signature must then be used for all
+ * operations on a key, and the functions calculating it can only be used on
+ * a key if its signature is the one returned by rte_hash_hash().
+ *
+ * @param h
+ *   Hash table the key is used with.
+ * @param key
+ *   Key to calculate the signature of.
+ * @return
+ *   The hash signature of the key.
+ */
+hash_sig_t
+rte_hash_hash(const struct rte_hash *h, const void *key);
+
+/**
+ * Add a key to an existing hash table, using a precomputed signature. See
+ * rte_hash_hash() and rte_hash_add_key().
+ *
+ * @param h
+ *   Hash table to add the key to.
+ * @param key
+ *   Key to add to the hash table.
+ * @param sig
+ *   Hash signature of the key.
+ * @return
+ *   Same as rte_hash_add_key().
+ */
+int32_t
+rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
+			   hash_sig_t sig);
+
+/**
+ * Add a key and its data to an existing hash table, using a precomputed
+ * signature. See rte_hash_hash() and rte_hash_add_key_data().
+ *
+ * @param h
+ *   Hash table to add the key to.
+ * @param key
+ *   Key to add to the hash table.
+ * @param sig
+ *   Hash signature of the key.
+ * @param data
+ *   Data to store with the key.
+ * @return
+ *   Same as rte_hash_add_key_data().
+ */
+int32_t
+rte_hash_add_key_with_hash_data(const struct rte_hash *h, const void *key,
+				hash_sig_t sig, void *data);
+
+/**
+ * Remove a key from an existing hash table, using a precomputed signature.
+ * See rte_hash_hash() and rte_hash_del_key().
+ *
+ * @param h
+ *   Hash table to remove the key from.
+ * @param key
+ *   Key to remove from the hash table.
+ * @param sig
+ *   Hash signature of the key.
+ * @return
+ *   Same as rte_hash_del_key().
+ */
+int32_t
+rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
+			   hash_sig_t sig);
+
+/**
+ * Find a key in the hash table, using a precomputed signature. See
+ * rte_hash_hash() and rte_hash_lookup().
+ *
+ * @param h
+ *   Hash table to look in.
+ * @param key
+ *   Key to find.
+ * @param sig
+ *   Hash signature of the key.
+ * @return
+ *   Same as rte_hash_lookup().
+ */
+int32_t
+rte_hash_lookup_with_hash(const struct rte_hash *h, const void *key,
+			  hash_sig_t sig);
+
+/**
+ * Find a key and its data in the hash table, using a precomputed signature.
+ * See rte_hash_hash() and rte_hash_lookup_data().
+ *
+ * @param h
+ *   Hash table to look in.
+ * @param key
+ *   Key to find.
+ * @param sig
+ *   Hash signature of the key.
+ * @param data
+ *   Output containing the data stored with the key, if found.
+ * @return
+ *   Same as rte_hash_lookup_data().
+ */
+int32_t
+rte_hash_lookup_with_hash_data(const struct rte_hash *h, const void *key,
+			       hash_sig_t sig, void **data);
+
+/**
+ * Find a burst of keys in the hash table, using precomputed signatures. See
+ * rte_hash_hash() and rte_hash_lookup_bulk().
+ *
+ * @param h
+ *   Hash table to look in.
+ * @param keys
+ *   A pointer to a list of keys to look for.
+ * @param sigs
+ *   A pointer to the list of hash signatures of the keys.
+ * @param num_keys
+ *   How many keys are in the keys list (up to RTE_HASH_LOOKUP_BULK_MAX).
+ * @param positions
+ *   Output containing the position of each key, or -ENOENT if it was not
+ *   found. May be NULL if only the hit mask is needed.
+ * @param hit_mask
+ *   Output containing a bitmask of the keys that were found.
+ * @return
+ *   -EINVAL if there's an error, otherwise the number of keys found.
+ */
+int
+rte_hash_lookup_bulk_with_hash(const struct rte_hash *h, const void **keys,
+			       const hash_sig_t *sigs, uint32_t num_keys,
+			       int32_t *positions, uint64_t *hit_mask);
+
+/**
+ * Find a burst of keys and their data in the hash table, using precomputed
+ * signatures. See rte_hash_hash() and rte_hash_lookup_bulk_data().
+ *
+ * @param h
+ *   Hash table to look in.
+ * @param keys
+ *   A pointer to a list of keys to look for.
+ * @param sigs
+ *   A pointer to the list of hash signatures of the keys.
+ * @param num_keys
+ *   How many keys are in the keys list (up to RTE_HASH_LOOKUP_BULK_MAX).
+ * @param hit_mask
+ *   Output containing a bitmask of the keys that were found.
+ * @param data
+ *   Output containing the data stored with each key, or NULL if it was not
+ *   found.
+ * @return
+ *   -EINVAL if there's an error, otherwise the number of keys found.
+ */
+int
+rte_hash_lookup_bulk_with_hash_data(const struct rte_hash *h,
+				    const void **keys, const hash_sig_t *sigs,
+				    uint32_t num_keys, uint64_t *hit_mask,
+				    void **data);
+
+/**
+ * Get the next key of a hash table, to walk all keys, e.g. to age flows a
+ * slice at a time. The cursor starts at 0 and is updated by each call.
+ * Deleting the returned key, or keys already returned, does not disturb the
+ * walk, but keys added during the walk may or may not be returned, and may
+ * be returned twice in cuckoo mode. With HASH_F_RESIZE, keys moved to a new
+ * table by the changes made during the walk may also be returned twice,
+ * and a growth during the walk may make it miss keys. The walk does not
+ * change the table. This operation is not multi-thread safe and should
+ * only be called from the thread changing the table.
+ *
+ * @param h
+ *   Hash table to walk.
+ * @param key
+ *   Output containing a pointer to the key, valid until it is deleted.
+ * @param data
+ *   Output containing the data stored with the key, or NULL if the table
+ *   was not created with HASH_F_DATA. May be NULL if not needed.
+ * @param next
+ *   Cursor of the walk, 0 to start from the first key.
+ * @return
+ *   - -EINVAL if the parameters are invalid.
+ *   - -ENOENT if there are no more keys.
+ *   - The position of the key, as returned by rte_hash_lookup().
+ */
+int32_t
+rte_hash_iterate(const struct rte_hash *h, const void **key, void **data,
+		 uint32_t *next);
+
+/** Value of the magic field of a serialized hash table. */
+#define RTE_HASH_SERIALIZE_MAGIC	0x48534832
+
+/**
+ * Header of the buffer written by rte_hash_serialize(). It is followed by
+ * nb_keys records, each made of the signature of a key, the key, and with
+ * HASH_F_DATA, the data stored with it as a 64-bit value. Records are
+ * packed, so fields may be unaligned.
+ */
+struct rte_hash_serialize_hdr {
+	uint32_t magic;			/**< RTE_HASH_SERIALIZE_MAGIC. */
+	uint32_t key_len;		/**< Length of the keys. */
+	uint32_t flags;			/**< HASH_F_DATA if records hold data. */
+	uint32_t hash_func_init_val;	/**< Init value of the hash function
+					   the signatures were computed with. */
+	uint32_t hash_func_check;	/**< Signature of a fixed probe key,
+					   telling hash functions apart. */
+	uint32_t nb_keys;		/**< Number of records. */
+};
+
+/**
+ * Get the size of the buffer needed to serialize a hash table. This
+ * operation is not multi-thread safe, see rte_hash_iterate().
+ *
+ * @param h
+ *   Hash table to serialize.
+ * @return
+ *   The size in bytes, or 0 if h is NULL.
+ */
+size_t
+rte_hash_serialize_size(const struct rte_hash *h);
+
+/**
+ * Write all keys of a hash table, and their data, to a buffer, e.g. to
+ * restore them after a restart with rte_hash_deserialize(). Data are
+ * written as is, so pointers are only meaningful if their target is also
+ * restored at the same address. This operation is not multi-thread safe,
+ * see rte_hash_iterate().
+ *
+ * @param h
+ *   Hash table to serialize.
+ * @param buf
+ *   Buffer to write to.
+ * @param size
+ *   Size of the buffer, see rte_hash_serialize_size().
+ * @return
+ *   - -EINVAL if the parameters are invalid.
+ *   - -ENOSPC if the buffer is too small.
+ *   - The number of bytes written.
+ */
+ssize_t
+rte_hash_serialize(const struct rte_hash *h, void *buf, size_t size);
+
+/**
+ * Add all keys of a buffer written by rte_hash_serialize() to a hash table,
+ * which must have the same key length. The stored signatures are reused if
+ * the table hashes a fixed probe key to the same signature as the table
+ * serialized, i.e. uses the same hash function and init value, so that keys
+ * are not hashed again. Otherwise keys are hashed. Data are only restored
+ * if both the buffer and the table have them. This operation is not
+ * multi-thread safe, see rte_hash_add_key().
+ *
+ * @param h
+ *   Hash table to add the keys to.
+ * @param buf
+ *   Buffer to read from.
+ * @param size
+ *   Size of the buffer.
+ * @return
+ *   - -EINVAL if the parameters are invalid or the buffer is malformed.
+ *   - -ENOSPC if there is no space in the hash for a key, in which case the
+ *     keys before it have been added.
+ *   - The number of keys added.
+ */
+int
+rte_hash_deserialize(const struct rte_hash *h, const void *buf, size_t size);
+
 #ifdef __cplusplus
 }
 #endif
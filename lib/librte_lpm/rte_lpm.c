@@ -199,7 +199,7 @@ rte_lpm_create(const char *name, int socket_id, int max_rules,
 	/* Allocate memory to store the LPM data structures. */
 	if (mem_location == RTE_LPM_MEMZONE) {
 		const struct rte_memzone *mz;
-		uint32_t mz_flags = 0;
+		uint32_t mz_flags = RTE_MEMZONE_LARGEST_PAGE;
 
 		mz = rte_memzone_reserve(mem_name, mem_size, socket_id,
 				mz_flags);
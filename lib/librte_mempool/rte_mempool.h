@@ -59,6 +59,8 @@
  * example, in linuxapp environment, a thread that is not created by
  * the EAL must not use mempools. This is due to the per-lcore cache
  * that won't work as rte_lcore_id() will not return a correct value.
+ * Such a thread must first get its own lcore id with
+ * rte_thread_register().
  */
 
 #include <stdlib.h>
@@ -100,11 +100,21 @@ static int  igb_get_rx_buffer_size(struct e1000_hw *hw);
 static void eth_igb_rar_set(struct rte_eth_dev *dev, struct ether_addr *mac_addr,
 		uint32_t index, uint32_t pool);
 static void eth_igb_rar_clear(struct rte_eth_dev *dev, uint32_t index);
+static void eth_igb_rxq_interrupt_setup(struct rte_eth_dev *dev);
+static int eth_igb_rx_queue_intr_enable(struct rte_eth_dev *dev,
+					uint16_t queue_id);
+static int eth_igb_rx_queue_intr_disable(struct rte_eth_dev *dev,
+					 uint16_t queue_id);
 
 #define IGB_FC_PAUSE_TIME 0x0680
 #define IGB_LINK_UPDATE_CHECK_TIMEOUT  90  /* 9s */
 #define IGB_LINK_UPDATE_CHECK_INTERVAL 100 /* ms */
 
+/* Number of RX queues that can get their own bit in EICR. */
+#define IGB_MAX_RX_QUEUE_INTR 16
+/* EITR value used with RX queue interrupts (~6000 interrupts/s). */
+#define IGB_RXQ_INTR_EITR 648
+
 static enum e1000_fc_mode igb_fc_setting = e1000_fc_full;
 
 /*
@@ -140,6 +150,8 @@ static struct eth_dev_ops eth_igb_ops = {
 	.flow_ctrl_set        = eth_igb_flow_ctrl_set,
 	.mac_addr_add         = eth_igb_rar_set,
 	.mac_addr_remove      = eth_igb_rar_clear,
+	.rx_queue_intr_enable  = eth_igb_rx_queue_intr_enable,
+	.rx_queue_intr_disable = eth_igb_rx_queue_intr_disable,
 };
 
 /**
@@ -524,6 +536,10 @@ eth_igb_start(struct rte_eth_dev *dev)
 
 	PMD_INIT_LOG(DEBUG, "<<");
 
+	/* map the RX queues onto the device interrupt */
+	if (dev->data->dev_conf.intr_conf.rxq != 0)
+		eth_igb_rxq_interrupt_setup(dev);
+
 	/* check if lsc interrupt feature is enabled */
 	if (dev->data->dev_conf.intr_conf.lsc != 0)
 		return eth_igb_interrupt_setup(dev);
@@ -1129,6 +1145,110 @@ eth_igb_interrupt_setup(struct rte_eth_dev *dev)
 	return 0;
 }
 
+/*
+ * RX queue interrupts need an IVAR per queue: the 82575 is not supported.
+ */
+static inline int
+igb_rx_queue_intr_supported(struct e1000_hw *hw)
+{
+	return (hw->mac.type == e1000_82576) || (hw->mac.type == e1000_82580) ||
+			(hw->mac.type == e1000_i350);
+}
+
+/*
+ * Route the cause of RX queue *queue_id* to bit *queue_id* of EICR.
+ */
+static void
+igb_set_rx_queue_ivar(struct e1000_hw *hw, uint16_t queue_id)
+{
+	uint32_t ivar, idx, shift;
+	uint32_t vector = queue_id | E1000_IVAR_VALID;
+
+	if (hw->mac.type == e1000_82576) {
+		idx = queue_id & 0x7;
+		shift = (queue_id & 0x8) << 1;
+	} else {
+		idx = queue_id >> 1;
+		shift = (queue_id & 0x1) << 4;
+	}
+	ivar = E1000_READ_REG_ARRAY(hw, E1000_IVAR0, idx);
+	ivar &= ~(0xFF << shift);
+	ivar |= (vector << shift);
+	E1000_WRITE_REG_ARRAY(hw, E1000_IVAR0, idx, ivar);
+}
+
+/**
+ * It maps the RX queues onto the device interrupt, leaving them all masked,
+ * and lowers the interrupt moderation set up for polling mode.
+ *
+ * @param dev
+ *  Pointer to struct rte_eth_dev.
+ */
+static void
+eth_igb_rxq_interrupt_setup(struct rte_eth_dev *dev)
+{
+	struct e1000_hw *hw =
+		E1000_DEV_PRIVATE_TO_HW(dev->data->dev_private);
+	uint16_t i;
+
+	if (!igb_rx_queue_intr_supported(hw))
+		return;
+
+	for (i = 0; i < dev->data->nb_rx_queues &&
+			i < IGB_MAX_RX_QUEUE_INTR; i++)
+		igb_set_rx_queue_ivar(hw, i);
+
+	E1000_WRITE_REG(hw, E1000_EITR(0), IGB_RXQ_INTR_EITR);
+	E1000_WRITE_REG(hw, E1000_EIMC, ~0);
+	E1000_WRITE_REG(hw, E1000_EICR, ~0);
+	E1000_WRITE_FLUSH(hw);
+}
+
+/*
+ * It unmasks the interrupt of one RX queue and re-enables the device
+ * interrupt, which is masked by igb_uio each time it fires.
+ */
+static int
+eth_igb_rx_queue_intr_enable(struct rte_eth_dev *dev, uint16_t queue_id)
+{
+	struct e1000_hw *hw =
+		E1000_DEV_PRIVATE_TO_HW(dev->data->dev_private);
+
+	if (!igb_rx_queue_intr_supported(hw))
+		return -ENOTSUP;
+	if (queue_id >= IGB_MAX_RX_QUEUE_INTR)
+		return -EINVAL;
+
+	E1000_WRITE_REG(hw, E1000_EIMS, 1 << queue_id);
+	E1000_WRITE_FLUSH(hw);
+	if (rte_intr_enable(&(dev->pci_dev->intr_handle)) < 0)
+		return -EIO;
+
+	return 0;
+}
+
+/*
+ * It masks the interrupt of one RX queue and acknowledges its cause, so
+ * that it does not fire again for packets already received.
+ */
+static int
+eth_igb_rx_queue_intr_disable(struct rte_eth_dev *dev, uint16_t queue_id)
+{
+	struct e1000_hw *hw =
+		E1000_DEV_PRIVATE_TO_HW(dev->data->dev_private);
+
+	if (!igb_rx_queue_intr_supported(hw))
+		return -ENOTSUP;
+	if (queue_id >= IGB_MAX_RX_QUEUE_INTR)
+		return -EINVAL;
+
+	E1000_WRITE_REG(hw, E1000_EIMC, 1 << queue_id);
+	E1000_WRITE_REG(hw, E1000_EICR, 1 << queue_id);
+	E1000_WRITE_FLUSH(hw);
+
+	return 0;
+}
+
 /*
  * It reads ICR and gets interrupt causes, check it and set a bit flag
  * to update link status.
@@ -47,21 +47,24 @@
 #define PMD_RX_LOG(level, fmt, args...) \
 	RTE_LOG(level, PMD, "%s(): " fmt "\n", __func__, ## args)
 #else
-#define PMD_RX_LOG(level, fmt, args...) do { } while(0)
+#define PMD_RX_LOG(level, fmt, args...) \
+	(void)RTE_LOG_DP(level, PMD, "%s(): " fmt "\n", __func__, ## args)
 #endif
 
 #ifdef RTE_LIBRTE_IGB_DEBUG_TX
 #define PMD_TX_LOG(level, fmt, args...) \
 	RTE_LOG(level, PMD, "%s(): " fmt "\n", __func__, ## args)
 #else
-#define PMD_TX_LOG(level, fmt, args...) do { } while(0)
+#define PMD_TX_LOG(level, fmt, args...) \
+	(void)RTE_LOG_DP(level, PMD, "%s(): " fmt "\n", __func__, ## args)
 #endif
 
 #ifdef RTE_LIBRTE_IGB_DEBUG_TX_FREE
 #define PMD_TX_FREE_LOG(level, fmt, args...) \
 	RTE_LOG(level, PMD, "%s(): " fmt "\n", __func__, ## args)
 #else
-#define PMD_TX_FREE_LOG(level, fmt, args...) do { } while(0)
+#define PMD_TX_FREE_LOG(level, fmt, args...) \
+	(void)RTE_LOG_DP(level, PMD, "%s(): " fmt "\n", __func__, ## args)
 #endif
 
 #ifdef RTE_LIBRTE_IGB_DEBUG_DRIVER
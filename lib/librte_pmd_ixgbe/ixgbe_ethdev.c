@@ -86,6 +86,9 @@
 #define IXGBE_LINK_DOWN_CHECK_TIMEOUT 4000 /* ms */
 #define IXGBE_LINK_UP_CHECK_TIMEOUT   1000 /* ms */
 
+/* Number of RX queues that can get their own bit in EICR. */
+#define IXGBE_MAX_RX_QUEUE_INTR 16
+
 static int eth_ixgbe_dev_init(struct eth_driver *eth_drv,
 		struct rte_eth_dev *eth_dev);
 static int  ixgbe_dev_configure(struct rte_eth_dev *dev, uint16_t nb_rx_q,
@@ -118,6 +121,11 @@ static int ixgbe_dev_interrupt_action(struct rte_eth_dev *dev);
 static void ixgbe_dev_interrupt_handler(struct rte_intr_handle *handle,
 							void *param);
 static void ixgbe_dev_interrupt_delayed_handler(void *param);
+static void ixgbe_dev_rxq_interrupt_setup(struct rte_eth_dev *dev);
+static int ixgbe_dev_rx_queue_intr_enable(struct rte_eth_dev *dev,
+					  uint16_t queue_id);
+static int ixgbe_dev_rx_queue_intr_disable(struct rte_eth_dev *dev,
+					   uint16_t queue_id);
 static void ixgbe_add_rar(struct rte_eth_dev *dev, struct ether_addr *mac_addr,
 				uint32_t index, uint32_t pool);
 static void ixgbe_remove_rar(struct rte_eth_dev *dev, uint32_t index);
@@ -199,6 +207,8 @@ static struct eth_dev_ops ixgbe_eth_dev_ops = {
 	.flow_ctrl_set        = ixgbe_flow_ctrl_set,
 	.mac_addr_add         = ixgbe_add_rar,
 	.mac_addr_remove      = ixgbe_remove_rar,
+	.rx_queue_intr_enable  = ixgbe_dev_rx_queue_intr_enable,
+	.rx_queue_intr_disable = ixgbe_dev_rx_queue_intr_disable,
 	.fdir_add_signature_filter    = ixgbe_fdir_add_signature_filter,
 	.fdir_update_signature_filter = ixgbe_fdir_update_signature_filter,
 	.fdir_remove_signature_filter = ixgbe_fdir_remove_signature_filter,
@@ -810,6 +820,10 @@ ixgbe_dev_start(struct rte_eth_dev *dev)
 			goto error;
 	}
 
+	/* map the RX queues onto the device interrupt */
+	if (dev->data->dev_conf.intr_conf.rxq != 0)
+		ixgbe_dev_rxq_interrupt_setup(dev);
+
 	/*
 	 * If VLAN filtering is enabled, set up VLAN tag offload and filtering
 	 * and restore VFTA.
@@ -1285,6 +1299,95 @@ ixgbe_dev_interrupt_setup(struct rte_eth_dev *dev)
 	return 0;
 }
 
+/*
+ * Route the cause of RX queue *queue_id* to bit *queue_id* of EICR. This is
+ * the same as ixgbe_set_ivar() in ixgbe/ixgbe.c, for RX queues only.
+ */
+static void
+ixgbe_set_rx_queue_ivar(struct ixgbe_hw *hw, uint16_t queue_id)
+{
+	uint32_t ivar, idx, shift;
+	uint32_t vector = queue_id | IXGBE_IVAR_ALLOC_VAL;
+
+	if (hw->mac.type == ixgbe_mac_82598EB) {
+		idx = (queue_id >> 2) & 0x1F;
+		shift = 8 * (queue_id & 0x3);
+	} else {
+		idx = queue_id >> 1;
+		shift = 16 * (queue_id & 0x1);
+	}
+	ivar = IXGBE_READ_REG(hw, IXGBE_IVAR(idx));
+	ivar &= ~(0xFF << shift);
+	ivar |= (vector << shift);
+	IXGBE_WRITE_REG(hw, IXGBE_IVAR(idx), ivar);
+}
+
+/**
+ * It maps the RX queues onto the device interrupt, leaving them all masked.
+ * Queue interrupts are then enabled one at a time by the application.
+ *
+ * @param dev
+ *  Pointer to struct rte_eth_dev.
+ */
+static void
+ixgbe_dev_rxq_interrupt_setup(struct rte_eth_dev *dev)
+{
+	struct ixgbe_hw *hw = IXGBE_DEV_PRIVATE_TO_HW(dev->data->dev_private);
+	uint16_t i;
+
+	for (i = 0; i < dev->data->nb_rx_queues &&
+			i < IXGBE_MAX_RX_QUEUE_INTR; i++)
+		ixgbe_set_rx_queue_ivar(hw, i);
+
+	IXGBE_WRITE_REG(hw, IXGBE_EIMC, IXGBE_EIMC_RTX_QUEUE);
+	IXGBE_WRITE_REG(hw, IXGBE_EICR, IXGBE_EICR_RTX_QUEUE);
+	IXGBE_WRITE_FLUSH(hw);
+}
+
+/*
+ * It unmasks the interrupt of one RX queue and re-enables the device
+ * interrupt, which is masked by igb_uio each time it fires.
+ */
+static int
+ixgbe_dev_rx_queue_intr_enable(struct rte_eth_dev *dev, uint16_t queue_id)
+{
+	struct ixgbe_hw *hw = IXGBE_DEV_PRIVATE_TO_HW(dev->data->dev_private);
+
+	if (queue_id >= IXGBE_MAX_RX_QUEUE_INTR)
+		return -EINVAL;
+
+	IXGBE_WRITE_REG(hw, IXGBE_EIMS, 1 << queue_id);
+	IXGBE_WRITE_FLUSH(hw);
+	if (rte_intr_enable(&(dev->pci_dev->intr_handle)) < 0)
+		return -EIO;
+
+	return 0;
+}
+
+/*
+ * It masks the interrupt of one RX queue and acknowledges its cause, so
+ * that it does not fire again for packets already received. The device
+ * interrupt, masked by igb_uio when it fired for this queue or another
+ * one, is then re-enabled: the lcores still sleeping on the other queues
+ * would not be woken up before their timeout otherwise.
+ */
+static int
+ixgbe_dev_rx_queue_intr_disable(struct rte_eth_dev *dev, uint16_t queue_id)
+{
+	struct ixgbe_hw *hw = IXGBE_DEV_PRIVATE_TO_HW(dev->data->dev_private);
+
+	if (queue_id >= IXGBE_MAX_RX_QUEUE_INTR)
+		return -EINVAL;
+
+	IXGBE_WRITE_REG(hw, IXGBE_EIMC, 1 << queue_id);
+	IXGBE_WRITE_REG(hw, IXGBE_EICR, 1 << queue_id);
+	IXGBE_WRITE_FLUSH(hw);
+	if (rte_intr_enable(&(dev->pci_dev->intr_handle)) < 0)
+		return -EIO;
+
+	return 0;
+}
+
 /*
  * It reads ICR and sets flag (IXGBE_EICR_LSC) for the link_update.
  *
@@ -52,32 +52,66 @@
 #include <rte_lcore.h>
 #include <rte_branch_prediction.h>
 #include <rte_spinlock.h>
+#include <rte_random.h>
+#include <rte_alarm.h>
+#include <rte_histogram.h>
 
 #include "rte_timer.h"
 
-LIST_HEAD(rte_timer_list, rte_timer);
-
 struct priv_timer {
-	struct rte_timer_list pending;  /**< list of pending timers */
-	struct rte_timer_list expired;  /**< list of expired timers */
-	struct rte_timer_list done;     /**< list of done timers */
+	/** dummy timer heading the skiplist of pending timers; its expire
+	 *  field is the expiration time of the first pending timer, or 0
+	 *  if there is no pending timer */
+	struct rte_timer pending_head;
 	rte_spinlock_t list_lock;       /**< lock to protect list access */
 
 	/** per-core variable that true if a timer was updated on this
 	 *  core since last reset of the variable */
 	int updated;
 
+	/** timer whose callback is running on this core, or NULL; the
+	 *  other expired timers are RUNNING too, but not reconfigurable
+	 *  until their callback ran, as they are linked in the run list */
+	struct rte_timer *running_tim;
+
+	/** number of levels used in the skiplist */
+	unsigned curr_skiplist_depth;
+
 	unsigned prev_lcore;              /**< used for lcore round robin */
 
 #ifdef RTE_LIBRTE_TIMER_DEBUG
 	/** per-lcore statistics */
 	struct rte_timer_debug_stats stats;
 #endif
+
+	/** per-lcore latency histograms */
+	struct rte_timer_latency_stats latency;
+
+	/** lock-free queue of the timers to add to or remove from the
+	 *  list of this lcore, posted by other lcores; it is on its own
+	 *  cache line as it is written by other lcores */
+	struct rte_timer * volatile req_head __rte_cache_aligned;
 } __rte_cache_aligned;
 
 /** per-lcore private info for timers */
 static struct priv_timer priv_timer[RTE_MAX_LCORE];
 
+/** time reference of the timers, never RTE_TIMER_SOURCE_AUTO */
+static enum rte_timer_source timer_source = RTE_TIMER_SOURCE_HPET;
+
+/* read the time source of the timers */
+static inline uint64_t
+timer_get_cycles(void)
+{
+	if (likely(timer_source == RTE_TIMER_SOURCE_TSC))
+		return rte_rdtsc();
+	return rte_get_hpet_cycles();
+}
+
+/* time after which the _sync functions process the requests of all
+ * lcores */
+#define TIMER_SYNC_DRAIN_MS 1
+
 /* when debug is enabled, store some statistics */
 #ifdef RTE_LIBRTE_TIMER_DEBUG
 #define __TIMER_STAT_ADD(name, n) do {				\
@@ -88,15 +122,6 @@ static struct priv_timer priv_timer[RTE_MAX_LCORE];
 #define __TIMER_STAT_ADD(name, n) do {} while(0)
 #endif
 
-/* this macro allow to modify var while browsing the list */
-#define LIST_FOREACH_SAFE(var, var2, head, field)		       \
-	for ((var) = ((head)->lh_first),			       \
-		     (var2) = ((var) ? ((var)->field.le_next) : NULL); \
-	     (var);						       \
-	     (var) = (var2),					       \
-		     (var2) = ((var) ? ((var)->field.le_next) : NULL))
-
-
 /* Init the timer library. */
 void
 rte_timer_subsystem_init(void)
@@ -104,12 +129,71 @@ rte_timer_subsystem_init(void)
 	unsigned lcore_id;
 
 	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id ++) {
-		LIST_INIT(&priv_timer[lcore_id].pending);
-		LIST_INIT(&priv_timer[lcore_id].expired);
-		LIST_INIT(&priv_timer[lcore_id].done);
+		memset(&priv_timer[lcore_id].pending_head, 0,
+		       sizeof(priv_timer[lcore_id].pending_head));
 		rte_spinlock_init(&priv_timer[lcore_id].list_lock);
+		priv_timer[lcore_id].curr_skiplist_depth = 0;
 		priv_timer[lcore_id].prev_lcore = lcore_id;
+		priv_timer[lcore_id].running_tim = NULL;
+		priv_timer[lcore_id].req_head = NULL;
 	}
+
+	rte_timer_set_source(RTE_TIMER_SOURCE_AUTO);
+}
+
+/* Select the time reference of the timers */
+int
+rte_timer_set_source(enum rte_timer_source source)
+{
+	unsigned lcore_id;
+
+	/* the expiration times of pending timers are in the unit of
+	 * the current source */
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		if (priv_timer[lcore_id].pending_head.expire != 0 ||
+		    priv_timer[lcore_id].req_head != NULL)
+			return -1;
+	}
+
+	switch (source) {
+	case RTE_TIMER_SOURCE_AUTO:
+		if (rte_tsc_is_invariant())
+			timer_source = RTE_TIMER_SOURCE_TSC;
+		else
+			timer_source = RTE_TIMER_SOURCE_HPET;
+		break;
+	case RTE_TIMER_SOURCE_TSC:
+	case RTE_TIMER_SOURCE_HPET:
+		timer_source = source;
+		break;
+	default:
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Get the time reference of the timers */
+enum rte_timer_source
+rte_timer_get_source(void)
+{
+	return timer_source;
+}
+
+/* Get the frequency of the time reference of the timers */
+uint64_t
+rte_timer_get_hz(void)
+{
+	if (timer_source == RTE_TIMER_SOURCE_TSC)
+		return rte_get_tsc_hz();
+	return rte_get_hpet_hz();
+}
+
+/* Read the time reference of the timers */
+uint64_t
+rte_timer_get_cycles(void)
+{
+	return timer_get_cycles();
 }
 
 /* Initialize the timer handle tim for use */
@@ -124,9 +208,9 @@ rte_timer_init(struct rte_timer *tim)
 }
 
 /*
- * if timer is pending or stopped (or running on the same core than
- * us), mark timer as configuring, and on success return the previous
- * status of the timer
+ * if timer is pending or stopped (or its callback is running on the
+ * same core than us), mark timer as configuring, and on success return
+ * the previous status of the timer
  */
 static int
 timer_set_config_state(struct rte_timer *tim,
@@ -137,15 +221,16 @@ timer_set_config_state(struct rte_timer *tim,
 	unsigned lcore_id;
 
 	lcore_id = rte_lcore_id();
-
 	/* wait that the timer is in correct status before update,
 	 * and mark it as beeing configured */
 	while (success == 0) {
 		prev_status.u32 = tim->status.u32;
 
-		/* timer is running on another core, exit */
+		/* timer is running on another core, or waits for its
+		 * callback to be run by this core, exit */
 		if (prev_status.state == RTE_TIMER_RUNNING &&
-		    (unsigned)prev_status.owner != lcore_id)
+		    ((unsigned)prev_status.owner != lcore_id ||
+		     tim != priv_timer[lcore_id].running_tim))
 			return -1;
 
 		/* timer is beeing configured on another core */
@@ -196,6 +281,70 @@ timer_set_running_state(struct rte_timer *tim)
 	return 0;
 }
 
+/*
+ * Return a random level for a new skiplist node: level n is used with
+ * a probability of 1/4^n. The level is never more than one above the
+ * current depth of the list.
+ */
+static unsigned
+timer_get_skiplist_level(unsigned curr_depth)
+{
+	uint32_t rand = (uint32_t)rte_rand() & ~1U;
+	unsigned level;
+
+	level = rand == 0 ? RTE_TIMER_SKIPLIST_DEPTH :
+		((unsigned)__builtin_ctz(rand) - 1) / 2;
+
+	if (level > curr_depth)
+		level = curr_depth;
+	if (level >= RTE_TIMER_SKIPLIST_DEPTH)
+		level = RTE_TIMER_SKIPLIST_DEPTH - 1;
+	return level;
+}
+
+/*
+ * For each level of the skiplist of tim_lcore, find the last timer
+ * that expires before time_val (or the list head).
+ */
+static void
+timer_get_prev_entries(uint64_t time_val, unsigned tim_lcore,
+		       struct rte_timer **prev)
+{
+	unsigned lvl = priv_timer[tim_lcore].curr_skiplist_depth;
+
+	prev[lvl] = &priv_timer[tim_lcore].pending_head;
+	while (lvl != 0) {
+		lvl--;
+		prev[lvl] = prev[lvl + 1];
+		while (prev[lvl]->sl_next[lvl] != NULL &&
+		       prev[lvl]->sl_next[lvl]->expire <= time_val)
+			prev[lvl] = prev[lvl]->sl_next[lvl];
+	}
+}
+
+/*
+ * For each level of the skiplist of tim_lcore, find the timer
+ * preceding tim. If tim is not in the list on a level, the entry of
+ * this level is a timer whose next one is not tim.
+ */
+static void
+timer_get_prev_entries_for_node(struct rte_timer *tim, unsigned tim_lcore,
+				struct rte_timer **prev)
+{
+	int i;
+
+	/* look for the timers expiring just before tim, then move
+	 * forward on each level among the timers with the same
+	 * expiration time */
+	timer_get_prev_entries(tim->expire - 1, tim_lcore, prev);
+	for (i = priv_timer[tim_lcore].curr_skiplist_depth - 1; i >= 0; i--) {
+		while (prev[i]->sl_next[i] != NULL &&
+		       prev[i]->sl_next[i] != tim &&
+		       prev[i]->sl_next[i]->expire <= tim->expire)
+			prev[i] = prev[i]->sl_next[i];
+	}
+}
+
 /*
  * add in list, lock if needed
  * timer must be in config state
@@ -204,43 +353,42 @@ timer_set_running_state(struct rte_timer *tim)
 static void
 timer_add(struct rte_timer *tim, unsigned tim_lcore, int local_is_locked)
 {
-	uint64_t cur_time = rte_get_hpet_cycles();
-	unsigned lcore_id = rte_lcore_id();
-	struct rte_timer *t, *t_prev;
+	struct priv_timer *priv = &priv_timer[tim_lcore];
+	struct rte_timer *prev[RTE_TIMER_SKIPLIST_DEPTH + 1];
+	unsigned lvl, tim_level;
 
 	/* if timer needs to be scheduled on another core, we need to
-	 * lock the list; if it is on local core, we need to lock if
-	 * we are not called from rte_timer_manage() */
-	if (tim_lcore != lcore_id || !local_is_locked)
-		rte_spinlock_lock(&priv_timer[tim_lcore].list_lock);
-
-	t = LIST_FIRST(&priv_timer[tim_lcore].pending);
-
-	/* list is empty or 'tim' will expire before 't' */
-	if (t == NULL || ((int64_t)(tim->expire - cur_time) <
-			  (int64_t)(t->expire - cur_time))) {
-		LIST_INSERT_HEAD(&priv_timer[tim_lcore].pending, tim, next);
+	 * lock the list unless we are processing its requests; if it is
+	 * on local core, we need to lock if we are not called from
+	 * rte_timer_manage() */
+	if (!local_is_locked)
+		rte_spinlock_lock(&priv->list_lock);
+
+	/* find where exactly this element goes in the list of elements
+	 * for each depth */
+	timer_get_prev_entries(tim->expire, tim_lcore, prev);
+
+	/* now assign it a new level and add at that level */
+	tim_level = timer_get_skiplist_level(priv->curr_skiplist_depth);
+	if (tim_level == priv->curr_skiplist_depth)
+		priv->curr_skiplist_depth++;
+
+	lvl = tim_level;
+	while (lvl > 0) {
+		tim->sl_next[lvl] = prev[lvl]->sl_next[lvl];
+		prev[lvl]->sl_next[lvl] = tim;
+		lvl--;
 	}
-	else {
-		t_prev = t;
-
-		/* find an element that will expire after 'tim' */
-		LIST_FOREACH(t, &priv_timer[tim_lcore].pending, next) {
-			if ((int64_t)(tim->expire - cur_time) <
-			    (int64_t)(t->expire - cur_time)) {
-				LIST_INSERT_BEFORE(t, tim, next);
-				break;
-			}
-			t_prev = t;
-		}
+	tim->sl_next[0] = prev[0]->sl_next[0];
+	prev[0]->sl_next[0] = tim;
 
-		/* not found, insert at the end of the list */
-		if (t == NULL)
-			LIST_INSERT_AFTER(t_prev, tim, next);
-	}
+	/* save the lowest list entry into the expire field of the dummy
+	 * hdr; note that a pending timer never has a null expiration
+	 * time in practice */
+	priv->pending_head.expire = priv->pending_head.sl_next[0]->expire;
 
-	if (tim_lcore != lcore_id || !local_is_locked)
-		rte_spinlock_unlock(&priv_timer[tim_lcore].list_lock);
+	if (!local_is_locked)
+		rte_spinlock_unlock(&priv->list_lock);
 }
 
 /*
@@ -251,18 +399,114 @@ timer_add(struct rte_timer *tim, unsigned tim_lcore, int local_is_locked)
 static void
 timer_del(struct rte_timer *tim, unsigned prev_owner, int local_is_locked)
 {
-	unsigned lcore_id = rte_lcore_id();
+	struct priv_timer *priv = &priv_timer[prev_owner];
+	struct rte_timer *prev[RTE_TIMER_SKIPLIST_DEPTH + 1];
+	int i;
 
 	/* if timer needs is pending another core, we need to lock the
-	 * list; if it is on local core, we need to lock if we are not
-	 * called from rte_timer_manage() */
-	if (prev_owner != lcore_id || !local_is_locked)
-		rte_spinlock_lock(&priv_timer[prev_owner].list_lock);
+	 * list unless we are processing its requests; if it is on local
+	 * core, we need to lock if we are not called from
+	 * rte_timer_manage() */
+	if (!local_is_locked)
+		rte_spinlock_lock(&priv->list_lock);
+
+	/* save the lowest list entry into the expire field of the dummy
+	 * hdr */
+	if (priv->pending_head.sl_next[0] == tim)
+		priv->pending_head.expire = (tim->sl_next[0] == NULL) ?
+			0 : tim->sl_next[0]->expire;
+
+	/* adjust pointers from previous entries to point past this one;
+	 * the timer may already have been removed from the list by
+	 * rte_timer_manage() if it expired, in this case nothing is
+	 * done */
+	timer_get_prev_entries_for_node(tim, prev_owner, prev);
+	for (i = priv->curr_skiplist_depth - 1; i >= 0; i--) {
+		if (prev[i]->sl_next[i] == tim)
+			prev[i]->sl_next[i] = tim->sl_next[i];
+	}
+
+	/* in case we deleted last entry at a level, adjust down max level */
+	for (i = priv->curr_skiplist_depth - 1; i >= 0; i--) {
+		if (priv->pending_head.sl_next[i] == NULL)
+			priv->curr_skiplist_depth--;
+		else
+			break;
+	}
+
+	if (!local_is_locked)
+		rte_spinlock_unlock(&priv->list_lock);
+}
 
-	LIST_REMOVE(tim, next);
+/*
+ * Post a timer in CONFIG state to the request queue of lcore_id. The
+ * parameters of the request are in the req_* fields of the timer.
+ */
+static void
+timer_post_request(struct rte_timer *tim, unsigned lcore_id)
+{
+	struct priv_timer *priv = &priv_timer[lcore_id];
+	struct rte_timer *head;
+
+	do {
+		head = priv->req_head;
+		tim->req_next = head;
+	} while (!__sync_bool_compare_and_swap(&priv->req_head, head, tim));
+}
+
+/*
+ * Process the requests posted to lcore_id by other lcores: the posted
+ * timers are removed from the list of lcore_id if they were pending,
+ * then added to it or posted to another lcore. This is normally done by
+ * lcore_id itself, but any lcore can do it as the list is locked.
+ */
+static void
+timer_process_requests(unsigned lcore_id)
+{
+	struct priv_timer *priv = &priv_timer[lcore_id];
+	struct rte_timer *tim, *next_tim, *rev = NULL;
+	union rte_timer_status status;
 
-	if (prev_owner != lcore_id || !local_is_locked)
-		rte_spinlock_unlock(&priv_timer[prev_owner].list_lock);
+	/* take the whole queue */
+	do {
+		tim = priv->req_head;
+		if (tim == NULL)
+			return;
+	} while (!__sync_bool_compare_and_swap(&priv->req_head, tim, NULL));
+
+	/* the queue is a stack, reverse it to process the requests in
+	 * order */
+	for ( ; tim != NULL; tim = next_tim) {
+		next_tim = tim->req_next;
+		tim->req_next = rev;
+		rev = tim;
+	}
+
+	rte_spinlock_lock(&priv->list_lock);
+	for (tim = rev; tim != NULL; tim = next_tim) {
+		next_tim = tim->req_next;
+
+		if (tim->req_unlink) {
+			tim->req_unlink = 0;
+			timer_del(tim, lcore_id, 1);
+		}
+
+		if ((unsigned)tim->req_lcore != lcore_id) {
+			timer_post_request(tim, tim->req_lcore);
+			continue;
+		}
+
+		tim->expire = tim->req_expire;
+		timer_add(tim, lcore_id, 1);
+		status.state = RTE_TIMER_PENDING;
+		status.owner = (int16_t)lcore_id;
+
+		/* as the timer is in CONFIG state, only us can modify
+		 * its state */
+		rte_wmb();
+		tim->status.u32 = status.u32;
+	}
+	rte_spinlock_unlock(&priv->list_lock);
 }
 
 /* Reset and start the timer associated with the timer handle (private func) */
@@ -290,22 +534,45 @@ __rte_timer_reset(struct rte_timer *tim, uint64_t expire,
 		return -1;
 
 	__TIMER_STAT_ADD(reset, 1);
-	priv_timer[lcore_id].updated = 1;
+	if (prev_status.state == RTE_TIMER_RUNNING)
+		priv_timer[lcore_id].updated = 1;
+
+	tim->period = period;
+	tim->f = fct;
+	tim->arg = arg;
+
+	/* the timer is in the list of another lcore, or must be added
+	 * to it: let this lcore do it */
+	if ((prev_status.state == RTE_TIMER_PENDING &&
+	     (unsigned)prev_status.owner != lcore_id) ||
+	    tim_lcore != lcore_id) {
+		tim->req_expire = expire;
+		tim->req_lcore = (int16_t)tim_lcore;
+		tim->req_unlink = 0;
+		if (prev_status.state != RTE_TIMER_PENDING)
+			__TIMER_STAT_ADD(pending, 1);
+		else if ((unsigned)prev_status.owner == lcore_id)
+			timer_del(tim, lcore_id, local_is_locked);
+		else
+			tim->req_unlink = 1;
+
+		if (tim->req_unlink)
+			timer_post_request(tim, prev_status.owner);
+		else
+			timer_post_request(tim, tim_lcore);
+		return 0;
+	}
 
 	/* remove it from list */
-	if (prev_status.state == RTE_TIMER_PENDING ||
-	    prev_status.state == RTE_TIMER_RUNNING) {
-		timer_del(tim, prev_status.owner, local_is_locked);
+	if (prev_status.state == RTE_TIMER_PENDING) {
+		timer_del(tim, lcore_id, local_is_locked);
 		__TIMER_STAT_ADD(pending, -1);
 	}
 
-	tim->period = period;
 	tim->expire = expire;
-	tim->f = fct;
-	tim->arg = arg;
 
 	__TIMER_STAT_ADD(pending, 1);
-	timer_add(tim, tim_lcore, local_is_locked);
+	timer_add(tim, lcore_id, local_is_locked);
 
 	/* update state: as we are in CONFIG state, only us can modify
 	 * the state so we don't need to use cmpset() here */
@@ -323,7 +590,7 @@ rte_timer_reset(struct rte_timer *tim, uint64_t ticks,
 		enum rte_timer_type type, unsigned tim_lcore,
 		rte_timer_cb_t fct, void *arg)
 {
-	uint64_t cur_time = rte_get_hpet_cycles();
+	uint64_t cur_time = timer_get_cycles();
 	uint64_t period;
 
 	if (unlikely((tim_lcore != (unsigned)LCORE_ID_ANY) &&
@@ -335,10 +602,35 @@ rte_timer_reset(struct rte_timer *tim, uint64_t ticks,
 	else
 		period = 0;
 
-	__rte_timer_reset(tim,  cur_time + ticks, period, tim_lcore,
-			  fct, arg, 0);
+	return __rte_timer_reset(tim,  cur_time + ticks, period, tim_lcore,
+				 fct, arg, 0);
+}
 
-	return 0;
+/*
+ * Called while a _sync function retries on a timer in CONFIG or RUNNING
+ * state. The timer may be posted to the local lcore, so process the
+ * local requests to avoid a deadlock. It may also be posted to an lcore
+ * that does not call rte_timer_manage() anymore: once the wait exceeds
+ * TIMER_SYNC_DRAIN_MS, process the requests of all lcores.
+ */
+static void
+timer_sync_retry(uint64_t start)
+{
+	unsigned lcore_id;
+
+	timer_process_requests(rte_lcore_id());
+
+	if (timer_get_cycles() - start <
+	    rte_timer_get_hz() * TIMER_SYNC_DRAIN_MS / 1000) {
+		rte_pause();
+		return;
+	}
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		if (priv_timer[lcore_id].req_head != NULL)
+			timer_process_requests(lcore_id);
+	}
+	rte_pause();
 }
 
 /* loop until rte_timer_reset() succeed */
@@ -347,8 +639,11 @@ rte_timer_reset_sync(struct rte_timer *tim, uint64_t ticks,
 		     enum rte_timer_type type, unsigned tim_lcore,
 		     rte_timer_cb_t fct, void *arg)
 {
+	uint64_t start = timer_get_cycles();
+
 	while (rte_timer_reset(tim, ticks, type, tim_lcore,
-			       fct, arg) != 0);
+			       fct, arg) != 0)
+		timer_sync_retry(start);
 }
 
 /* Stop the timer associated with the timer handle tim */
@@ -366,11 +661,12 @@ rte_timer_stop(struct rte_timer *tim)
 		return -1;
 
 	__TIMER_STAT_ADD(stop, 1);
-	priv_timer[lcore_id].updated = 1;
+	if (prev_status.state == RTE_TIMER_RUNNING)
+		priv_timer[lcore_id].updated = 1;
 
-	/* remove it from list */
-	if (prev_status.state == RTE_TIMER_PENDING ||
-	    prev_status.state == RTE_TIMER_RUNNING) {
+	/* remove it from list, locking the list of the lcore it is
+	 * pending on, so that the timer is stopped when we return */
+	if (prev_status.state == RTE_TIMER_PENDING) {
 		timer_del(tim, prev_status.owner, 0);
 		__TIMER_STAT_ADD(pending, -1);
 	}
@@ -388,7 +684,10 @@ rte_timer_stop(struct rte_timer *tim)
 void
 rte_timer_stop_sync(struct rte_timer *tim)
 {
-	while (rte_timer_stop(tim) != 0);
+	uint64_t start = timer_get_cycles();
+
+	while (rte_timer_stop(tim) != 0)
+		timer_sync_retry(start);
 }
 
 /* Test the PENDING status of the timer handle tim */
@@ -398,92 +697,267 @@ rte_timer_pending(struct rte_timer *tim)
 	return tim->status.state == RTE_TIMER_PENDING;
 }
 
-/* must be called periodically, run all timer that expired */
-void rte_timer_manage(void)
+/*
+ * Put back in the skiplist the timers of the expired list tim that
+ * were not run by rte_timer_manage_budget(). The timers are in RUNNING
+ * state and none of their callbacks ran, so nobody could modify them or
+ * their links, not even the callbacks run before. They are inserted
+ * before the pending timers that have the same expiration time, in
+ * reverse order, so that they are run first.
+ */
+static void
+timer_requeue(struct rte_timer *tim, unsigned lcore_id)
+{
+	struct priv_timer *priv = &priv_timer[lcore_id];
+	struct rte_timer *prev[RTE_TIMER_SKIPLIST_DEPTH + 1];
+	struct rte_timer *rev = NULL, *next_tim;
+	union rte_timer_status status;
+	unsigned lvl, tim_level;
+
+	/* reverse the list */
+	for ( ; tim != NULL; tim = next_tim) {
+		next_tim = tim->sl_next[0];
+		tim->sl_next[0] = rev;
+		rev = tim;
+	}
+
+	rte_spinlock_lock(&priv->list_lock);
+	for (tim = rev; tim != NULL; tim = next_tim) {
+		next_tim = tim->sl_next[0];
+
+		/* safety net, as for the timers that are run */
+		status.u32 = tim->status.u32;
+		if (unlikely(status.state != RTE_TIMER_RUNNING ||
+			     (unsigned)status.owner != lcore_id))
+			continue;
+
+		timer_get_prev_entries(tim->expire - 1, lcore_id, prev);
+		tim_level = timer_get_skiplist_level(priv->curr_skiplist_depth);
+		if (tim_level == priv->curr_skiplist_depth)
+			priv->curr_skiplist_depth++;
+
+		for (lvl = 0; lvl <= tim_level; lvl++) {
+			tim->sl_next[lvl] = prev[lvl]->sl_next[lvl];
+			prev[lvl]->sl_next[lvl] = tim;
+		}
+
+		status.state = RTE_TIMER_PENDING;
+		status.owner = (int16_t)lcore_id;
+		rte_wmb();
+		tim->status.u32 = status.u32;
+	}
+	priv->pending_head.expire = (priv->pending_head.sl_next[0] == NULL) ?
+		0 : priv->pending_head.sl_next[0]->expire;
+	rte_spinlock_unlock(&priv->list_lock);
+}
+
+/* run at most max_timers expired timers, during at most max_cycles */
+unsigned
+rte_timer_manage_budget(unsigned max_timers, uint64_t max_cycles)
 {
 	union rte_timer_status status;
-	struct rte_timer *tim, *tim2;
+	struct rte_timer *tim, *next_tim;
+	struct rte_timer *run_first_tim, **pprev;
 	unsigned lcore_id = rte_lcore_id();
-	uint64_t cur_time;
-	int ret;
+	struct priv_timer *priv = &priv_timer[lcore_id];
+	struct rte_timer *prev[RTE_TIMER_SKIPLIST_DEPTH + 1];
+	uint64_t cur_time, start_tsc, cb_tsc, now;
+	unsigned n = 0;
+	int i, ret;
+
+	/* add or remove the timers posted by other lcores */
+	if (priv->req_head != NULL)
+		timer_process_requests(lcore_id);
 
 	/* optimize for the case where per-cpu list is empty */
-	if (LIST_EMPTY(&priv_timer[lcore_id].pending))
-		return;
+	if (priv->pending_head.expire == 0)
+		return 0;
 
-	cur_time = rte_get_hpet_cycles();
+	cur_time = timer_get_cycles();
 	__TIMER_STAT_ADD(manage, 1);
 
-	/* browse ordered list, add expired timers in 'expired' list */
-	rte_spinlock_lock(&priv_timer[lcore_id].list_lock);
+	/* nothing expired yet */
+	if ((int64_t)(cur_time - priv->pending_head.expire) < 0)
+		return 0;
 
-	LIST_FOREACH_SAFE(tim, tim2, &priv_timer[lcore_id].pending, next) {
-		if ((int64_t)(cur_time - tim->expire) < 0)
-			break;
+	if (max_timers == 0)
+		max_timers = UINT32_MAX;
+	start_tsc = rte_rdtsc();
+
+	rte_spinlock_lock(&priv->list_lock);
+
+	/* if nothing to do just unlock and return */
+	if (priv->pending_head.sl_next[0] == NULL ||
+	    priv->pending_head.sl_next[0]->expire > cur_time) {
+		rte_spinlock_unlock(&priv->list_lock);
+		return 0;
+	}
+
+	/* browse the first max_timers expired timers, and remember for
+	 * each level the last of them that is present in this level */
+	for (i = 0; i < (int)priv->curr_skiplist_depth; i++)
+		prev[i] = &priv->pending_head;
+	for (tim = priv->pending_head.sl_next[0];
+	     tim != NULL && tim->expire <= cur_time && n < max_timers;
+	     tim = tim->sl_next[0], n++) {
+		for (i = 0; i < (int)priv->curr_skiplist_depth &&
+			     prev[i]->sl_next[i] == tim; i++)
+			prev[i] = tim;
+	}
 
-		LIST_REMOVE(tim, next);
-		LIST_INSERT_HEAD(&priv_timer[lcore_id].expired, tim, next);
+	/* save start of list of expired timers */
+	tim = priv->pending_head.sl_next[0];
+
+	/* break the existing list after these timers */
+	for (i = priv->curr_skiplist_depth - 1; i >= 0; i--) {
+		if (prev[i] == &priv->pending_head)
+			continue;
+		priv->pending_head.sl_next[i] = prev[i]->sl_next[i];
+		if (prev[i]->sl_next[i] == NULL)
+			priv->curr_skiplist_depth--;
+		prev[i]->sl_next[i] = NULL;
 	}
 
+	/* transition run-list from PENDING to RUNNING */
+	run_first_tim = tim;
+	pprev = &run_first_tim;
+
+	for ( ; tim != NULL; tim = next_tim) {
+		next_tim = tim->sl_next[0];
 
-	/* for each timer of 'expired' list, check state and execute callback */
-	while ((tim = LIST_FIRST(&priv_timer[lcore_id].expired)) != NULL) {
 		ret = timer_set_running_state(tim);
+		if (likely(ret == 0)) {
+			pprev = &tim->sl_next[0];
+		} else {
+			/* another core is trying to re-config this one,
+			 * remove it from local expired list */
+			*pprev = next_tim;
+		}
+	}
+
+	/* update the next to expire timer value */
+	priv->pending_head.expire = (priv->pending_head.sl_next[0] == NULL) ?
+		0 : priv->pending_head.sl_next[0]->expire;
 
-		/* remove from expired list, and add it in done list */
-		LIST_REMOVE(tim, next);
-		LIST_INSERT_HEAD(&priv_timer[lcore_id].done, tim, next);
+	rte_spinlock_unlock(&priv->list_lock);
 
-		/* this timer was not pending, continue */
-		if (ret < 0)
+	/* now scan expired list and call callbacks */
+	n = 0;
+	for (tim = run_first_tim; tim != NULL; tim = next_tim) {
+		cb_tsc = rte_rdtsc();
+
+		/* out of time, give back the remaining timers, which
+		 * callbacks could not reconfigure, see running_tim */
+		if (max_cycles != 0 && n != 0 &&
+		    cb_tsc - start_tsc >= max_cycles) {
+			priv->running_tim = NULL;
+			timer_requeue(tim, lcore_id);
+			break;
+		}
+
+		next_tim = tim->sl_next[0];
+
+		/* only this core may change an expired timer before its
+		 * callback is run, so this is only a safety net */
+		status.u32 = tim->status.u32;
+		if (unlikely(status.state != RTE_TIMER_RUNNING ||
+			     (unsigned)status.owner != lcore_id))
 			continue;
 
-		rte_spinlock_unlock(&priv_timer[lcore_id].list_lock);
+		priv->updated = 0;
+		priv->running_tim = tim;
+		n++;
 
-		priv_timer[lcore_id].updated = 0;
+		/* account the lateness of the timer, in the unit of its
+		 * expiration time */
+		now = timer_get_cycles();
+		rte_histogram_add(&priv->latency.lateness,
+				  (int64_t)(now - tim->expire) > 0 ?
+				  now - tim->expire : 0);
 
 		/* execute callback function with list unlocked */
 		tim->f(tim, tim->arg);
+		rte_histogram_add(&priv->latency.callback,
+				  rte_rdtsc() - cb_tsc);
 
-		rte_spinlock_lock(&priv_timer[lcore_id].list_lock);
-
+		__TIMER_STAT_ADD(pending, -1);
 		/* the timer was stopped or reloaded by the callback
 		 * function, we have nothing to do here */
-		if (priv_timer[lcore_id].updated == 1)
+		if (priv->updated == 1)
 			continue;
 
 		if (tim->period == 0) {
-			/* remove from done list and mark timer as stopped */
-			LIST_REMOVE(tim, next);
-			__TIMER_STAT_ADD(pending, -1);
+			/* mark timer as stopped */
 			status.state = RTE_TIMER_STOP;
 			status.owner = RTE_TIMER_NO_OWNER;
 			rte_wmb();
 			tim->status.u32 = status.u32;
 		}
 		else {
-			/* keep it in done list and mark timer as pending */
-			status.state = RTE_TIMER_PENDING;
-			status.owner = (int16_t)lcore_id;
-			rte_wmb();
-			tim->status.u32 = status.u32;
+			/* reschedule it on this core: it is in RUNNING
+			 * state, so only us can modify it */
+			rte_spinlock_lock(&priv->list_lock);
+			__rte_timer_reset(tim, cur_time + tim->period,
+					  tim->period, lcore_id, tim->f,
+					  tim->arg, 1);
+			rte_spinlock_unlock(&priv->list_lock);
 		}
 	}
 
-	/* finally, browse done list, some timer may have to be
-	 * rescheduled automatically */
-	LIST_FOREACH_SAFE(tim, tim2, &priv_timer[lcore_id].done, next) {
+	priv->running_tim = NULL;
+
+	rte_histogram_add(&priv->latency.manage, rte_rdtsc() - start_tsc);
+	return n;
+}
+
+/* must be called periodically, run all timer that expired */
+void rte_timer_manage(void)
+{
+	rte_timer_manage_budget(0, 0);
+}
+
+/* get the latency statistics of an lcore */
+int
+rte_timer_get_latency_stats(unsigned lcore_id,
+			    struct rte_timer_latency_stats *stats)
+{
+	if (lcore_id >= RTE_MAX_LCORE)
+		return -1;
 
-		/* reset may fail if timer is beeing modified, in this
-		 * case the timer will remain in 'done' list until the
-		 * core that is modifying it remove it */
-		__rte_timer_reset(tim, cur_time + tim->period,
-				  tim->period, lcore_id, tim->f,
-				  tim->arg, 1);
+	*stats = priv_timer[lcore_id].latency;
+	return 0;
+}
+
+/* dump latency histograms of timers and alarms */
+static void
+timer_dump_latency(void)
+{
+	struct rte_timer_latency_stats *latency;
+	struct rte_eal_alarm_stats alarm_stats;
+	unsigned lcore_id;
+
+	printf("Timer latency (timer hz=%"PRIu64", tsc hz=%"PRIu64"):\n",
+	       rte_timer_get_hz(), rte_get_tsc_hz());
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		latency = &priv_timer[lcore_id].latency;
+		if (latency->manage.count == 0)
+			continue;
+		printf("lcore %u:\n", lcore_id);
+		rte_histogram_dump("expiry lateness", "timer cycles",
+				   &latency->lateness);
+		rte_histogram_dump("callback duration", "cycles",
+				   &latency->callback);
+		rte_histogram_dump("manage duration", "cycles",
+				   &latency->manage);
 	}
 
-	/* job finished, unlock the list lock */
-	rte_spinlock_unlock(&priv_timer[lcore_id].list_lock);
+	rte_eal_alarm_get_stats(&alarm_stats);
+	if (alarm_stats.callback.count == 0)
+		return;
+	printf("Alarm latency:\n");
+	rte_histogram_dump("expiry lateness", "us", &alarm_stats.lateness);
+	rte_histogram_dump("callback duration", "cycles",
+			   &alarm_stats.callback);
 }
 
 /* dump statistics about timers */
@@ -508,4 +982,6 @@ void rte_timer_dump_stats(void)
 #else
 	printf("No timer statistics, RTE_LIBRTE_TIMER_DEBUG is disabled\n");
 #endif
+
+	timer_dump_latency();
 }
@@ -68,6 +68,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <sys/queue.h>
+#include <rte_histogram.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -88,6 +89,15 @@ enum rte_timer_type {
 	PERIODICAL
 };
 
+/**
+ * Time reference used to schedule the timers.
+ */
+enum rte_timer_source {
+	RTE_TIMER_SOURCE_AUTO, /**< TSC if invariant, else HPET. */
+	RTE_TIMER_SOURCE_TSC,  /**< TSC, read with rte_rdtsc(). */
+	RTE_TIMER_SOURCE_HPET  /**< HPET, read with rte_get_hpet_cycles(). */
+};
+
 /**
  * Timer status: A union of the state (stopped, pending, running,
  * config) and an owner (the id of the lcore that owns the timer).
@@ -112,6 +122,29 @@ struct rte_timer_debug_stats {
 };
 #endif
 
+/**
+ * Latency statistics of the timers of an lcore, always collected.
+ */
+struct rte_timer_latency_stats {
+	/** Delay between the expiration time of a timer and the call of
+	 *  its callback, in cycles of the time source (see
+	 *  rte_timer_get_hz()). */
+	struct rte_histogram lateness;
+	/** Duration of the callbacks, in TSC cycles. */
+	struct rte_histogram callback;
+	/** Duration of the rte_timer_manage() calls that ran timers, in
+	 *  TSC cycles. The calls finding no expired timer are not
+	 *  accounted. */
+	struct rte_histogram manage;
+};
+
+/**
+ * Maximum number of levels of the skiplist holding the pending timers
+ * of an lcore. With a level ratio of 1/4, this is enough to keep the
+ * lookups logarithmic up to about a million pending timers per lcore.
+ */
+#define RTE_TIMER_SKIPLIST_DEPTH 10
+
 struct rte_timer;
 
 /**
@@ -124,12 +157,18 @@ typedef void (rte_timer_cb_t)(struct rte_timer *, void *);
  */
 struct rte_timer
 {
-	LIST_ENTRY(rte_timer) next;    /**< Next and prev in list. */
+	uint64_t expire;       /**< Time when timer expire. */
+	/** Next timer on each level of the skiplist. */
+	struct rte_timer *sl_next[RTE_TIMER_SKIPLIST_DEPTH];
 	volatile union rte_timer_status status; /**< Status of timer. */
 	uint64_t period;       /**< Period of timer (0 if not periodic). */
-	uint64_t expire;       /**< Time when timer expire. */
 	rte_timer_cb_t *f;     /**< Callback function. */
 	void *arg;             /**< Argument to callback function. */
+	/** Next timer in the request queue of an lcore. */
+	struct rte_timer *req_next;
+	uint64_t req_expire;   /**< Expire time of a posted reset. */
+	int16_t req_lcore;     /**< Target lcore of a posted reset. */
+	uint16_t req_unlink;   /**< Posted timer is pending on the lcore. */
 };
 
 
@@ -138,9 +177,9 @@ struct rte_timer
  * A C++ static initializer for a timer structure.
  */
 #define RTE_TIMER_INITIALIZER {                 \
-	{0, 0},                                 \
-	{{RTE_TIMER_STOP, RTE_TIMER_NO_OWNER}}, \
 	0,                                      \
+	{NULL},                                 \
+	{{RTE_TIMER_STOP, RTE_TIMER_NO_OWNER}}, \
 	0,                                      \
 	NULL,                                   \
 	NULL,                                   \
@@ -161,10 +200,56 @@ struct rte_timer
  * Initialize the timer library.
  *
  * Initializes internal variables (list, locks and so on) for the RTE
- * timer library.
+ * timer library. The time source is set to RTE_TIMER_SOURCE_AUTO.
  */
 void rte_timer_subsystem_init(void);
 
+/**
+ * Select the time reference of the timer library.
+ *
+ * Reading the TSC costs a few cycles while reading HPET is an uncached
+ * MMIO access, so the TSC is preferred when it runs at a constant rate
+ * on all cores. The source can only be changed when no timer is
+ * pending, typically just after rte_timer_subsystem_init(). If HPET is
+ * not available, RTE_TIMER_SOURCE_HPET falls back to the TSC like
+ * rte_get_hpet_cycles() does.
+ *
+ * @param source
+ *   The time source to use; RTE_TIMER_SOURCE_AUTO selects the TSC if
+ *   rte_tsc_is_invariant() is true, else HPET.
+ * @return
+ *   - 0: Success.
+ *   - (-1): Invalid source, or some timers are pending.
+ */
+int rte_timer_set_source(enum rte_timer_source source);
+
+/**
+ * Get the time reference of the timer library.
+ *
+ * @return
+ *   RTE_TIMER_SOURCE_TSC or RTE_TIMER_SOURCE_HPET.
+ */
+enum rte_timer_source rte_timer_get_source(void);
+
+/**
+ * Get the number of cycles of the timer time source in one second.
+ *
+ * The timer ticks given to rte_timer_reset() must be computed from
+ * this value.
+ *
+ * @return
+ *   The number of cycles in one second.
+ */
+uint64_t rte_timer_get_hz(void);
+
+/**
+ * Get the current value of the timer time source.
+ *
+ * @return
+ *   The number of cycles since an unspecified starting point.
+ */
+uint64_t rte_timer_get_cycles(void);
+
 /**
  * Initialize a timer handle.
  *
@@ -182,7 +267,7 @@ void rte_timer_init(struct rte_timer *tim);
  *
  * The rte_timer_reset() function resets and starts the timer
  * associated with the timer handle *tim*. When the timer expires after
- * *ticks* HPET cycles, the function specified by *fct* will be called
+ * *ticks* cycles of the time source, the function specified by *fct* will be called
  * with the argument *arg* on core *tim_lcore*.
  *
  * If the timer associated with the timer handle is already running
@@ -193,13 +278,24 @@ void rte_timer_init(struct rte_timer *tim);
  * If the timer is being configured on another core (the CONFIG state),
  * it will also fail.
  *
+ * From a timer callback, only this timer can be reset among the timers
+ * of the lcore: the other timers expired in the same call to
+ * rte_timer_manage() are in the RUNNING state until their own callback
+ * has run, so the function fails on them.
+ *
  * If the timer is pending or stopped, it will be rescheduled with the
  * new parameters.
  *
+ * If the timer has to be removed from or added to the list of another
+ * lcore, the request is posted to a lock-free queue of this lcore, so
+ * that its list lock is not taken, and is processed at the beginning of
+ * its next call to rte_timer_manage(). Until then, the timer is in the
+ * CONFIG state.
+ *
  * @param tim
  *   The timer handle.
  * @param ticks
- *   The number of cycles (see rte_get_hpet_hz()) before the callback
+ *   The number of cycles (see rte_timer_get_hz()) before the callback
  *   function is called.
  * @param type
  *   The type can be either:
@@ -233,7 +329,7 @@ int rte_timer_reset(struct rte_timer *tim, uint64_t ticks,
  * @param tim
  *   The timer handle.
  * @param ticks
- *   The number of cycles (see rte_get_hpet_hz()) before the callback
+ *   The number of cycles (see rte_timer_get_hz()) before the callback
  *   function is called.
  * @param type
  *   The type can be either:
@@ -270,7 +366,9 @@ rte_timer_reset_sync(struct rte_timer *tim, uint64_t ticks,
  * This function can be called safely from a timer callback. If it
  * succeeds, the timer is not referenced anymore by the timer library
  * and the timer structure can be freed (even in the callback
- * function).
+ * function). From a callback, it fails on the other timers of the lcore
+ * expired in the same call to rte_timer_manage(), see rte_timer_reset(),
+ * so rte_timer_stop_sync() must not be used on them.
  *
  * @param tim
  *   The timer handle.
@@ -287,6 +385,10 @@ int rte_timer_stop(struct rte_timer *tim);
  * After a call to this function, the timer identified by *tim* is
  * stopped. See rte_timer_stop() for details.
  *
+ * If a reset of the timer is still posted to an lcore that does not
+ * call rte_timer_manage(), the request is processed by the calling
+ * lcore after a short wait, so the function does not wait forever.
+ *
  * @param tim
  *   The timer handle.
  */
@@ -320,8 +422,51 @@ int rte_timer_pending(struct rte_timer *tim);
  */
 void rte_timer_manage(void);
 
+/**
+ * Manage the timer list and execute callback functions, with a bounded
+ * amount of work.
+ *
+ * This function is like rte_timer_manage(), but it runs at most
+ * *max_timers* expired timers, and it stops running callbacks once
+ * *max_cycles* TSC cycles have been spent in callbacks. The expired
+ * timers that are not run stay pending and are run first by the next
+ * call, in expiration order. This allows a main loop to interleave
+ * timer processing with packet processing when many timers expire at
+ * the same time.
+ *
+ * As the time is only checked between two callbacks, a call can exceed
+ * *max_cycles* by the duration of one callback.
+ *
+ * @param max_timers
+ *   The maximum number of timers to run, or 0 for no limit.
+ * @param max_cycles
+ *   The maximum number of TSC cycles to spend in callbacks, or 0 for no
+ *   limit.
+ * @return
+ *   The number of expired timers that were run.
+ */
+unsigned rte_timer_manage_budget(unsigned max_timers, uint64_t max_cycles);
+
+/**
+ * Get the latency statistics of the timers of an lcore.
+ *
+ * @param lcore_id
+ *   The lcore.
+ * @param stats
+ *   The structure to fill.
+ * @return
+ *   - 0: Success.
+ *   - (-1): Invalid lcore identifier.
+ */
+int rte_timer_get_latency_stats(unsigned lcore_id,
+				struct rte_timer_latency_stats *stats);
+
 /**
  * Dump statistics about timers.
+ *
+ * The debug statistics are displayed if RTE_LIBRTE_TIMER_DEBUG is
+ * enabled, followed by the latency histograms of the timers of each
+ * lcore and of the EAL alarms.
  */
 void rte_timer_dump_stats(void);
 
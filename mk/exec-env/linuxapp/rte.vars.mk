@@ -50,6 +50,6 @@ EXECENV_ASFLAGS =
 LINK_USING_CC := 1
 
 # Add library to the group to resolve symbols
-EXECENV_LDLIBS = -ldl
+EXECENV_LDLIBS = -ldl -lrt
 
 export EXECENV_CFLAGS EXECENV_LDFLAGS EXECENV_ASFLAGS EXECENV_LDLIBS